@@ -21,6 +21,7 @@
 LIBVSQ_BEGIN_NAMESPACE
 
 class TextStream;
+class MetaTextLexer;
 
 /**
  * @brief コントロールカーブのデータ点リストを表すクラス.
@@ -229,6 +230,13 @@ public:
 	 */
 	tick_t keyTickAt(int index) const;
 
+	/**
+	 * @brief 指定された時刻以降にある最初のデータ点のインデックスを, 二分探索で取得する.
+	 * @param tick Tick 単位の時刻.
+	 * @return データ点のインデックス. 該当するデータ点が無い場合は size() の値を返す.
+	 */
+	int lowerBound(tick_t tick) const;
+
 	/**
 	 * @brief 指定された時刻にデータ点が存在するかどうかを調べる.
 	 * @param tick Tick 単位の時刻.
@@ -288,6 +296,30 @@ public:
 	 */
 	std::string appendFromText(TextStream& reader);
 
+	/**
+	 * @brief メタテキストからデータ点を読込み, 現在のリストに追加する. "[" で始まる行に達した時点で読み込みを終える.
+	 * @param lexer 読み込むメタテキスト. 読み込みを終えた時点で, 最後に読み込んだ行を指す.
+	 */
+	void appendFromText(MetaTextLexer& lexer);
+
+	/**
+	 * @brief 並べ替え, 既存の値との重複チェックを行わず, リストの末尾にデータ点を追加する.
+	 * @details 追加後のリストが時刻順に並び, 時刻が重複しないことは, 呼び出し側が保証しなければならない.
+	 * @param tick Tick 単位の時刻.
+	 * @param value データ点の値.
+	 */
+	void addWithoutSort(tick_t tick, int value);
+
+	/**
+	 * @brief メタテキストの "tick=value" 形式の行から, データ点を読み取る. 数字, "-", "=" 以外の文字は無視する.
+	 * @param begin 行の先頭.
+	 * @param end 行の末尾の次.
+	 * @param[out] tick Tick 単位の時刻.
+	 * @param[out] value データ点の値.
+	 * @return 行に "=" が含まれず, データ点が読み取れなかった場合は <code>false</code> を返す.
+	 */
+	static bool parsePoint(char const* begin, char const* end, tick_t& tick, int& value);
+
 	/**
 	 * @brief データ点の個数を返す.
 	 * @return データ点の個数.
@@ -354,13 +386,6 @@ private:
 	 * @return データ点のインデックス(最初のインデックスは0). データ点が見つからなかった場合は負の値を返す.
 	 */
 	int _find(tick_t value) const;
-
-	/**
-	 * @brief 並べ替え, 既存の値との重複チェックを行わず, リストの末尾にデータ点を追加する.
-	 * @param tick Tick 単位の時刻.
-	 * @param value データ点の値.
-	 */
-	void addWithoutSort(tick_t tick, int value);
 };
 
 LIBVSQ_END_NAMESPACE
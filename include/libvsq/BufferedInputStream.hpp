@@ -0,0 +1,144 @@
+﻿/**
+ * @file BufferedInputStream.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./Namespace.hpp"
+#include "./InputStream.hpp"
+#include <vector>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+/**
+ * @brief 別の InputStream からまとめて先読みし, バッファーから読み込むアダプター.
+ * @details 読み込み元のストリームは先読みした分だけ先に進むが, このオブジェクトの破棄時に, 実際に読み込んだ位置まで戻される.
+ */
+class BufferedInputStream final : public InputStream
+{
+public:
+	/**
+	 * @brief デフォルトのバッファーの長さ(バイト単位).
+	 */
+	static const int DEFAULT_BUFFER_LENGTH = 64 * 1024;
+
+private:
+	/**
+	 * @brief 読み込み元のストリーム.
+	 */
+	InputStream& _stream;
+
+	/**
+	 * @brief バッファー.
+	 */
+	std::vector<char> _buffer;
+
+	/**
+	 * @brief バッファーの先頭に対応する, 読み込み元のストリーム上の位置.
+	 */
+	int64_t _start;
+
+	/**
+	 * @brief バッファー内の読み込み位置.
+	 */
+	size_t _index;
+
+	/**
+	 * @brief バッファーに先読みされているバイト数.
+	 */
+	size_t _count;
+
+public:
+	/**
+	 * @brief 読み込み元のストリームを指定して初期化する.
+	 * @param stream 読み込み元のストリーム. このオブジェクトより長く存在していなければならない.
+	 * @param bufferLength バッファーの長さ(バイト単位).
+	 */
+	explicit BufferedInputStream(InputStream& stream, int bufferLength = DEFAULT_BUFFER_LENGTH);
+
+	/**
+	 * @brief 読み込み元のストリームの位置を, 実際に読み込んだ位置まで戻す. 読み込み元のストリームは閉じない.
+	 */
+	~BufferedInputStream();
+
+	BufferedInputStream(BufferedInputStream const&) = delete;
+
+	BufferedInputStream& operator = (BufferedInputStream const&) = delete;
+
+	/**
+	 * @brief 1 バイトを読み込む.
+	 * @details バッファーにデータが残っていれば, 読み込み元のストリームを呼び出さずにバッファーから読み込む.
+	 * @return 読み込んだバイト値. ストリームの末尾に達した場合は負の値を返す.
+	 */
+	int read() override
+	{
+		if (_index < _count) {
+			return 0xff & _buffer[_index++];
+		}
+		if (!fill()) {
+			return -1;
+		}
+		return 0xff & _buffer[_index++];
+	}
+
+	/**
+	 * @brief バッファーに読み込む.
+	 * @details バッファーの長さ以上の読み込みは, バッファーを経由せずに直接読み込み元のストリームから読み込む.
+	 * @param buffer 読み込んだデータを格納するバッファー.
+	 * @param startIndex 読み込んだデータを格納するオフセット.
+	 * @param length 読み込む長さ.
+	 * @return 読み込んだ長さ.
+	 */
+	size_t read(char* buffer, int64_t startIndex, int64_t length) override;
+
+	/**
+	 * @brief ファイルポインターを移動する.
+	 * @details 先読み済みの範囲内への移動であれば, 読み込み元のストリームを呼び出さない.
+	 * @param position ファイルポインター.
+	 */
+	void seek(int64_t position) override;
+
+	/**
+	 * @brief ファイルポインターを取得する.
+	 * @return ファイルポインター.
+	 */
+	int64_t getPointer() override
+	{
+		return _start + _index;
+	}
+
+	/**
+	 * @brief 読み込み元のストリームを閉じる.
+	 */
+	void close() override;
+
+	/**
+	 * @brief 読み込み元のストリームの data を返す.
+	 * @return 読み込み元のストリームの内容の先頭アドレス.
+	 */
+	uint8_t const* data() const override;
+
+	/**
+	 * @brief 読み込み元のストリームの length を返す.
+	 * @return 読み込み元のストリームの内容の長さ.
+	 */
+	int64_t length() const override;
+
+private:
+	/**
+	 * @brief 現在の位置からバッファーに先読みする.
+	 * @return 1 バイト以上読み込めた場合は <code>true</code> を返す.
+	 */
+	bool fill();
+};
+
+LIBVSQ_END_NAMESPACE
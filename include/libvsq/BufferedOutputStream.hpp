@@ -0,0 +1,132 @@
+﻿/**
+ * @file BufferedOutputStream.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./BasicTypes.hpp"
+#include "./OutputStream.hpp"
+#include <vector>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+/**
+ * @brief 書き込みをバッファリングして, 別の OutputStream にまとめて書き出すアダプター.
+ * @details バッファーに収まる範囲内への seek はバッファー上で処理するため, チャンクのデータ長を後から書き戻す処理でもフラッシュは発生しない.
+ *          出力先のストリームは, flush または close を呼ぶまで書き込まれない.
+ */
+class BufferedOutputStream final : public OutputStream
+{
+public:
+	/**
+	 * @brief デフォルトのバッファーの長さ(バイト単位).
+	 */
+	static const int DEFAULT_BUFFER_LENGTH = 64 * 1024;
+
+private:
+	/**
+	 * @brief 出力先のストリーム.
+	 */
+	OutputStream& _stream;
+
+	/**
+	 * @brief バッファー.
+	 */
+	std::vector<char> _buffer;
+
+	/**
+	 * @brief バッファーの先頭に対応する, 出力先のストリーム上の位置.
+	 */
+	int64_t _start;
+
+	/**
+	 * @brief バッファー内の書き込み位置.
+	 */
+	size_t _cursor;
+
+	/**
+	 * @brief バッファー内の書き込み済みバイト数.
+	 */
+	size_t _count;
+
+public:
+	/**
+	 * @brief 出力先のストリームを指定して初期化する.
+	 * @param stream 出力先のストリーム. このオブジェクトより長く存在していなければならない.
+	 * @param bufferLength バッファーの長さ(バイト単位).
+	 */
+	explicit BufferedOutputStream(OutputStream& stream, int bufferLength = DEFAULT_BUFFER_LENGTH);
+
+	/**
+	 * @brief バッファーを破棄する. バッファーに残っているデータは出力先のストリームに書き出さないので, 先に flush または close を呼ぶこと.
+	 * @details 書き込み中に例外が発生した場合に, 書きかけのデータを出力先に渡さないようにするため.
+	 */
+	~BufferedOutputStream();
+
+	BufferedOutputStream(BufferedOutputStream const&) = delete;
+
+	BufferedOutputStream& operator = (BufferedOutputStream const&) = delete;
+
+	/**
+	 * @brief 1 バイト書き込む.
+	 * @details バッファーに空きがあれば, 出力先のストリームを呼び出さずにバッファーに書き込む.
+	 * @param value 書き込む値.
+	 */
+	void write(int value) override
+	{
+		if (_cursor < _buffer.size()) {
+			_buffer[_cursor++] = static_cast<char>(0xff & value);
+			if (_count < _cursor) {
+				_count = _cursor;
+			}
+		} else {
+			flush();
+			write(value);
+		}
+	}
+
+	/**
+	 * @brief バッファーを書き込む.
+	 * @details バッファーの長さ以上のデータは, バッファーを経由せずに直接出力先のストリームに書き込む.
+	 * @param buffer 書き込むバッファー.
+	 * @param startIndex 書き込みを開始するインデックス.
+	 * @param length 書き込む長さ.
+	 */
+	void write(char const* buffer, int64_t startIndex, int64_t length) override;
+
+	/**
+	 * @brief ポインターを移動する.
+	 * @param position ポインターの位置. ファイル先頭からの位置を指定する.
+	 */
+	void seek(int64_t position) override;
+
+	/**
+	 * @brief ファイルポインターを取得する.
+	 * @return ファイルポインター.
+	 */
+	int64_t getPointer() override
+	{
+		return _start + _cursor;
+	}
+
+	/**
+	 * @brief バッファーの内容を書き出した後, 出力先のストリームを閉じる.
+	 */
+	void close() override;
+
+	/**
+	 * @brief バッファーの内容を出力先のストリームに書き出す.
+	 */
+	void flush();
+};
+
+LIBVSQ_END_NAMESPACE
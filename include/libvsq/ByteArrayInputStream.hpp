@@ -0,0 +1,101 @@
+﻿/**
+ * @file ByteArrayInputStream.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./Namespace.hpp"
+#include "./InputStream.hpp"
+
+LIBVSQ_BEGIN_NAMESPACE
+
+/**
+ * @brief メモリ上のバイト列から読み込む InputStream の実装.
+ * @details バイト列はコピーせずに参照する. バイト列は呼び出し側が所有し, ストリームを使い終わるまで解放してはならない.
+ */
+class ByteArrayInputStream : public InputStream
+{
+private:
+	/**
+	 * @brief 読み込み元のバイト列.
+	 */
+	uint8_t const* _data;
+
+	/**
+	 * @brief バイト列の長さ.
+	 */
+	int64_t _length;
+
+	/**
+	 * @brief 現在のファイルポインター.
+	 */
+	int64_t _pointer;
+
+public:
+	/**
+	 * @brief 読み込み元のバイト列を指定して初期化する.
+	 * @param data 読み込み元のバイト列.
+	 * @param length バイト列の長さ.
+	 */
+	ByteArrayInputStream(uint8_t const* data, int64_t length);
+
+	/**
+	 * @copydoc ByteArrayInputStream::ByteArrayInputStream(uint8_t const*, int64_t)
+	 */
+	ByteArrayInputStream(char const* data, int64_t length);
+
+	/**
+	 * @brief 1 バイトを読み込む.
+	 * @return 読み込んだバイト値. ストリームの末尾に達した場合は負の値を返す.
+	 */
+	int read() override;
+
+	/**
+	 * @brief バッファーに読み込む.
+	 * @param buffer 読み込んだデータを格納するバッファー.
+	 * @param startIndex 読み込んだデータを格納するオフセット.
+	 * @param length 読み込む長さ.
+	 * @return 読み込んだ長さ.
+	 */
+	size_t read(char* buffer, int64_t startIndex, int64_t length) override;
+
+	/**
+	 * @brief ファイルポインターを移動する.
+	 * @param position ファイルポインター.
+	 */
+	void seek(int64_t position) override;
+
+	/**
+	 * @brief ファイルポインターを取得する.
+	 * @return ファイルポインター.
+	 */
+	int64_t getPointer() override;
+
+	/**
+	 * @brief ストリームを閉じる. バイト列への参照を解除する.
+	 */
+	void close() override;
+
+	/**
+	 * @brief 読み込み元のバイト列の先頭アドレスを取得する.
+	 * @return 先頭アドレス. 閉じられている場合は nullptr を返す.
+	 */
+	uint8_t const* data() const override;
+
+	/**
+	 * @brief 読み込み元のバイト列の長さを取得する.
+	 * @return バイト列の長さ.
+	 */
+	int64_t length() const override;
+};
+
+LIBVSQ_END_NAMESPACE
@@ -34,20 +34,10 @@ private:
 	int64_t _pointer;
 
 	/**
-	 * @brief 書き込み先のバイト列.
+	 * @brief 書き込み先のバイト列. 長さは書き込み済みバイト数と等しく, 確保済みの領域は capacity で管理する.
 	 */
 	std::vector<char> _array;
 
-	/**
-	 * @brief 確保されたバイト列の現在の長さ.
-	 */
-	int64_t _arrayLength;
-
-	/**
-	 * @brief 書き込み済みバイト数.
-	 */
-	int64_t _length;
-
 LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	/**
 	 * @brief 確保するバッファー・ブロックのサイズ(バイト単位).
@@ -82,6 +72,20 @@ public:
 	 */
 	std::string toString() const;
 
+	/**
+	 * @brief 書き込み済みのバイト列を, コピーせずに取り出す.
+	 * @details 取り出した後のストリームは, 初期化直後と同じ空の状態になる.
+	 * @return 書き込み済みのバイト列.
+	 */
+	std::vector<char> release();
+
+	/**
+	 * @brief 少なくとも指定した長さまで書き込めるよう, あらかじめバッファーを確保する.
+	 * @details 書き込むデータのおおよその長さが分かっている場合に呼ぶことで, 書き込み中の再確保を避けられる.
+	 * @param capacity 確保するバッファーの長さ.
+	 */
+	void reserve(int64_t capacity);
+
 	/**
 	 * @brief 現在のファイルポインタを取得する.
 	 * @return 現在のファイルポインタ.
@@ -101,10 +105,11 @@ public:
 
 private:
 	/**
-	 * @brief バッファーを指定した長さまで確保する.
-	 * @param length 確保するバッファーの長さ.
+	 * @brief 書き込み済みのバイト列が指定した長さに満たない場合, 0 で埋めて伸ばす.
+	 * @details 書き込み済みの末尾より後ろに seek してから書き込んだ場合に, 間の領域を埋めるために使う.
+	 * @param length 必要な長さ.
 	 */
-	void ensureBufferLength(int64_t length);
+	void extendTo(int64_t length);
 };
 
 LIBVSQ_END_NAMESPACE
@@ -40,6 +40,14 @@ public:
 	 */
 	static std::string convertToUTF8(std::string const& cp932);
 
+	/**
+	 * @brief 改行で区切られた複数行の CP932 のバイト列を, 一括で UTF8 の文字列に変換する.
+	 * @details 各行を convertToUTF8 で変換して改行で連結したものと同じ結果となる.
+	 * @param cp932 変換する CP932 のバイト列.
+	 * @return 変換後の UTF8 文字列.
+	 */
+	static std::string convertLinesToUTF8(std::string const& cp932);
+
 LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	/**
 	 * @brief UTF8 の文字列を unicode のバイト列に変換する.
@@ -65,6 +73,20 @@ private:
 	 * @brief CP932 から UTF8 への変換テーブルを初期化する.
 	 */
 	static void initializeCP932ToUTF8Dictionary(int dict[0xFFFF]);
+
+	/**
+	 * @brief 初期化済みの CP932 から UTF8 への変換テーブルを取得する.
+	 */
+	static int const* _getCP932ToUTF8Dictionary();
+
+	/**
+	 * @brief CP932 のバイト列を UTF8 に変換し, 末尾に追加する.
+	 * @param dict CP932 から UTF8 への変換テーブル.
+	 * @param cp932 変換する CP932 のバイト列.
+	 * @param length バイト列の長さ.
+	 * @param result 変換結果の追加先.
+	 */
+	static void _appendUTF8(int const* dict, char const* cp932, size_t length, std::string& result);
 };
 
 LIBVSQ_END_NAMESPACE
@@ -66,6 +66,19 @@ public:
 		 */
 		List& operator = (List const& list);
 
+		/**
+		 * @brief ムーブコンストラクタ. @a list のイベントを引き継ぐ.
+		 * @param list ムーブ元のリスト.
+		 */
+		List(List&& list) = default;
+
+		/**
+		 * @brief ムーブ演算子. @a list のイベントを引き継ぐ.
+		 * @param list ムーブ元のリスト.
+		 * @return このオブジェクト.
+		 */
+		List& operator = (List&& list) = default;
+
 		~List();
 
 		/**
@@ -89,6 +102,13 @@ public:
 		 */
 		void setForId(int internalId, Event const& value);
 
+		/**
+		 * @brief 指定された時刻以降にある最初のイベントのインデックスを, 二分探索で取得する. イベントは並べ替え済みである必要がある.
+		 * @param tick Tick 単位の時刻.
+		 * @return イベントのインデックス. 該当するイベントが無い場合は size() の値を返す.
+		 */
+		int lowerBound(tick_t tick) const;
+
 		/**
 		 * @brief イベントを並べ替える.
 		 */
@@ -125,6 +145,14 @@ public:
 		 */
 		int add(Event const& item, int internalId);
 
+		/**
+		 * @brief 並べ替えを行わずに, リストの末尾にイベントを追加する.
+		 * @details 追加後のリストが時刻順に並んでいることは, 呼び出し側が保証しなければならない.
+		 * @param item 追加するオブジェクト. ムーブされる.
+		 * @param internalId 追加するオブジェクトに割り振るイベント ID.
+		 */
+		void addWithoutSort(Event&& item, int internalId);
+
 		/**
 		 * @brief イベントを削除する.
 		 * @param index 削除するイベントのインデックス(最初のインデックスは0).
@@ -380,9 +408,17 @@ public:
 	 */
 	Event(tick_t tick, EventType eventType);
 
+	Event(Event const&) = default;
+
+	Event(Event&&) = default;
+
 	virtual ~Event()
 	{}
 
+	Event& operator = (Event const&) = default;
+
+	Event& operator = (Event&&) = default;
+
 	/**
 	 * @brief 長さを取得する.
 	 * @return 長さ.
@@ -163,9 +163,17 @@ public:
 	 */
 	explicit Handle(HandleType type = HandleType::UNKNOWN);
 
+	Handle(Handle const&) = default;
+
+	Handle(Handle&&) = default;
+
 	virtual ~Handle()
 	{}
 
+	Handle& operator = (Handle const&) = default;
+
+	Handle& operator = (Handle&&) = default;
+
 	/**
 	 * @brief articulation の種類を取得する.
 	 * @return articulation の種類.
@@ -0,0 +1,70 @@
+﻿/**
+ * @file IncrementalNrpnGenerator.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./BasicTypes.hpp"
+#include <memory>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+class Track;
+class TempoList;
+class NrpnEventBuffer;
+
+/**
+ * @brief 前回生成した NRPN を再利用しながら, 1 つのトラックの NRPN を差分で生成するクラス.
+ * @details 生成した NRPN を, 生成元のイベントやデータ点の情報とともに記憶しておき, invalidate で通知された範囲に影響を受ける NRPN だけを生成し直して差し替える.
+ *          範囲の直前と直後の音符やデータ点は delay の値や音符の接続関係が変わりうるため, これらも生成し直す.
+ *          生成結果は VocaloidMidiEventListFactory::generateNRPN と同一となる.
+ */
+class IncrementalNrpnGenerator
+{
+public:
+	IncrementalNrpnGenerator();
+
+	~IncrementalNrpnGenerator();
+
+	/**
+	 * @brief 次回の generate で, 全ての NRPN を生成し直すようにする.
+	 */
+	void invalidate();
+
+	/**
+	 * @brief 指定した範囲のイベントまたはデータ点を変更したことを通知する.
+	 * @details イベントやデータ点を移動した場合は, 移動前と移動後の時刻をどちらも通知すること.
+	 *          次回の generate までに複数回呼んだ場合は, 通知された全ての範囲を含む範囲を生成し直す.
+	 * @param startTick Tick 単位の, 変更した範囲の開始時刻.
+	 * @param endTick Tick 単位の, 変更した範囲の終了時刻. この時刻は範囲に含まない.
+	 */
+	void invalidate(tick_t startTick, tick_t endTick);
+
+	/**
+	 * @brief トラックの NRPN を生成する.
+	 * @details 初回の呼び出し時と, テンポ, 音源のバージョン, シーケンスの長さ, プリメジャーの長さ, プリセンドタイムのいずれかが前回と異なる場合は, 全ての NRPN を生成し直す.
+	 *          それ以外の場合は, 前回の呼び出し以降に invalidate で通知された範囲だけを生成し直す.
+	 * @param track 出力元のトラック. 前回の呼び出しと同じトラックを指定すること.
+	 * @param tempoList テンポ情報.
+	 * @param totalTicks Tick 単位のシーケンスの長さ.
+	 * @param preMeasureTicks Tick 単位のプリメジャーの長さ.
+	 * @param msPreSend ミリ秒単位のプリセンドタイム.
+	 * @return 出力順にソートされた NRPN. 次に generate を呼ぶまで有効.
+	 */
+	NrpnEventBuffer const& generate(Track const& track, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> _impl;
+};
+
+LIBVSQ_END_NAMESPACE
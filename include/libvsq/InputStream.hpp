@@ -59,6 +59,26 @@ public:
 	 * @brief ストリームを閉じる.
 	 */
 	virtual void close() = 0;
+
+	/**
+	 * @brief ストリームの内容全体がメモリ上に連続して配置されている場合, その先頭アドレスを取得する.
+	 * @details nullptr 以外を返すストリームでは, read を呼ぶ代わりに getPointer の位置から length までのバイト列を直接参照して読み込み,
+	 *          読み込んだ分だけ seek でファイルポインターを進めればよい.
+	 * @return 先頭アドレス. メモリ上に配置されていない場合は nullptr を返す.
+	 */
+	virtual uint8_t const* data() const
+	{
+		return nullptr;
+	}
+
+	/**
+	 * @brief data が返すバイト列の長さを取得する.
+	 * @return バイト列の長さ. data が nullptr を返す場合は 0 を返す.
+	 */
+	virtual int64_t length() const
+	{
+		return 0;
+	}
 };
 
 LIBVSQ_END_NAMESPACE
@@ -26,7 +26,6 @@ class VSQFileReader;
  */
 class Lyric
 {
-	friend class VSQFileReader;
 public:
 	/**
 	 * @brief 歌詞.
@@ -121,6 +120,14 @@ public:
 	 */
 	void phoneticSymbol(std::string const& value);
 
+	/**
+	 * @brief 空白区切りの発音記号の文字列から, この歌詞の発音記号を設定する.
+	 * @details 連続する空白は 1 つの区切りとみなし, 連続する "\\" は 1 つの "\\" とみなす.
+	 * @param begin 文字列の先頭.
+	 * @param end 文字列の末尾の次.
+	 */
+	void phoneticSymbol(char const* begin, char const* end);
+
 	/**
 	 * @brief この歌詞の発音記号の配列を取得する.
 	 * @return 発音記号の配列.
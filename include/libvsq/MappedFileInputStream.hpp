@@ -0,0 +1,110 @@
+﻿/**
+ * @file MappedFileInputStream.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./Namespace.hpp"
+#include "./InputStream.hpp"
+#include <string>
+#include <vector>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+/**
+ * @brief ファイルをメモリにマップして読み込む InputStream の実装.
+ * @details ファイルの内容全体を data で連続したバイト列として参照できる. POSIX 環境では mmap を使い,
+ *          それ以外の環境ではファイル全体をメモリに読み込む.
+ */
+class MappedFileInputStream : public InputStream
+{
+private:
+	/**
+	 * @brief マップしたファイルの先頭アドレス.
+	 */
+	uint8_t const* _data;
+
+	/**
+	 * @brief ファイルの長さ.
+	 */
+	int64_t _length;
+
+	/**
+	 * @brief 現在のファイルポインター.
+	 */
+	int64_t _pointer;
+
+	/**
+	 * @brief mmap を使えない環境で, ファイルの内容を保持するバッファー.
+	 */
+	std::vector<uint8_t> _buffer;
+
+public:
+	/**
+	 * @brief ファイルパスを指定してストリームを開く.
+	 * @details ファイルを開けなかった場合は, 長さ 0 のストリームとなる.
+	 * @param filePath 開くファイルのファイルパス.
+	 */
+	explicit MappedFileInputStream(std::string const& filePath);
+
+	~MappedFileInputStream();
+
+	MappedFileInputStream(MappedFileInputStream const&) = delete;
+
+	MappedFileInputStream& operator = (MappedFileInputStream const&) = delete;
+
+	/**
+	 * @brief 1 バイトを読み込む.
+	 * @return 読み込んだバイト値. ストリームの末尾に達した場合は負の値を返す.
+	 */
+	int read() override;
+
+	/**
+	 * @brief バッファーに読み込む.
+	 * @param buffer 読み込んだデータを格納するバッファー.
+	 * @param startIndex 読み込んだデータを格納するオフセット.
+	 * @param length 読み込む長さ.
+	 * @return 読み込んだ長さ.
+	 */
+	size_t read(char* buffer, int64_t startIndex, int64_t length) override;
+
+	/**
+	 * @brief ファイルポインターを移動する.
+	 * @param position ファイルポインター.
+	 */
+	void seek(int64_t position) override;
+
+	/**
+	 * @brief ファイルポインターを取得する.
+	 * @return ファイルポインター.
+	 */
+	int64_t getPointer() override;
+
+	/**
+	 * @brief ストリームを閉じ, マップを解除する.
+	 */
+	void close() override;
+
+	/**
+	 * @brief マップしたファイルの先頭アドレスを取得する.
+	 * @return 先頭アドレス. ファイルが空の場合や, 閉じられている場合は nullptr を返す.
+	 */
+	uint8_t const* data() const override;
+
+	/**
+	 * @brief ファイルの長さを取得する.
+	 * @return ファイルの長さ.
+	 */
+	int64_t length() const override;
+};
+
+LIBVSQ_END_NAMESPACE
@@ -0,0 +1,254 @@
+﻿/**
+ * @file MetaTextLexer.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./Namespace.hpp"
+#include "./StringUtil.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+class TextStream;
+
+/**
+ * @brief VSQ メタテキストを 1 行ずつ読み込み, "key=value" 形式の行をキーと値に分割するクラス.
+ * @details 行, キー, 値はいずれも TextStream のバッファーを直接参照する範囲として取得でき, 文字列のコピーを作らない.
+ *          キーによる分岐には, コンパイル時に計算できるハッシュ値 MetaTextLexer::hash を switch 文の case ラベルとして使う.
+ *          同じ switch 文の中でハッシュ値が衝突すると case ラベルの重複としてコンパイルエラーになるため,
+ *          各セクションのキーの集合に対して衝突の無い (完全な) ハッシュであることがコンパイル時に保証される.
+ */
+class MetaTextLexer
+{
+public:
+	/**
+	 * @brief 文字列の範囲. 元のバッファーを参照し, コピーを持たない.
+	 */
+	class Range
+	{
+	public:
+		/**
+		 * @brief 範囲の先頭.
+		 */
+		char const* begin;
+
+		/**
+		 * @brief 範囲の末尾の次.
+		 */
+		char const* end;
+
+	public:
+		Range()
+			: begin(nullptr), end(nullptr)
+		{}
+
+		Range(char const* begin, char const* end)
+			: begin(begin), end(end)
+		{}
+
+		/**
+		 * @brief 範囲の長さを取得する.
+		 * @return 範囲の長さ.
+		 */
+		size_t size() const
+		{
+			return end - begin;
+		}
+
+		/**
+		 * @brief 範囲が空かどうかを取得する.
+		 * @return 空の場合は <code>true</code> を返す.
+		 */
+		bool empty() const
+		{
+			return begin == end;
+		}
+
+		/**
+		 * @brief 範囲が指定した文字で始まるかどうかを取得する.
+		 * @param c 検査する文字.
+		 * @return 指定した文字で始まる場合は <code>true</code> を返す.
+		 */
+		bool startsWith(char c) const
+		{
+			return begin < end && *begin == c;
+		}
+
+		/**
+		 * @brief 範囲が指定した文字列で始まるかどうかを取得する.
+		 * @param prefix 検査する文字列リテラル.
+		 * @return 指定した文字列で始まる場合は <code>true</code> を返す.
+		 */
+		template<size_t N>
+		bool startsWith(char const (&prefix)[N]) const
+		{
+			return N - 1 <= size() && std::memcmp(begin, prefix, N - 1) == 0;
+		}
+
+		/**
+		 * @brief 範囲に指定した文字が含まれるかどうかを取得する.
+		 * @param c 検査する文字.
+		 * @return 含まれる場合は <code>true</code> を返す.
+		 */
+		bool contains(char c) const
+		{
+			return !empty() && std::memchr(begin, c, size()) != nullptr;
+		}
+
+		/**
+		 * @brief 範囲が指定した文字列と等しいかどうかを取得する.
+		 * @param s 比較する文字列リテラル.
+		 * @return 等しい場合は <code>true</code> を返す.
+		 */
+		template<size_t N>
+		bool operator == (char const (&s)[N]) const
+		{
+			return N - 1 == size() && std::memcmp(begin, s, N - 1) == 0;
+		}
+
+		/**
+		 * @brief 範囲が指定した文字列と等しいかどうかを取得する.
+		 * @param s 比較する文字列.
+		 * @return 等しい場合は <code>true</code> を返す.
+		 */
+		bool operator == (std::string const& s) const
+		{
+			return s.size() == size() && std::memcmp(begin, s.data(), s.size()) == 0;
+		}
+
+		/**
+		 * @brief 範囲のハッシュ値を取得する. MetaTextLexer::hash と同じ値を返す.
+		 * @return ハッシュ値.
+		 */
+		uint32_t hash() const
+		{
+			uint32_t h = HASH_OFFSET_BASIS;
+			for (char const* p = begin; p < end; ++p) {
+				h = (h ^ (uint8_t)*p) * HASH_PRIME;
+			}
+			return h;
+		}
+
+		/**
+		 * @brief 範囲を整数に変換する.
+		 * @return 変換後の数値.
+		 * @throws StringUtil::IntegerParseException 変換に失敗した場合.
+		 */
+		template<typename T>
+		T toInt() const
+		{
+			return StringUtil::parseInt<T>(begin, end);
+		}
+
+		/**
+		 * @brief 範囲をコピーした文字列を取得する.
+		 * @return 文字列.
+		 */
+		std::string toString() const
+		{
+			return std::string(begin, end);
+		}
+	};
+
+public:
+	/**
+	 * @brief 読み込み元のテキストストリームを指定して初期化する.
+	 * @param stream 読み込み元のテキストストリーム. 読み込み位置はこのストリームが管理する.
+	 */
+	explicit MetaTextLexer(TextStream& stream);
+
+	/**
+	 * @brief 次の行を読み込む.
+	 * @details 行に "=" が含まれる場合, 最初の "=" より前をキー, 最初の "=" から次の "=" (または行末) までを値とする.
+	 *          "=" が含まれない場合は, 行全体をキーとし, 値は空とする.
+	 */
+	void next();
+
+	/**
+	 * @brief 続けて読み込める行があるかどうかを取得する.
+	 * @return 読み込める場合は <code>true</code> を返す.
+	 */
+	bool ready() const;
+
+	/**
+	 * @brief 最後に読み込んだ行を取得する. 改行文字は含まない.
+	 * @return 行の範囲.
+	 */
+	Range const& line() const
+	{
+		return _line;
+	}
+
+	/**
+	 * @brief 最後に読み込んだ行のキーを取得する.
+	 * @return キーの範囲.
+	 */
+	Range const& key() const
+	{
+		return _key;
+	}
+
+	/**
+	 * @brief 最後に読み込んだ行の値を取得する.
+	 * @return 値の範囲.
+	 */
+	Range const& value() const
+	{
+		return _value;
+	}
+
+	/**
+	 * @brief 最後に読み込んだ行の, 最初の "=" より後ろ全体を取得する. 値に "=" を含みうるキーのために使う.
+	 * @return 範囲.
+	 */
+	Range rest() const
+	{
+		return Range(_key.end == _line.end ? _line.end : _key.end + 1, _line.end);
+	}
+
+	/**
+	 * @brief 文字列のハッシュ値をコンパイル時に計算する. アルゴリズムは 32 ビットの FNV-1a.
+	 * @param s 文字列.
+	 * @param length 文字列の長さ.
+	 * @param h 計算途中のハッシュ値.
+	 * @return ハッシュ値.
+	 */
+	static constexpr uint32_t hash(char const* s, size_t length, uint32_t h = HASH_OFFSET_BASIS)
+	{
+		return length == 0 ? h : hash(s + 1, length - 1, (h ^ (uint8_t)*s) * HASH_PRIME);
+	}
+
+	/**
+	 * @brief 文字列リテラルのハッシュ値をコンパイル時に計算する.
+	 * @param s 文字列リテラル.
+	 * @return ハッシュ値.
+	 */
+	template<size_t N>
+	static constexpr uint32_t hash(char const (&s)[N])
+	{
+		return hash(s, N - 1);
+	}
+
+private:
+	static uint32_t const HASH_OFFSET_BASIS = 2166136261u;
+	static uint32_t const HASH_PRIME = 16777619u;
+
+	TextStream& _stream;
+	Range _line;
+	Range _key;
+	Range _value;
+};
+
+LIBVSQ_END_NAMESPACE
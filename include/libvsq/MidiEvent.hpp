@@ -60,6 +60,168 @@ public:
 		}
 	};
 
+	/**
+	 * @brief MIDI イベントのデータを格納するバイト列.
+	 * @details 短いデータはオブジェクト内部の固定長領域に格納し, INLINE_CAPACITY バイトを超える場合のみヒープ領域を確保する.
+	 *          チャンネルメッセージや, テンポ・拍子などの短いメタイベントではヒープ領域の確保が発生しない.
+	 */
+	class Data
+	{
+	public:
+		/**
+		 * @brief ヒープ領域を確保せずに格納できるバイト数.
+		 */
+		static const size_t INLINE_CAPACITY = 16;
+
+		Data();
+
+		Data(Data const& value);
+
+		Data(Data&& value);
+
+		~Data();
+
+		Data& operator = (Data const& value);
+
+		Data& operator = (Data&& value);
+
+		/**
+		 * @brief 格納されているバイト数を取得する.
+		 * @return バイト数.
+		 */
+		size_t size() const
+		{
+			return _size;
+		}
+
+		/**
+		 * @brief データが空かどうかを取得する.
+		 * @return 空であれば <code>true</code> を返す.
+		 */
+		bool empty() const
+		{
+			return _size == 0;
+		}
+
+		/**
+		 * @brief 再確保なしに格納できるバイト数を取得する.
+		 * @return バイト数.
+		 */
+		size_t capacity() const
+		{
+			return _capacity;
+		}
+
+		/**
+		 * @brief 先頭のバイトへのポインタを取得する.
+		 */
+		uint8_t* data()
+		{
+			return isInline() ? _storage.inlineBytes : _storage.heapBytes;
+		}
+
+		/**
+		 * @copydoc MidiEvent::Data::data
+		 */
+		uint8_t const* data() const
+		{
+			return isInline() ? _storage.inlineBytes : _storage.heapBytes;
+		}
+
+		uint8_t* begin()
+		{
+			return data();
+		}
+
+		uint8_t const* begin() const
+		{
+			return data();
+		}
+
+		uint8_t* end()
+		{
+			return data() + _size;
+		}
+
+		uint8_t const* end() const
+		{
+			return data() + _size;
+		}
+
+		uint8_t& operator[](size_t index)
+		{
+			return data()[index];
+		}
+
+		uint8_t operator[](size_t index) const
+		{
+			return data()[index];
+		}
+
+		/**
+		 * @brief 末尾に 1 バイト追加する.
+		 * @param value 追加する値. 下位 8 ビットのみが格納される.
+		 */
+		void push_back(int value)
+		{
+			if (_size == _capacity) {
+				reserve(static_cast<size_t>(_capacity) * 2);
+			}
+			data()[_size++] = static_cast<uint8_t>(0xff & value);
+		}
+
+		/**
+		 * @brief バイト数を変更する. 増えた領域は 0 で初期化される.
+		 * @param size 新しいバイト数.
+		 * @throw std::length_error @a size が UINT32_MAX を超える場合.
+		 */
+		void resize(size_t size);
+
+		/**
+		 * @brief 指定したバイト数を格納できるよう, 領域を確保する.
+		 * @param capacity バイト数.
+		 * @throw std::length_error @a capacity が UINT32_MAX を超える場合.
+		 */
+		void reserve(size_t capacity);
+
+		/**
+		 * @brief 指定したバイト列で内容を置き換える.
+		 * @param bytes バイト列の先頭.
+		 * @param length バイト数.
+		 * @throw std::length_error @a length が UINT32_MAX を超える場合.
+		 */
+		void assign(uint8_t const* bytes, size_t length);
+
+		/**
+		 * @brief 全てのバイトを削除する. 確保済みの領域は解放しない.
+		 */
+		void clear()
+		{
+			_size = 0;
+		}
+
+		bool operator == (Data const& value) const;
+
+		bool operator != (Data const& value) const
+		{
+			return !(*this == value);
+		}
+
+	private:
+		bool isInline() const
+		{
+			return _capacity == INLINE_CAPACITY;
+		}
+
+	private:
+		uint32_t _size;
+		uint32_t _capacity;
+		union {
+			uint8_t* heapBytes;
+			uint8_t inlineBytes[INLINE_CAPACITY];
+		} _storage;
+	};
+
 	/**
 	 * @brief Tick 単位の時刻.
 	 */
@@ -74,7 +236,7 @@ public:
 	 * @brief MIDI イベントのデータ.
 	 * @details メタイベントについては長さ値を保持せず, 出力時に <code>data</code> フィールドの長さに応じた値を自動的に出力する.
 	 */
-	std::vector<int> data;
+	Data data;
 
 	MidiEvent();
 
@@ -115,6 +277,29 @@ public:
 	 */
 	static void writeDeltaTick(OutputStream& stream, int number);
 
+	/**
+	 * @brief 可変長のデルタタイムの, 最大のバイト数.
+	 */
+	static const int MAX_DELTA_TICK_BYTES = 10;
+
+	/**
+	 * @brief 可変長のデルタタイムを, 指定したバッファーに書き込む.
+	 * @param number デルタタイム.
+	 * @param dest 書き込み先のバッファー. MAX_DELTA_TICK_BYTES バイト以上の空きが必要.
+	 * @return 書き込んだバイト数.
+	 */
+	static int encodeDeltaTick(tick_t number, uint8_t* dest);
+
+	/**
+	 * @brief バッファーから, 可変長のデルタタイムを読み込む.
+	 * @details 最後のバイトに達する前にバッファーの終端に達した場合は, それまでに読み込んだ値を返す(readDeltaTick と同じ動作).
+	 * @param data 読み込み元のバッファー.
+	 * @param length バッファーのバイト数.
+	 * @param[out] number 読み込んだデルタタイム.
+	 * @return 読み込んだバイト数.
+	 */
+	static int decodeDeltaTick(uint8_t const* data, size_t length, tick_t& number);
+
 	/**
 	 * @brief ストリームから, デルタタイムを読み込む.
 	 * @param stream 読み込み元のストリーム.
@@ -131,6 +316,18 @@ public:
 	 */
 	static MidiEvent read(InputStream& stream, tick_t& last_tick, uint8_t& last_status_byte);
 
+	/**
+	 * @brief メモリ上のバイト列から MIDI イベントを一つ読み込む.
+	 * @details ストリームから読み込む場合と同じ結果となる. バイト列の終端を越えた部分は, ストリームの終端に達した場合と同じく 0xFF として扱う.
+	 * @param data 読み込み元のバイト列.
+	 * @param length バイト列の長さ.
+	 * @param[in,out] position 読み込みを開始する位置. 読み込んだイベントの次の位置に更新される(length を越えることはない).
+	 * @param last_tick
+	 * @param last_status_byte
+	 * @throw ParseException
+	 */
+	static MidiEvent read(uint8_t const* data, size_t length, size_t& position, tick_t& last_tick, uint8_t& last_status_byte);
+
 	/**
 	 * @brief 2 つの {@link MidiEvent} を比較する.
 	 * @param a 比較対象のオブジェクト.
@@ -20,6 +20,8 @@
 
 LIBVSQ_BEGIN_NAMESPACE
 
+class NrpnEventBuffer;
+
 /**
  * @brief NRPN イベントを表すクラス.
  */
@@ -140,6 +142,13 @@ public:
 	 */
 	static std::vector<MidiEvent> convert(std::vector<NrpnEvent> const& source);
 
+	/**
+	 * @brief NRPN バッファーのレコードを, {@link MidiEvent} の配列に変換する.
+	 * @param source NRPN バッファー.
+	 * @return {@link MidiEvent} の配列.
+	 */
+	static std::vector<MidiEvent> convert(NrpnEventBuffer const& source);
+
 protected:
 	NrpnEvent();
 };
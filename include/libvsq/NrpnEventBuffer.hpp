@@ -0,0 +1,237 @@
+﻿/**
+ * @file NrpnEventBuffer.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./BasicTypes.hpp"
+#include "./MidiParameterType.hpp"
+#include <cstdint>
+#include <vector>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+class NrpnEvent;
+class OutputStream;
+
+/**
+ * @brief NRPN イベントを, 連続したメモリ上のレコードとして追記していくバッファー.
+ * @details NrpnEvent が子イベントのリストを入れ子で保持するのに対し, このクラスは 1 つの NRPN を 1 レコードとして平坦に保持する.
+ *          NrpnEvent とその子イベントに相当するレコードの並びを「グループ」と呼び, グループの先頭レコードには GROUP_HEAD フラグが立つ.
+ *          グループ内のレコードはすべて先頭レコードと同じ時刻を持つ.
+ */
+class NrpnEventBuffer
+{
+public:
+	/**
+	 * @brief DATA LSB 値を持っていることを表すフラグ.
+	 */
+	static const uint8_t HAS_LSB = 0x01;
+
+	/**
+	 * @brief NRPN MSB の出力を省略することを表すフラグ.
+	 */
+	static const uint8_t MSB_OMITTING_REQUIRED = 0x02;
+
+	/**
+	 * @brief グループの先頭のレコードであることを表すフラグ.
+	 */
+	static const uint8_t GROUP_HEAD = 0x04;
+
+	/**
+	 * @brief 1 つの NRPN を表すレコード.
+	 */
+	struct Record {
+		/**
+		 * @brief Tick 単位の時刻.
+		 */
+		tick_t tick;
+
+		/**
+		 * @brief NRPN の値.
+		 */
+		MidiParameterType nrpn;
+
+		/**
+		 * @brief DATA MSB.
+		 */
+		uint8_t dataMSB;
+
+		/**
+		 * @brief DATA LSB.
+		 */
+		uint8_t dataLSB;
+
+		/**
+		 * @brief HAS_LSB, MSB_OMITTING_REQUIRED, GROUP_HEAD の組み合わせ.
+		 */
+		uint8_t flags;
+
+		/**
+		 * @brief DATA LSB 値を持っているかどうかを取得する.
+		 */
+		bool hasLSB() const
+		{
+			return (flags & HAS_LSB) == HAS_LSB;
+		}
+
+		/**
+		 * @brief NRPN MSB の出力を省略するかどうかを取得する.
+		 */
+		bool isMSBOmittingRequired() const
+		{
+			return (flags & MSB_OMITTING_REQUIRED) == MSB_OMITTING_REQUIRED;
+		}
+
+		/**
+		 * @brief グループの先頭のレコードかどうかを取得する.
+		 */
+		bool isGroupHead() const
+		{
+			return (flags & GROUP_HEAD) == GROUP_HEAD;
+		}
+	};
+
+	NrpnEventBuffer();
+
+	/**
+	 * @brief 時刻, NRPN, DATA MSB を指定し, 新しいグループを開始する.
+	 * @param tick Tick 単位の時刻.
+	 * @param nrpn NRPN.
+	 * @param dataMsb DATA MSB.
+	 */
+	void add(tick_t tick, MidiParameterType nrpn, int dataMsb);
+
+	/**
+	 * @brief 時刻, NRPN, DATA MSB, DATA LSB を指定し, 新しいグループを開始する.
+	 * @param tick Tick 単位の時刻.
+	 * @param nrpn NRPN.
+	 * @param dataMsb DATA MSB.
+	 * @param dataLsb DATA LSB.
+	 */
+	void add(tick_t tick, MidiParameterType nrpn, int dataMsb, int dataLsb);
+
+	/**
+	 * @brief NrpnEvent とその子イベントを展開し, 1 つのグループとして追加する.
+	 * @param event 追加するイベント.
+	 */
+	void add(NrpnEvent const& event);
+
+	/**
+	 * @brief NRPN, DATA MSB を指定し, 最後のグループにレコードを追加する.
+	 * @param nrpn NRPN.
+	 * @param dataMsb DATA MSB.
+	 */
+	void append(MidiParameterType nrpn, int dataMsb);
+
+	/**
+	 * @brief NRPN, DATA MSB, DATA LSB を指定し, 最後のグループにレコードを追加する.
+	 * @param nrpn NRPN.
+	 * @param dataMsb DATA MSB.
+	 * @param dataLsb DATA LSB.
+	 */
+	void append(MidiParameterType nrpn, int dataMsb, int dataLsb);
+
+	/**
+	 * @brief NRPN, DATA MSB, MSB 省略フラグを指定し, 最後のグループにレコードを追加する.
+	 * @param nrpn NRPN.
+	 * @param dataMsb DATA MSB.
+	 * @param isMsbOmittingRequired NRPN MSB を省略する場合は <code>true</code> を, そうでない場合は <code>false</code> を指定する.
+	 */
+	void append(MidiParameterType nrpn, int dataMsb, bool isMsbOmittingRequired);
+
+	/**
+	 * @brief NRPN, DATA MSB, DATA LSB, MSB 省略フラグを指定し, 最後のグループにレコードを追加する.
+	 * @param nrpn NRPN.
+	 * @param dataMsb DATA MSB.
+	 * @param dataLsb DATA LSB.
+	 * @param isMsbOmittingRequired NRPN MSB を省略する場合は <code>true</code> を, そうでない場合は <code>false</code> を指定する.
+	 */
+	void append(MidiParameterType nrpn, int dataMsb, int dataLsb, bool isMsbOmittingRequired);
+
+	/**
+	 * @brief 別のバッファーのレコードを, フラグも含めてそのまま末尾に追加する.
+	 * @param source コピー元のバッファー.
+	 * @param start コピーする最初のレコードのインデックス.
+	 * @param count コピーするレコードの個数.
+	 */
+	void append(NrpnEventBuffer const& source, int start, int count);
+
+	/**
+	 * @brief レコードの個数を取得する.
+	 * @return レコードの個数.
+	 */
+	int size() const;
+
+	/**
+	 * @brief レコードが 1 つも無いかどうかを取得する.
+	 * @return レコードが無い場合は <code>true</code> を返す.
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief 指定したインデックスのレコードを取得する.
+	 * @param index インデックス.
+	 * @return レコード.
+	 */
+	Record const& get(int index) const;
+
+	/**
+	 * @brief 全てのレコードを削除する.
+	 */
+	void clear();
+
+	/**
+	 * @brief 指定した個数のレコードを格納できるよう, 領域を予約する.
+	 * @param count レコードの個数.
+	 */
+	void reserve(int count);
+
+	/**
+	 * @brief グループ単位で, 時刻の昇順, 先頭レコードの NRPN MSB の降順に安定ソートする.
+	 * @details 順序は NrpnEvent::compare と同じであり, グループ内のレコードの並びは変化しない.
+	 */
+	void sort();
+
+	/**
+	 * @brief グループごとに NrpnEvent を作成し, 配列に変換する.
+	 * @return グループの先頭レコードを親, それ以外のレコードを子とする NrpnEvent の配列.
+	 */
+	std::vector<NrpnEvent> toList() const;
+
+	/**
+	 * @brief 全てのレコードをそれぞれ 1 つの NrpnEvent に変換する.
+	 * @return 子イベントを持たない NrpnEvent の配列.
+	 */
+	std::vector<NrpnEvent> expand() const;
+
+	/**
+	 * @brief 全てのレコードを, デルタタイム付きのコントロールチェンジとして SMF のトラックデータの形式でストリームに出力する.
+	 * @details NrpnEvent::convert で MidiEvent の配列を作成してから出力する場合と同じバイト列を, 中間の配列を作らずに直接出力する.
+	 *          出力は固定長の領域にまとめてから行うため, 必要なメモリはレコード数に依存しない.
+	 * @param stream 出力先のストリーム.
+	 * @param[in,out] lastTick 直前に出力したイベントの Tick 単位の時刻. 最後に出力したレコードの時刻に更新される.
+	 * @param runningStatus ランニングステータスを使って出力するかどうか. <code>true</code> の場合, 最初のコントロールチェンジ以外ではステータスバイト 0xB0 を省略する.
+	 *                      直前にメタイベントや SysEx を出力していてもよい.
+	 */
+	void write(OutputStream& stream, tick_t& lastTick, bool runningStatus = false) const;
+
+private:
+	void push(tick_t tick, MidiParameterType nrpn, int dataMsb, int dataLsb, uint8_t flags);
+
+	tick_t lastTick() const;
+
+private:
+	std::vector<Record> _records;
+};
+
+LIBVSQ_END_NAMESPACE
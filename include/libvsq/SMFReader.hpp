@@ -17,6 +17,8 @@
 #include "./MidiEvent.hpp"
 #include <exception>
 #include <vector>
+#include <memory>
+#include <functional>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -35,6 +37,10 @@ public:
 	class ParseException : public std::exception
 	{};
 
+	SMFReader();
+
+	~SMFReader();
+
 	/**
 	 * @brief ストリームから, SMF を読み込む.
 	 * @param[in] stream 読み込むストリーム.
@@ -44,6 +50,53 @@ public:
 	 * @throw ParseException
 	 */
 	void read(InputStream& stream, std::vector<std::vector<MidiEvent>>& dest, int& format, int& timeFormat);
+
+	/**
+	 * @brief ストリームから, SMF の各 MTrk チャンクのデータ部をデコードせずに読み込む.
+	 * @param[in] stream 読み込むストリーム.
+	 * @param[out] dest 読み込んだチャンクのデータ部のリスト. ストリームの終端に達した場合は, 読み込めた長さに切り詰められる.
+	 * @param[out] format SMF のフォーマット.
+	 * @param[out] timeFormat 時間分解能.
+	 * @throw ParseException
+	 */
+	static void readChunks(InputStream& stream, std::vector<std::vector<uint8_t>>& dest, int& format, int& timeFormat);
+
+	/**
+	 * @brief MTrk チャンクのデータ部から, MIDI イベントを読み込む.
+	 * @param[in] chunk SMFReader::readChunks で読み込んだチャンクのデータ部.
+	 * @param[out] dest 読み込んだ MIDI イベントの追加先.
+	 * @throw MidiEvent::ParseException
+	 */
+	static void decodeChunk(std::vector<uint8_t> const& chunk, std::vector<MidiEvent>& dest);
+
+	/**
+	 * @brief ストリームから SMF を読み込み, MTrk チャンクを 1 つずつデコードして callback に渡す.
+	 * @details メモリに保持するのは, 読み込み中のトラック 1 つ分のチャンクと MIDI イベントだけとなる.
+	 * @param[in] stream 読み込むストリーム.
+	 * @param[in] callback トラックの番号と, そのトラックの MIDI イベントのリストを受け取る関数.
+	 * @param[out] format SMF のフォーマット. callback を呼ぶ前に設定される.
+	 * @param[out] timeFormat 時間分解能. callback を呼ぶ前に設定される.
+	 * @throw ParseException
+	 */
+	static void readTracks(InputStream& stream, std::function<void(int, std::vector<MidiEvent> const&)> const& callback, int& format, int& timeFormat);
+
+	/**
+	 * @brief トラックのデコードを並列に行うかどうかを取得する.
+	 * @return 並列に行う場合は <code>true</code> を返す.
+	 */
+	bool parallel() const;
+
+	/**
+	 * @brief トラックのデコードを並列に行うかどうかを設定する.
+	 * @details <code>true</code> を設定すると, 全ての MTrk チャンクをメモリに読み込んだ後, 各トラックの MIDI イベントをワーカースレッド上でデコードする.
+	 *          読み込み結果は並列化しない場合と同一となる.
+	 * @param value 並列に行う場合は <code>true</code> を指定する.
+	 */
+	void parallel(bool value);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> _impl;
 };
 
 LIBVSQ_END_NAMESPACE
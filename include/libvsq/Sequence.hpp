@@ -19,6 +19,7 @@
 #include "./Master.hpp"
 #include "./Mixer.hpp"
 #include "./Track.hpp"
+#include <functional>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -57,8 +58,9 @@ public:
 protected:
 	/**
 	 * @brief トラックのリスト.
+	 * @details 遅延読み込み中のトラックは, 名前だけが設定された仮のトラックとなる.
 	 */
-	std::vector<Track> _track;
+	mutable std::vector<Track> _track;
 
 private:
 	/**
@@ -74,7 +76,12 @@ private:
 	/**
 	 * @brief Tick 単位の曲の長さ.
 	 */
-	tick_t _totalTicks;
+	mutable tick_t _totalTicks;
+
+	/**
+	 * @brief 遅延読み込み中のトラックを読み込む関数のリスト. 読み込み済みのトラックに対応する要素は空となる.
+	 */
+	mutable std::vector<std::function<Track()>> _trackLoaders;
 
 public:
 	/**
@@ -100,6 +107,7 @@ public:
 
 	/**
 	 * @brief 先頭から @a trackIndex 番目のトラックを取得する.
+	 * @details 遅延読み込み中のトラックの場合, ここで読み込みが行われる.
 	 */
 	Track const& track(int trackIndex) const;
 
@@ -110,6 +118,7 @@ public:
 
 	/**
 	 * @brief 全トラックのリストを取得する.
+	 * @details 遅延読み込み中のトラックがある場合, ここで全て読み込まれる.
 	 */
 	std::vector<Track> const& tracks() const;
 
@@ -118,6 +127,30 @@ public:
 	 */
 	std::vector<Track>& tracks();
 
+	/**
+	 * @brief トラックの個数を取得する. 遅延読み込み中のトラックは読み込まない.
+	 * @return トラックの個数.
+	 */
+	int trackCount() const;
+
+	/**
+	 * @brief 先頭から @a trackIndex 番目のトラックの名前を取得する. 遅延読み込み中のトラックは読み込まない.
+	 * @return トラックの名前.
+	 */
+	std::string trackName(int trackIndex) const;
+
+	/**
+	 * @brief 先頭から @a trackIndex 番目のトラックの, 最初の歌手変更イベントの歌手名を取得する. 遅延読み込み中のトラックは読み込まない.
+	 * @return 歌手名. 歌手変更イベントが無い場合は空文字を返す.
+	 */
+	std::string trackSinger(int trackIndex) const;
+
+	/**
+	 * @brief 先頭から @a trackIndex 番目のトラックが読み込み済みかどうかを取得する.
+	 * @return 読み込み済みであれば <code>true</code> を返す. 遅延読み込み中であれば <code>false</code> を返す.
+	 */
+	bool isTrackLoaded(int trackIndex) const;
+
 	/**
 	 * @brief テンポが一つも指定されていない場合の, 基本テンポ値を取得する.
 	 * @return テンポ値. 四分音符の長さのマイクロ秒単位の長さ.
@@ -127,6 +160,7 @@ public:
 	/**
 	 * @brief Tick 単位の曲の長さを取得する.
 	 * @details シーケンスに変更を加えた場合, Sequence::updateTotalTicks を呼んでからこのメソッドを呼ぶこと.
+	 *          遅延読み込みされたシーケンスの場合も, トラックは読み込まない.
 	 * @return Tick 単位の曲の長さ.
 	 */
 	tick_t totalTicks() const;
@@ -160,7 +194,34 @@ public:
 	 */
 	void updateTotalTicks();
 
+	/**
+	 * @brief 現在のイベントとカーブから, Tick 単位の曲の長さを計算する. totalTicks の値は更新しない.
+	 * @details 遅延読み込み中のトラックがある場合, ここで全て読み込まれる.
+	 * @return Tick 単位の曲の長さ.
+	 */
+	tick_t calculateTotalTicks() const;
+
+	/**
+	 * @brief 全トラックを, 遅延読み込み中の仮のトラックで置き換える.
+	 * @details 仮のトラックは, トラックを初めて参照した時に対応する関数の戻り値で置き換えられる. 関数が空のトラックは読み込み済みとして扱う.
+	 * @param placeholders 仮のトラックのリスト. Sequence::trackName と Sequence::trackSinger はこの内容を返す.
+	 * @param loaders 各トラックを読み込む関数のリスト.
+	 * @param totalTicks 全トラックを読み込んだ時の, Tick 単位の曲の長さ.
+	 */
+	void setTrackLoaders(std::vector<Track> placeholders, std::vector<std::function<Track()>> loaders, tick_t totalTicks);
+
 private:
+	/**
+	 * @brief 遅延読み込み中のトラックを読み込む.
+	 * @param trackIndex 読み込むトラックの番号.
+	 */
+	void _loadTrack(int trackIndex) const;
+
+	/**
+	 * @brief 遅延読み込み中のトラックを全て読み込む.
+	 */
+	void _loadAllTracks() const;
+
 	/**
 	 * @brief プリメジャーの Tick 単位の長さを計算する.
 	 * @return Tick 単位のプリメジャー長さ.
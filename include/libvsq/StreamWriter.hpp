@@ -21,6 +21,7 @@
 LIBVSQ_BEGIN_NAMESPACE
 
 class OutputStream;
+class BufferedOutputStream;
 
 /**
  * @brief ファイルへの出力を行う TextOutputStream の実装.
@@ -30,6 +31,11 @@ class StreamWriter : public TextOutputStream
 private:
 	std::unique_ptr<OutputStream> stream;
 
+	/**
+	 * @brief stream への書き込みをバッファリングするアダプター.
+	 */
+	std::unique_ptr<BufferedOutputStream> buffer;
+
 public:
 	/**
 	 * @brief 出力先のファイルパスを指定して初期化する.
@@ -75,6 +75,19 @@ public:
 		}
 	}
 
+	/**
+	 * @brief 文字列の範囲を, 文字列のコピーを作らずに整数に変換する. 変換の規則は std::string を引数にとる parseInt と同じ.
+	 * @param begin 変換する範囲の先頭.
+	 * @param end 変換する範囲の末尾の次.
+	 * @param baseNumber 基数.
+	 * @return 変換後の数値.
+	 */
+	template<typename T>
+	static T parseInt(char const* begin, char const* end, int baseNumber = 10)
+	{
+		return static_cast<T>(_parseLongLong(begin, end, baseNumber));
+	}
+
 	/**
 	 * @brief 文字列を浮動小数点数に変換する.
 	 * @param text 変換する文字列.
@@ -153,6 +166,16 @@ private:
 
 	static char _toLower(char c);
 
+	/**
+	 * @brief 文字列の範囲を long long に変換する. 先頭の空白文字と符号を読み飛ばし, 数字でない文字が現れた時点で変換を終える.
+	 * @param begin 変換する範囲の先頭.
+	 * @param end 変換する範囲の末尾の次.
+	 * @param baseNumber 基数.
+	 * @return 変換後の数値.
+	 * @throws IntegerParseException 数字が一つも無い場合, または値が long long の範囲を超える場合.
+	 */
+	static long long _parseLongLong(char const* begin, char const* end, int baseNumber);
+
 	template<class T>
 	static int _sprintf(std::vector<char>& buffer, std::string const& format, T value)
 	{
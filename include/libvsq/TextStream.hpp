@@ -73,6 +73,14 @@ public:
 	 */
 	std::string readLine();
 
+	/**
+	 * @brief 現在の読み込み位置から, 改行またはファイル末端までの範囲を, 文字列のコピーを作らずに取得する.
+	 * @details 読み書き位置は readLine() と同じだけ進める. 取得した範囲は, 次にストリームへ書き込むまで有効.
+	 * @param[out] begin 読み込んだ範囲の先頭.
+	 * @param[out] end 読み込んだ範囲の末尾の次. 改行文字は含まない.
+	 */
+	void readLine(char const*& begin, char const*& end);
+
 	/**
 	 * @brief テキストストリームが読み込み可能な状態かどうかを返す.
 	 * @return 読み込み可能であれば <code>true</code> を, そうでなければ <code>false</code> を返す.
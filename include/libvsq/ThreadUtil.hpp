@@ -0,0 +1,41 @@
+﻿/**
+ * @file ThreadUtil.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./Namespace.hpp"
+#include <functional>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+/**
+ * @brief スレッド関連のユーティリティ.
+ */
+class ThreadUtil
+{
+public:
+	/**
+	 * @brief 0 から count - 1 までの番号について, それぞれワーカースレッド上で task を実行する.
+	 * @details ワーカースレッドの数は, ハードウェアの並列数と count のうち小さい方となる. 呼び出し元のスレッドもワーカーの 1 つとして使う.
+	 *          スレッドを作れなかった場合は, 作れた分のスレッドだけで全ての task を実行する.
+	 *          いずれかの task が例外を投げた場合は, 全ての task が終わった後, 番号が最も小さいものの例外を再送出する.
+	 * @param count task を実行する回数.
+	 * @param task 番号を引数にとる処理.
+	 */
+	static void runConcurrently(int count, std::function<void(int)> const& task);
+
+private:
+	ThreadUtil();
+};
+
+LIBVSQ_END_NAMESPACE
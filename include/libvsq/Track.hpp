@@ -58,11 +58,15 @@ public:
 
 	Track(Track const& value);
 
+	Track(Track&& value) = default;
+
 	virtual ~Track()
 	{}
 
 	Track& operator = (Track const& value);
 
+	Track& operator = (Track&& value) = default;
+
 	/**
 	 * @brief トラックの名前を取得する.
 	 * @return トラック名.
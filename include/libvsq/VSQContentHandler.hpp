@@ -0,0 +1,127 @@
+﻿/**
+ * @file VSQContentHandler.hpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#pragma once
+
+#include "./Namespace.hpp"
+#include "./Event.hpp"
+#include "./Handle.hpp"
+#include "./Common.hpp"
+#include "./Master.hpp"
+#include "./Mixer.hpp"
+#include "./Tempo.hpp"
+#include "./Timesig.hpp"
+#include <string>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+/**
+ * @brief VSQFileReader が読み込んだ VSQ ファイルの内容を, 読み込んだ順に受け取るハンドラー.
+ * @details Sequence を作らずに VSQ ファイルの内容を処理する場合に, 必要なメソッドをオーバーライドして使う.
+ *          テンポと拍子の通知の後, トラックごとに startTrack, トラックの内容, endTrack の順に通知される.
+ *          トラックの番号は Sequence::track に指定する番号と同じく, 0 から始まる.
+ *          各メソッドの既定の実装は何もしない.
+ */
+class VSQContentHandler
+{
+public:
+	virtual ~VSQContentHandler()
+	{}
+
+	/**
+	 * @brief テンポ変更を受け取る.
+	 * @param tempo テンポ変更.
+	 */
+	virtual void tempo(Tempo const& /*tempo*/)
+	{}
+
+	/**
+	 * @brief 拍子変更を受け取る.
+	 * @param timesig 拍子変更.
+	 */
+	virtual void timesig(Timesig const& /*timesig*/)
+	{}
+
+	/**
+	 * @brief トラックの読み込みの開始を受け取る.
+	 * @param track トラックの番号.
+	 * @param name トラック名.
+	 */
+	virtual void startTrack(int /*track*/, std::string const& /*name*/)
+	{}
+
+	/**
+	 * @brief トラックの読み込みの終了を受け取る.
+	 * @param track トラックの番号.
+	 */
+	virtual void endTrack(int /*track*/)
+	{}
+
+	/**
+	 * @brief トラックの [Common] セクションを受け取る.
+	 * @param track トラックの番号.
+	 * @param common [Common] セクションの内容.
+	 */
+	virtual void common(int /*track*/, Common const& /*common*/)
+	{}
+
+	/**
+	 * @brief [Master] セクションを受け取る. 先頭のトラックの読み込み中にだけ通知される.
+	 * @param master [Master] セクションの内容.
+	 */
+	virtual void master(Master const& /*master*/)
+	{}
+
+	/**
+	 * @brief [Mixer] セクションを受け取る. 先頭のトラックの読み込み中にだけ通知される.
+	 * @param mixer [Mixer] セクションの内容.
+	 */
+	virtual void mixer(Mixer const& /*mixer*/)
+	{}
+
+	/**
+	 * @brief [ID#nnnn] セクションのイベントを受け取る. [EventList] セクションに時刻が記録されたイベントだけが通知される.
+	 * @details イベントの時刻は設定済みで, ハンドルは設定されていない. イベントが参照するハンドルは, 番号で渡される.
+	 *          ハンドラーは item をムーブして保持してもよい.
+	 * @param track トラックの番号.
+	 * @param id イベントの番号 ([ID#nnnn] の nnnn).
+	 * @param item イベント.
+	 * @param singerHandleIndex 歌手または強弱記号のハンドルの番号. 参照しない場合は負の値.
+	 * @param lyricHandleIndex 歌詞のハンドルの番号. 参照しない場合は負の値.
+	 * @param vibratoHandleIndex ビブラートのハンドルの番号. 参照しない場合は負の値.
+	 * @param noteHeadHandleIndex アタックのハンドルの番号. 参照しない場合は負の値.
+	 */
+	virtual void event(int /*track*/, int /*id*/, Event& /*item*/, int /*singerHandleIndex*/, int /*lyricHandleIndex*/, int /*vibratoHandleIndex*/, int /*noteHeadHandleIndex*/)
+	{}
+
+	/**
+	 * @brief [h#nnnn] セクションのハンドルを受け取る. ハンドラーは item をムーブして保持してもよい.
+	 * @param track トラックの番号.
+	 * @param index ハンドルの番号 ([h#nnnn] の nnnn).
+	 * @param item ハンドル.
+	 */
+	virtual void handle(int /*track*/, int /*index*/, Handle& /*item*/)
+	{}
+
+	/**
+	 * @brief コントロールカーブのデータ点を受け取る.
+	 * @param track トラックの番号.
+	 * @param curveName カーブの名前. Track::curve に指定する名前.
+	 * @param tick Tick 単位の時刻.
+	 * @param value データ点の値.
+	 */
+	virtual void curvePoint(int /*track*/, std::string const& /*curveName*/, tick_t /*tick*/, int /*value*/)
+	{}
+};
+
+LIBVSQ_END_NAMESPACE
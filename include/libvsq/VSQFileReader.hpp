@@ -19,6 +19,7 @@
 #include "./Track.hpp"
 #include "./MidiEvent.hpp"
 #include "./PublicForUnitTest.hpp"
+#include <set>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -28,12 +29,46 @@ class TimesigList;
 class TempoList;
 class Master;
 class Mixer;
+class VSQContentHandler;
 
 /**
  * @brief VSQ ファイルのシーケンスを読み込み, Sequence オブジェクトを作成するクラス.
  */
 class VSQFileReader
 {
+public:
+	/**
+	 * @brief 読み込む内容を限定するためのオプション.
+	 * @details 読み込まないと指定されたセクションは, 内容を解析せずに読み飛ばす.
+	 */
+	class Options
+	{
+	public:
+		/**
+		 * @brief 読み込まないコントロールカーブの名前の集合. 名前は Track::curve に指定するもので, 大文字と小文字を区別しない.
+		 */
+		std::set<std::string> skipCurves;
+
+		/**
+		 * @brief ビブラートのハンドルを読み込まないかどうか. <code>true</code> の場合, 音符イベントの vibratoHandle は既定値のままとなる.
+		 */
+		bool skipVibratoHandles;
+
+		/**
+		 * @brief アタックのハンドルを読み込まないかどうか. <code>true</code> の場合, 音符イベントの noteHeadHandle は既定値のままとなる.
+		 */
+		bool skipNoteHeadHandles;
+
+		/**
+		 * @brief 読み込むトラックの番号 (Sequence::track に指定する番号) の集合. 空の場合は全てのトラックを読み込む.
+		 * @details 含まれないトラックも Sequence には追加されるが, トラック名以外は既定値のままとなる.
+		 */
+		std::set<int> tracks;
+
+	public:
+		Options();
+	};
+
 public:
 	VSQFileReader();
 
@@ -48,6 +83,58 @@ public:
 	 */
 	void read(Sequence& sequence, InputStream& stream, std::string const& encoding);
 
+	/**
+	 * @brief 読み込みストリームから VSQ ファイルを読み込み, Sequence を作らずに, 読み込んだ内容を順に handler へ通知する.
+	 * @details MTrk チャンクはトラック 1 つずつ読み込んで通知するため, メモリに保持するのはトラック 1 つ分のデータだけとなる.
+	 *          options の指定は適用され, lazy と parallel の指定は無視される.
+	 * @param stream 読み込みストリーム.
+	 * @param handler 読み込んだ内容の通知先.
+	 * @param encoding メタテキストのテキストエンコーディング(無視される. 現在はShift_JIS固定).
+	 */
+	void read(InputStream& stream, VSQContentHandler& handler, std::string const& encoding);
+
+	/**
+	 * @brief トラックを遅延読み込みするかどうかを取得する.
+	 * @return 遅延読み込みする場合は <code>true</code> を返す.
+	 */
+	bool lazy() const;
+
+	/**
+	 * @brief トラックを遅延読み込みするかどうかを設定する.
+	 * @details <code>true</code> を設定すると, read ではトラックを組み立てず, 各トラックのイベント, ハンドル, カーブは
+	 *          Sequence::track などでトラックを初めて参照した時に組み立てる. トラック名, トラック数, テンポ, 拍子, Master, Mixer, 曲の長さ,
+	 *          各トラックの最初の歌手名 (Sequence::trackSinger) は read の時点で求められる.
+	 *          遅延読み込み中の Sequence は, const なメソッドであっても複数のスレッドから同時に参照してはならない.
+	 * @param value 遅延読み込みする場合は <code>true</code> を指定する.
+	 */
+	void lazy(bool value);
+
+	/**
+	 * @brief トラックの読み込みを並列に行うかどうかを取得する.
+	 * @return 並列に行う場合は <code>true</code> を返す.
+	 */
+	bool parallel() const;
+
+	/**
+	 * @brief トラックの読み込みを並列に行うかどうかを設定する.
+	 * @details <code>true</code> を設定すると, MTrk チャンクのデコードと, 各トラックのメタテキストの組み立て・解析をワーカースレッド上で行い,
+	 *          トラック順に Sequence へ格納する. 読み込まれる Sequence は並列化しない場合と同一となる. 遅延読み込みの場合は無視される.
+	 * @param value 並列に行う場合は <code>true</code> を指定する.
+	 */
+	void parallel(bool value);
+
+	/**
+	 * @brief 読み込む内容を限定するためのオプションを取得する.
+	 * @return オプション.
+	 */
+	Options const& options() const;
+
+	/**
+	 * @brief 読み込む内容を限定するためのオプションを設定する. 遅延読み込みの場合も, 各トラックの読み込みに適用される.
+	 * @param value オプション.
+	 */
+	void options(Options const& value);
+
 LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	/**
 	 * @brief テキストストリームからイベントの内容を読み込み初期化する.
@@ -46,6 +46,34 @@ public:
 	 */
 	void write(Sequence const& sequence, OutputStream& stream, int msPreSend, std::string const& encoding, bool printPitch = false);
 
+	/**
+	 * @brief トラックのエンコードを並列に行うかどうかを取得する.
+	 * @return 並列に行う場合は <code>true</code> を返す.
+	 */
+	bool parallel() const;
+
+	/**
+	 * @brief トラックのエンコードを並列に行うかどうかを設定する.
+	 * @details <code>true</code> を設定すると, 各トラックの MTrk チャンクをワーカースレッド上でそれぞれ別のメモリバッファにエンコードし,
+	 *          トラック順にストリームへ書き出す. 出力されるバイト列は並列化しない場合と同一となる.
+	 * @param value 並列に行う場合は <code>true</code> を指定する.
+	 */
+	void parallel(bool value);
+
+	/**
+	 * @brief ランニングステータスを使って出力するかどうかを取得する.
+	 * @return ランニングステータスを使う場合は <code>true</code> を返す.
+	 */
+	bool runningStatus() const;
+
+	/**
+	 * @brief ランニングステータスを使って出力するかどうかを設定する.
+	 * @details <code>true</code> を設定すると, 各トラックの NRPN のコントロールチェンジのうち, 先頭以外のステータスバイトを省略して出力する.
+	 *          デフォルトは <code>false</code> で, 全てのイベントにステータスバイトを出力する.
+	 * @param value ランニングステータスを使う場合は <code>true</code> を指定する.
+	 */
+	void runningStatus(bool value);
+
 LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	/**
 	 * @brief ハンドルをストリームに書き込む.
@@ -71,7 +99,7 @@ LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	 * @param master 出力する Master 情報. 出力しない場合は NULL を指定する.
 	 * @param mixer 出力する Mixer 情報. 出力しない場合は NULL を指定する.
 	 */
-	void _printMetaText(Track const& track, TextStream& stream, int eos, tick_t start, bool printPitch = false, Master* master = 0, Mixer* mixer = 0);
+	void _printMetaText(Track const& track, TextStream& stream, int eos, tick_t start, bool printPitch = false, Master const* master = 0, Mixer const* mixer = 0);
 
 	/**
 	 * @brief 文字列を MIDI メタイベントにしたものを取得する.
@@ -23,6 +23,7 @@ class Track;
 class TempoList;
 class Event;
 class BPList;
+class NrpnEventBuffer;
 
 /**
  * @brief \~japanese-en Track オブジェクトから NRPN リストを作成するファクトリクラス. この NRPN は VOCALOID VSTi で使用される.
@@ -30,6 +31,8 @@ class BPList;
  */
 class VocaloidMidiEventListFactory
 {
+	friend class IncrementalNrpnGenerator;
+
 private:
 	/**
 	 * @brief \~japanese-en BPList オブジェクトから, 対応するコントロールカーブのディレイを表す NrpnEvent と,
@@ -124,6 +127,83 @@ public:
 	static std::vector<MidiEvent> generateMidiEventList(
 		Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend);
 
+	/**
+	 * @brief \~japanese-en 指定されたトラックから NRPN のレコードを生成し, 出力順にソートしたバッファーに格納する.
+	 *        \~english Generate NRPN records from a specified track into a flat buffer, sorted in output order.
+	 * @param dest \~japanese-en 格納先のバッファー. 元の内容は破棄されるが, 確保済みの領域は再利用される.
+	 *             \~english A buffer to store the records. Its previous content is discarded, but its capacity is reused.
+	 * @param target \~japanese-en Track のオブジェクト.
+	 *               \~english An instance of Track.
+	 * @param tempoList \~japanese-en テンポ情報.
+	 *                  \~english Tempo information.
+	 * @param totalTicks \~japanese-en Tick 単位のシーケンスの長さ.
+	 *                   \~english Length of the sequence (in tick unit).
+	 * @param preMeasureTicks \~japanese-en Tick 単位のプリメジャーの長さ.
+	 *                        \~english Length of pre-measure (in tick unit).
+	 * @param msPreSend \~japanese-en ミリ秒単位のプリセンドタイム.
+	 *                  \~english Length of pre-send time in milli seconds.
+	 */
+	static void generateNRPN(
+		NrpnEventBuffer& dest,
+		Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend);
+
+	/**
+	 * @brief \~japanese-en 指定されたトラックの指定された範囲から, VOCALOID MIDI イベントのリストを生成する.
+	 *        \~english Generate a list of VOCALOID MIDI event from a specified range of a specified track.
+	 * @details \~japanese-en generateNRPN の範囲指定版と同じ NRPN を, MIDI イベントに変換したものを返す.
+	 *          \~english Returns the NRPN of the ranged version of generateNRPN, converted to MIDI events.
+	 * @param target \~japanese-en Track のオブジェクト.
+	 *               \~english An instance of Track.
+	 * @param tempoList \~japanese-en テンポ情報.
+	 *                  \~english Tempo information.
+	 * @param totalTicks \~japanese-en Tick 単位のシーケンスの長さ.
+	 *                   \~english Length of the sequence (in tick unit).
+	 * @param preMeasureTicks \~japanese-en Tick 単位のプリメジャーの長さ.
+	 *                        \~english Length of pre-measure (in tick unit).
+	 * @param msPreSend \~japanese-en ミリ秒単位のプリセンドタイム.
+	 *                  \~english Length of pre-send time in milli seconds.
+	 * @param startTick \~japanese-en Tick 単位の, 出力範囲の開始時刻.
+	 *                  \~english Start of the range (in tick unit).
+	 * @param endTick \~japanese-en Tick 単位の, 出力範囲の終了時刻. この時刻は範囲に含まない.
+	 *                \~english End of the range (in tick unit, exclusive).
+	 * @return \~japanese-en VOCALOID MIDI イベントのリスト.
+	 *         \~english A list of VOCALOID MIDI event.
+	 */
+	static std::vector<MidiEvent> generateMidiEventList(
+		Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend,
+		tick_t startTick, tick_t endTick);
+
+	/**
+	 * @brief \~japanese-en 指定されたトラックの指定された範囲から NRPN のレコードを生成し, 出力順にソートしたバッファーに格納する.
+	 *        \~english Generate NRPN records from a specified range of a specified track into a flat buffer, sorted in output order.
+	 * @details \~japanese-en 範囲内に時刻があるイベントとデータ点だけを二分探索で探して出力するため, 処理時間は範囲の位置に依存しない.
+	 *          開始時刻の時点で有効な歌手と, 各コントロールカーブの開始時刻の時点での値を, 開始時刻のイベントとして先頭に出力する.
+	 *          delay は範囲の先頭から出力し直す.
+	 *          \~english Events and data points are located by binary search, so the cost does not depend on where the range starts.
+	 *          The singer and the control curve values in effect at the start of the range are output at the start of the range.
+	 *          Delay values are output again from the start of the range.
+	 * @param dest \~japanese-en 格納先のバッファー. 元の内容は破棄される.
+	 *             \~english A buffer to store the records. Its previous content is discarded.
+	 * @param target \~japanese-en Track のオブジェクト.
+	 *               \~english An instance of Track.
+	 * @param tempoList \~japanese-en テンポ情報.
+	 *                  \~english Tempo information.
+	 * @param totalTicks \~japanese-en Tick 単位のシーケンスの長さ.
+	 *                   \~english Length of the sequence (in tick unit).
+	 * @param preMeasureTicks \~japanese-en Tick 単位のプリメジャーの長さ.
+	 *                        \~english Length of pre-measure (in tick unit).
+	 * @param msPreSend \~japanese-en ミリ秒単位のプリセンドタイム.
+	 *                  \~english Length of pre-send time in milli seconds.
+	 * @param startTick \~japanese-en Tick 単位の, 出力範囲の開始時刻.
+	 *                  \~english Start of the range (in tick unit).
+	 * @param endTick \~japanese-en Tick 単位の, 出力範囲の終了時刻. この時刻は範囲に含まない.
+	 *                \~english End of the range (in tick unit, exclusive).
+	 */
+	static void generateNRPN(
+		NrpnEventBuffer& dest,
+		Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend,
+		tick_t startTick, tick_t endTick);
+
 LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	/**
 	 * @brief Generate a list of NrpnEvent from a specified track.
@@ -248,20 +328,140 @@ LIBVSQ_PRIVATE_BUT_PUBLIC_FOR_UNITTEST:
 	static void _getMsbAndLsb(int value, int* msb, int* lsb);
 
 private:
+	/**
+	 * @brief generateExpressionNRPN と同じ NRPN を, バッファーの末尾に追加する.
+	 */
+	static void generateExpressionNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int preSendMilliseconds);
+
+	/**
+	 * @brief generateSingerNRPN と同じ NRPN を, バッファーの末尾に追加する.
+	 */
+	static void generateSingerNRPN(NrpnEventBuffer& dest, TempoList const& tempoList, Event const& singerEvent, int preSendMilliseconds);
+
+	/**
+	 * @brief generateNoteNRPN と同じ NRPN を, 1 つのグループとしてバッファーの末尾に追加する.
+	 */
+	static void generateNoteNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, Event const& noteEvent, int msPreSend, int noteLocation, int* lastDelay, int* delay);
+
+	/**
+	 * @brief generatePitchBendNRPN と同じ NRPN を, バッファーの末尾に追加する.
+	 */
+	static void generatePitchBendNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int msPreSend);
+
+	/**
+	 * @brief generatePitchBendSensitivityNRPN と同じ NRPN を, バッファーの末尾に追加する.
+	 */
+	static void generatePitchBendSensitivityNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int msPreSend);
+
+	/**
+	 * @brief generateVibratoNRPN と同じ NRPN を, ソートせずにバッファーの末尾に追加する.
+	 */
+	static void generateVibratoNRPN(NrpnEventBuffer& dest, TempoList const& tempoList, Event const& noteEvent, int msPreSend);
+
+	/**
+	 * @brief generateVoiceChangeParameterNRPN と同じ NRPN を, ソートせずにバッファーの末尾に追加する.
+	 */
+	static void generateVoiceChangeParameterNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int msPreSend, tick_t preMeasureTicks);
+
+	/**
+	 * @brief generateFx2DepthNRPN と同じ NRPN を, バッファーの末尾に追加する.
+	 */
+	static void generateFx2DepthNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int preSendMilliseconds);
+
+	/**
+	 * @brief Voice Change Parameter の NRPN を, バッファーの末尾に追加する.
+	 * @param begin 出力するデータ点の最初のインデックス.
+	 * @param end 出力するデータ点の最後のインデックスの次.
+	 * @return delay 値(ミリ秒単位).
+	 */
+	static int addVoiceChangeParameters(NrpnEventBuffer& dest, BPList const& list, TempoList const& tempoList, int msPreSend, int lastDelay, int begin, int end);
+
+	/**
+	 * @brief Voice Change Parameter の 1 つのデータ点の NRPN を, バッファーの末尾に追加する.
+	 * @param id Voice Change Parameter の ID.
+	 * @param tick データ点の Tick 単位の時刻.
+	 * @param value データ点の値.
+	 * @return delay 値(ミリ秒単位).
+	 */
+	static int addVoiceChangeParameter(NrpnEventBuffer& dest, int id, tick_t tick, int value, TempoList const& tempoList, int msPreSend, int lastDelay);
+
 	/**
 	 * @brief データ点のリストから, NRPN のリストを作成する.
 	 * @param[out] result 作成した NRPN のリストの格納先.
 	 * @param tempoList テンポ情報.
 	 * @param preSendMilliseconds ミリ秒単位のプリセンド秒.
 	 * @param list NRPN リストの元になるデータのリスト.
-	 * @param delayNrpnType delay を指定する際の NRPN のタイプ.
-	 * @param nrpnType データ点の値を指定する際の NRPN のタイプ.
+	 * @param provider delay と値の NRPN を作成するオブジェクト.
+	 * @param begin 出力するデータ点の最初のインデックス.
+	 * @param end 出力するデータ点の最後のインデックスの次.
+	 * @param lastDelay 直前のデータ点の delay 値(ミリ秒単位). 先頭から出力する場合は 0 を指定する.
+	 * @return 最後に出力したデータ点の delay 値(ミリ秒単位).
+	 */
+	static int generateNRPNByBPList(
+		NrpnEventBuffer& result,
+		TempoList const& tempoList, int preSendMilliseconds,
+		BPList const& list, NrpnEventProvider const& provider,
+		int begin, int end, int lastDelay
+	);
+
+	/**
+	 * @brief データ点のリストのうち, 指定した範囲にあるデータ点から NRPN のリストを作成する.
+	 * @details 開始時刻にデータ点が無い場合は, 開始時刻の時点で有効な値を開始時刻のデータ点として出力する.
+	 * @param startTick Tick 単位の, 範囲の開始時刻.
+	 * @param endTick Tick 単位の, 範囲の終了時刻. この時刻は範囲に含まない.
 	 */
 	static void generateNRPNByBPList(
-		std::vector<NrpnEvent>& result,
+		NrpnEventBuffer& result,
+		TempoList const& tempoList, int preSendMilliseconds,
+		BPList const& list, NrpnEventProvider const& provider,
+		tick_t startTick, tick_t endTick
+	);
+
+	/**
+	 * @brief 1 つのデータ点から NRPN を作成する.
+	 * @param tick データ点の Tick 単位の時刻.
+	 * @param value データ点の値.
+	 * @param lastDelay 直前のデータ点の delay 値(ミリ秒単位).
+	 * @return このデータ点の delay 値(ミリ秒単位).
+	 */
+	static int generateNRPNByBP(
+		NrpnEventBuffer& result,
 		TempoList const& tempoList, int preSendMilliseconds,
-		BPList const& list, NrpnEventProvider const& provider
+		tick_t tick, int value, NrpnEventProvider const& provider, int lastDelay
 	);
+
+	/**
+	 * @brief NRPN の出力対象となるイベントのインデックスの範囲を取得する.
+	 * @param track 出力元のトラック.
+	 * @param totalTicks Tick 単位のシーケンスの長さ.
+	 * @param[out] start 最初のイベントのインデックス.
+	 * @param[out] end 最後のイベントのインデックス.
+	 */
+	static void getEventRange(Track const& track, tick_t totalTicks, int* start, int* end);
+
+	/**
+	 * @brief トラックの先頭で有効な歌手変更イベントを検索する.
+	 * @param track 検索対象のトラック.
+	 * @param noteStart getEventRange で得られる最初のイベントのインデックス.
+	 * @return 歌手変更イベントのインデックス. 見つからなければ負の値を返す.
+	 */
+	static int findFirstSingerEvent(Track const& track, int noteStart);
+
+	/**
+	 * @brief 音符イベントの, 前後の音符との接続関係を取得する.
+	 * @param track 音符イベントを含むトラック.
+	 * @param index 音符イベントのインデックス.
+	 * @param lastNoteEnd 直前の音符イベントの Tick 単位の終了時刻. 直前の音符イベントが無い場合は 0 を指定する.
+	 * @return generateNoteNRPN の noteLocation に指定する値.
+	 */
+	static int getNoteLocation(Track const& track, int index, tick_t lastNoteEnd);
+
+	/**
+	 * @brief 指定した音源で出力対象となる Voice Change Parameter のカーブ名を, 出力順に取得する.
+	 * @param renderer 音源の名前.
+	 * @return カーブ名のリスト.
+	 */
+	static std::vector<std::string> getVoiceChangeParameterCurveNames(std::string const& renderer);
 };
 
 LIBVSQ_END_NAMESPACE
@@ -22,6 +22,9 @@
 #include "./BPList.hpp"
 #include "./BPListSearchResult.hpp"
 #include "./BitConverter.hpp"
+#include "./BufferedInputStream.hpp"
+#include "./BufferedOutputStream.hpp"
+#include "./ByteArrayInputStream.hpp"
 #include "./ByteArrayOutputStream.hpp"
 #include "./CP932Converter.hpp"
 #include "./Common.hpp"
@@ -34,11 +37,14 @@
 #include "./FileOutputStream.hpp"
 #include "./Handle.hpp"
 #include "./HandleType.hpp"
+#include "./IncrementalNrpnGenerator.hpp"
 #include "./InputStream.hpp"
 #include "./Lyric.hpp"
+#include "./MappedFileInputStream.hpp"
 #include "./Master.hpp"
 #include "./MeasureLine.hpp"
 #include "./MeasureLineIterator.hpp"
+#include "./MetaTextLexer.hpp"
 #include "./MidiEvent.hpp"
 #include "./MidiParameterType.hpp"
 #include "./Mixer.hpp"
@@ -46,6 +52,7 @@
 #include "./MusicXmlWriter.hpp"
 #include "./NoteNumberUtil.hpp"
 #include "./NrpnEvent.hpp"
+#include "./NrpnEventBuffer.hpp"
 #include "./OutputStream.hpp"
 #include "./PhoneticSymbol.hpp"
 #include "./PhoneticSymbolDictionary.hpp"
@@ -58,9 +65,11 @@
 #include "./TempoList.hpp"
 #include "./TextOutputStream.hpp"
 #include "./TextStream.hpp"
+#include "./ThreadUtil.hpp"
 #include "./Timesig.hpp"
 #include "./TimesigList.hpp"
 #include "./Track.hpp"
+#include "./VSQContentHandler.hpp"
 #include "./VSQFileReader.hpp"
 #include "./VSQFileWriter.hpp"
 #include "./VibratoBP.hpp"
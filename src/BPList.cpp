@@ -14,6 +14,7 @@
 #include "../include/libvsq/BPList.hpp"
 #include "../include/libvsq/StringUtil.hpp"
 #include "../include/libvsq/TextStream.hpp"
+#include "../include/libvsq/MetaTextLexer.hpp"
 #include <cmath>
 #include <sstream>
 #include <algorithm>
@@ -245,6 +246,11 @@ tick_t BPList::keyTickAt(int index) const
 	return _ticks[index];
 }
 
+int BPList::lowerBound(tick_t tick) const
+{
+	return std::lower_bound(_ticks.begin(), _ticks.begin() + _length, tick) - _ticks.begin();
+}
+
 int BPList::findValueFromId(int id) const
 {
 	for (int i = 0; i < _length; i++) {
@@ -320,70 +326,53 @@ void BPList::print(TextStream& stream, tick_t startTick, std::string const& head
 
 std::string BPList::appendFromText(TextStream& reader)
 {
-	tick_t tick = 0;
-	int value = 0;
+	MetaTextLexer lexer(reader);
+	appendFromText(lexer);
+	if (lexer.line().startsWith('[')) {
+		return lexer.line().toString();
+	} else {
+		return "";
+	}
+}
+
+void BPList::appendFromText(MetaTextLexer& lexer)
+{
+	while (lexer.ready()) {
+		lexer.next();
+		MetaTextLexer::Range const& line = lexer.line();
+		if (line.startsWith('[')) {
+			break;
+		}
+		tick_t tick;
+		int value;
+		if (parsePoint(line.begin, line.end, tick, value)) {
+			addWithoutSort(tick, value);
+		}
+	}
+}
+
+bool BPList::parsePoint(char const* begin, char const* end, tick_t& tick, int& value)
+{
+	tick = 0;
+	value = 0;
 	int minus = 1;
-	int mode = 0; // 0: tickを読んでいる, 1: valueを読んでいる
-	while (reader.ready()) {
-		std::string ch = reader.get();
-		if (ch == "\n") {
-			if (mode == 1) {
-				addWithoutSort(tick, value * minus);
-				mode = 0;
-				tick = 0;
-				value = 0;
-				minus = 1;
-			}
-		} else {
-			if (ch == "[") {
-				if (mode == 1) {
-					addWithoutSort(tick, value * minus);
-					mode = 0;
-					tick = 0;
-					value = 0;
-					minus = 1;
-				}
-				reader.setPointer(reader.getPointer() - 1);
-				break;
-			}
-			if (ch == "=") {
-				mode = 1;
-			} else if (ch == "-") {
-				minus = -1;
+	bool hasValue = false;
+	for (char const* p = begin; p < end; ++p) {
+		char const c = *p;
+		if (c == '=') {
+			hasValue = true;
+		} else if (c == '-') {
+			minus = -1;
+		} else if ('0' <= c && c <= '9') {
+			if (hasValue) {
+				value = value * 10 + (c - '0');
 			} else {
-				int num = -1;
-				if (ch == "0") {
-					num = 0;
-				} else if (ch == "1") {
-					num = 1;
-				} else if (ch == "2") {
-					num = 2;
-				} else if (ch == "3") {
-					num = 3;
-				} else if (ch == "4") {
-					num = 4;
-				} else if (ch == "5") {
-					num = 5;
-				} else if (ch == "6") {
-					num = 6;
-				} else if (ch == "7") {
-					num = 7;
-				} else if (ch == "8") {
-					num = 8;
-				} else if (ch == "9") {
-					num = 9;
-				}
-				if (num >= 0) {
-					if (mode == 0) {
-						tick = tick * 10 + num;
-					} else {
-						value = value * 10 + num;
-					}
-				}
+				tick = tick * 10 + (c - '0');
 			}
 		}
 	}
-	return reader.readLine();
+	value *= minus;
+	return hasValue;
 }
 
 int BPList::size() const
@@ -0,0 +1,109 @@
+﻿/**
+ * @file BufferedInputStream.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/BufferedInputStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+const int BufferedInputStream::DEFAULT_BUFFER_LENGTH;
+
+BufferedInputStream::BufferedInputStream(InputStream& stream, int bufferLength)
+	: _stream(stream)
+	, _buffer(std::max(1, bufferLength))
+	, _start(stream.getPointer())
+	, _index(0)
+	, _count(0)
+{}
+
+BufferedInputStream::~BufferedInputStream()
+{
+	if (_index < _count) {
+		_stream.seek(_start + _index);
+	}
+}
+
+size_t BufferedInputStream::read(char* buffer, int64_t startIndex, int64_t length)
+{
+	if (length <= 0) {
+		return 0;
+	}
+	size_t const available = _count - _index;
+	if ((size_t)length <= available) {
+		::memcpy(buffer + startIndex, _buffer.data() + _index, length);
+		_index += length;
+		return length;
+	}
+
+	// バッファーに残っている分を読み込んだ後, 残りを読み込む
+	::memcpy(buffer + startIndex, _buffer.data() + _index, available);
+	_start += _count;
+	_index = 0;
+	_count = 0;
+	int64_t const remain = length - available;
+	if (remain < (int64_t)_buffer.size()) {
+		fill();
+		size_t const amount = std::min((size_t)remain, _count);
+		::memcpy(buffer + startIndex + available, _buffer.data(), amount);
+		_index = amount;
+		return available + amount;
+	} else {
+		size_t const amount = _stream.read(buffer, startIndex + available, remain);
+		_start += amount;
+		return available + amount;
+	}
+}
+
+void BufferedInputStream::seek(int64_t position)
+{
+	if (_start <= position && position <= _start + (int64_t)_count) {
+		_index = position - _start;
+		return;
+	}
+	_stream.seek(position);
+	_start = position;
+	_index = 0;
+	_count = 0;
+}
+
+void BufferedInputStream::close()
+{
+	_stream.close();
+	_index = 0;
+	_count = 0;
+}
+
+uint8_t const* BufferedInputStream::data() const
+{
+	return _stream.data();
+}
+
+int64_t BufferedInputStream::length() const
+{
+	return _stream.length();
+}
+
+bool BufferedInputStream::fill()
+{
+	_start += _index;
+	if (_index < _count) {
+		// 先読みした範囲の途中から読み込み直す
+		_stream.seek(_start);
+	}
+	_index = 0;
+	_count = _stream.read(_buffer.data(), 0, _buffer.size());
+	return 0 < _count;
+}
+
+LIBVSQ_END_NAMESPACE
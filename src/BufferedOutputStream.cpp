@@ -0,0 +1,86 @@
+﻿/**
+ * @file BufferedOutputStream.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/BufferedOutputStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+const int BufferedOutputStream::DEFAULT_BUFFER_LENGTH;
+
+BufferedOutputStream::BufferedOutputStream(OutputStream& stream, int bufferLength)
+	: _stream(stream)
+	, _buffer(std::max(1, bufferLength))
+	, _start(stream.getPointer())
+	, _cursor(0)
+	, _count(0)
+{}
+
+BufferedOutputStream::~BufferedOutputStream()
+{}
+
+void BufferedOutputStream::write(char const* buffer, int64_t startIndex, int64_t length)
+{
+	if (length <= 0) {
+		return;
+	}
+	size_t const capacity = _buffer.size();
+	if (_cursor + length <= capacity) {
+		::memcpy(_buffer.data() + _cursor, buffer + startIndex, length);
+		_cursor += length;
+		_count = std::max(_count, _cursor);
+		return;
+	}
+	flush();
+	if (length < (int64_t)capacity) {
+		::memcpy(_buffer.data(), buffer + startIndex, length);
+		_cursor = _count = length;
+	} else {
+		_stream.write(buffer, startIndex, length);
+		_start += length;
+	}
+}
+
+void BufferedOutputStream::seek(int64_t position)
+{
+	if (_start <= position && position <= _start + (int64_t)_count) {
+		_cursor = position - _start;
+		return;
+	}
+	flush();
+	_stream.seek(position);
+	_start = position;
+}
+
+void BufferedOutputStream::close()
+{
+	flush();
+	_stream.close();
+}
+
+void BufferedOutputStream::flush()
+{
+	if (_count == 0) {
+		return;
+	}
+	_stream.write(_buffer.data(), 0, _count);
+	if (_cursor != _count) {
+		_stream.seek(_start + _cursor);
+	}
+	_start += _cursor;
+	_cursor = 0;
+	_count = 0;
+}
+
+LIBVSQ_END_NAMESPACE
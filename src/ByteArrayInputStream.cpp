@@ -0,0 +1,77 @@
+﻿/**
+ * @file ByteArrayInputStream.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/ByteArrayInputStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+ByteArrayInputStream::ByteArrayInputStream(uint8_t const* data, int64_t length)
+	: _data(data)
+	, _length(data ? std::max((int64_t)0, length) : 0)
+	, _pointer(0)
+{}
+
+ByteArrayInputStream::ByteArrayInputStream(char const* data, int64_t length)
+	: ByteArrayInputStream(reinterpret_cast<uint8_t const*>(data), length)
+{}
+
+int ByteArrayInputStream::read()
+{
+	if (0 <= _pointer && _pointer < _length) {
+		return _data[_pointer++];
+	} else {
+		return -1;
+	}
+}
+
+size_t ByteArrayInputStream::read(char* buffer, int64_t startIndex, int64_t length)
+{
+	if (_pointer < 0 || _length <= _pointer || length <= 0) {
+		return 0;
+	}
+	int64_t const amount = std::min(length, _length - _pointer);
+	::memcpy(buffer + startIndex, _data + _pointer, amount);
+	_pointer += amount;
+	return static_cast<size_t>(amount);
+}
+
+void ByteArrayInputStream::seek(int64_t position)
+{
+	_pointer = position;
+}
+
+int64_t ByteArrayInputStream::getPointer()
+{
+	return _pointer;
+}
+
+void ByteArrayInputStream::close()
+{
+	_data = nullptr;
+	_length = 0;
+	_pointer = 0;
+}
+
+uint8_t const* ByteArrayInputStream::data() const
+{
+	return _data;
+}
+
+int64_t ByteArrayInputStream::length() const
+{
+	return _length;
+}
+
+LIBVSQ_END_NAMESPACE
@@ -20,9 +20,7 @@ LIBVSQ_BEGIN_NAMESPACE
 ByteArrayOutputStream::ByteArrayOutputStream()
 {
 	_pointer = 0;
-	_arrayLength = UNIT_BUFFER_LENGTH;
-	_array.resize(static_cast<size_t>(_arrayLength));
-	_length = 0;
+	_array.reserve(static_cast<size_t>(UNIT_BUFFER_LENGTH));
 }
 
 ByteArrayOutputStream::~ByteArrayOutputStream()
@@ -32,28 +30,53 @@ ByteArrayOutputStream::~ByteArrayOutputStream()
 
 void ByteArrayOutputStream::write(int byte)
 {
-	ensureBufferLength(_pointer + 1);
-	_array[static_cast<size_t>(_pointer)] = (char)byte;
+	extendTo(_pointer);
+	size_t const position = static_cast<size_t>(_pointer);
+	if (position < _array.size()) {
+		_array[position] = (char)byte;
+	} else {
+		_array.push_back((char)byte);
+	}
 	_pointer++;
-	_length = std::max(_length, _pointer);
 }
 
 void ByteArrayOutputStream::write(char const* array, int64_t startIndex, int64_t length)
 {
-	ensureBufferLength(_pointer + length);
-	for (int i = 0; i < length; i++) {
-		_array[static_cast<size_t>(_pointer + i)] = array[startIndex + i];
+	if (length <= 0) {
+		return;
 	}
+	extendTo(_pointer);
+	// 書き込み済みの範囲は上書きし, 残りを末尾に追加する
+	char const* first = array + startIndex;
+	char const* last = first + length;
+	size_t const position = static_cast<size_t>(_pointer);
+	size_t const overwrite = std::min(static_cast<size_t>(length), _array.size() - position);
+	std::copy(first, first + overwrite, _array.begin() + position);
+	_array.insert(_array.end(), first + overwrite, last);
 	_pointer += length;
-	_length = std::max(_length, _pointer);
 }
 
 std::string ByteArrayOutputStream::toString() const
 {
-	std::string result(_array.data(), static_cast<size_t>(_length));
+	std::string result(_array.data(), _array.size());
+	return result;
+}
+
+std::vector<char> ByteArrayOutputStream::release()
+{
+	std::vector<char> result;
+	result.swap(_array);
+	_pointer = 0;
 	return result;
 }
 
+void ByteArrayOutputStream::reserve(int64_t capacity)
+{
+	if (0 < capacity) {
+		_array.reserve(static_cast<size_t>(capacity));
+	}
+}
+
 int64_t ByteArrayOutputStream::getPointer()
 {
 	return _pointer;
@@ -66,16 +89,13 @@ void ByteArrayOutputStream::seek(int64_t position)
 
 void ByteArrayOutputStream::close()
 {
-	_length = 0;
-	_arrayLength = 0;
+	_array.clear();
 }
 
-void ByteArrayOutputStream::ensureBufferLength(int64_t length)
+void ByteArrayOutputStream::extendTo(int64_t length)
 {
-	int64_t amount = length - _arrayLength;
-	if (0 < amount) {
-		_arrayLength = length;
-		_array.resize(static_cast<size_t>(_arrayLength));
+	if (static_cast<int64_t>(_array.size()) < length) {
+		_array.resize(static_cast<size_t>(length));
 	}
 }
 
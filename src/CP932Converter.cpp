@@ -13,6 +13,8 @@
  */
 #include "../include/libvsq/CP932Converter.hpp"
 #include <sstream>
+#include <mutex>
+#include <cstring>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -21,11 +23,10 @@ std::string CP932Converter::convertFromUTF8(std::string const& utf8)
 	std::vector<std::vector<int>> utf8codes = _getUnicodeBytesFromUTF8String(utf8);
 	std::ostringstream result;
 	static int _unicode_to_cp932[256][256][2];
-	static int initialized = 0;
-	if (initialized == 0) {
+	static std::once_flag initialized;
+	std::call_once(initialized, []() {
 		initializeUnicodeToCp932Dictionary(_unicode_to_cp932);
-		initialized = 1;
-	}
+	});
 	for (int i = 0; i < utf8codes.size(); i++) {
 		std::vector<int> r = utf8codes[i];
 		if (r.size() == 1) {
@@ -48,34 +49,79 @@ std::string CP932Converter::convertFromUTF8(std::string const& utf8)
 
 std::string CP932Converter::convertToUTF8(std::string const& cp932)
 {
-	static int dict[0xFFFF];
-	static int initialized = 0;
-	if (initialized == 0) {
-		initializeCP932ToUTF8Dictionary(dict);
-		initialized = 1;
+	std::string result;
+	result.reserve(cp932.size());
+	_appendUTF8(_getCP932ToUTF8Dictionary(), cp932.data(), cp932.size(), result);
+	return result;
+}
+
+std::string CP932Converter::convertLinesToUTF8(std::string const& cp932)
+{
+	int const* dict = _getCP932ToUTF8Dictionary();
+	std::string result;
+	result.reserve(cp932.size() + cp932.size() / 4);
+	char const* data = cp932.data();
+	size_t const length = cp932.size();
+	size_t lineStart = 0;
+	while (lineStart < length) {
+		void const* lineFeed = ::memchr(data + lineStart, 0x0A, length - lineStart);
+		size_t lineEnd = lineFeed ? static_cast<char const*>(lineFeed) - data : length;
+		_appendUTF8(dict, data + lineStart, lineEnd - lineStart, result);
+		if (lineEnd < length) {
+			result.push_back((char)0x0A);
+		}
+		lineStart = lineEnd + 1;
 	}
-	std::ostringstream result;
-	int i = 0;
-	int length = cp932.size();
+	return result;
+}
+
+int const* CP932Converter::_getCP932ToUTF8Dictionary()
+{
+	// 2 バイトの組み合わせ 0xFFFF まで参照するため, 0x10000 要素確保する
+	static int dict[0x10000];
+	static std::once_flag initialized;
+	std::call_once(initialized, []() {
+		initializeCP932ToUTF8Dictionary(dict);
+	});
+	return dict;
+}
+
+void CP932Converter::_appendUTF8(int const* dict, char const* cp932, size_t length, std::string& result)
+{
+	size_t i = 0;
 	while (i < length) {
+		// 変換しても値が変わらない ASCII 文字の連続は, まとめてコピーする
+		size_t run = i;
+		while (run < length) {
+			int b = 0xFF & cp932[run];
+			if (b == 0 || 0x80 <= b || dict[b] != b) {
+				break;
+			}
+			run++;
+		}
+		if (i < run) {
+			result.append(cp932 + i, run - i);
+			i = run;
+			continue;
+		}
+
 		int b1 = 0xFF & cp932[i];
 		int b2 = 0;
 		if (i + 1 < length) { b2 = 0xFF & cp932[i + 1]; }
 		int b1b2 = (0xFF00 & (b1 << 8)) | (0xFF & b2);
 		int value;
 		if ((value = dict[b1]) != 0) {
-			result << (char)value;
+			result.push_back((char)value);
 			i++;
 		} else if ((value = dict[b1b2]) != 0) {
-			result << (char)(0xFF & (value >> 16));
-			result << (char)(0xFF & (value >> 8));
-			result << (char)(0xFF & value);
+			result.push_back((char)(0xFF & (value >> 16)));
+			result.push_back((char)(0xFF & (value >> 8)));
+			result.push_back((char)(0xFF & value));
 			i += 2;
 		} else {
 			i++;
 		}
 	}
-	return result.str();
 }
 
 std::vector<std::vector<int>> CP932Converter::_getUnicodeBytesFromUTF8String(std::string const& s)
@@ -69,6 +69,13 @@ void Event::List::setForId(int internalId, Event const& value)
 	}
 }
 
+int Event::List::lowerBound(tick_t tick) const
+{
+	return std::lower_bound(_events.begin(), _events.end(), tick, [](std::unique_ptr<Event> const & item, tick_t value) {
+		return item->tick < value;
+	}) - _events.begin();
+}
+
 void Event::List::sort()
 {
 	std::stable_sort(_events.begin(), _events.end(), [](std::unique_ptr<Event> const & a, std::unique_ptr<Event> const & b) {
@@ -118,6 +125,15 @@ int Event::List::add(Event const& item, int internalId)
 	return internalId;
 }
 
+void Event::List::addWithoutSort(Event&& item, int internalId)
+{
+	auto add = std::unique_ptr<Event>(new Event(std::move(item)));
+	add->id = internalId;
+
+	_events.push_back(std::move(add));
+	_ids.push_back(internalId);
+}
+
 void Event::List::removeAt(int index)
 {
 	updateIdList();
@@ -0,0 +1,546 @@
+﻿/**
+ * @file IncrementalNrpnGenerator.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/IncrementalNrpnGenerator.hpp"
+#include "../include/libvsq/VocaloidMidiEventListFactory.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
+#include "../include/libvsq/Track.hpp"
+#include "../include/libvsq/TempoList.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+class IncrementalNrpnGenerator::Impl
+{
+private:
+	typedef VocaloidMidiEventListFactory Factory;
+
+	/**
+	 * @brief NRPN の生成元の種類. VocaloidMidiEventListFactory::generateNRPN で生成される順に並べる.
+	 */
+	enum Category {
+		FIRST_SINGER = 0,
+		VOICE_CHANGE_PARAMETER,
+		FX2_DEPTH,
+		EXPRESSION,
+		PITCH_BEND_SENSITIVITY,
+		PITCH_BEND,
+		EVENT,
+		CATEGORY_COUNT,
+	};
+
+	/**
+	 * @brief Voice Change Parameter のカーブの個数の上限.
+	 */
+	static int const MAX_CURVES = 32;
+
+	/**
+	 * @brief NRPN のグループと, その生成元の情報.
+	 */
+	struct Group {
+		tick_t tick;
+		int nrpnMsb;
+		int category;
+		int curve;
+		tick_t sourceTick;
+		int order;
+		int seq;
+		bool singer;
+		int start;
+		int count;
+	};
+
+	/**
+	 * @brief 生成し直す生成元の, Tick 単位の時刻の範囲. start, last ともに範囲に含む.
+	 */
+	struct Range {
+		tick_t start;
+		tick_t last;
+	};
+
+public:
+	Impl()
+		: valid(false)
+		, dirty(false)
+		, dirtyStart(0)
+		, dirtyEnd(0)
+		, totalTicks(0)
+		, preMeasureTicks(0)
+		, msPreSend(0)
+		, regular(false)
+		, ranges(CATEGORY_COUNT * MAX_CURVES)
+		, track(0)
+		, tempoList(0)
+	{}
+
+	void invalidate()
+	{
+		valid = false;
+	}
+
+	void invalidate(tick_t startTick, tick_t endTick)
+	{
+		endTick = std::max(endTick, startTick + 1);
+		if (dirty) {
+			dirtyStart = std::min(dirtyStart, startTick);
+			dirtyEnd = std::max(dirtyEnd, endTick);
+		} else {
+			dirtyStart = startTick;
+			dirtyEnd = endTick;
+			dirty = true;
+		}
+	}
+
+	NrpnEventBuffer const& generate(Track const& track, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend)
+	{
+		bool const isRegular = isRegularEventRange(track, totalTicks);
+		bool const full = !valid || !regular || !isRegular || !isSameParameters(track, tempoList, totalTicks, preMeasureTicks, msPreSend);
+		if (full) {
+			storeParameters(track, tempoList, totalTicks, preMeasureTicks, msPreSend);
+			dirtyStart = std::numeric_limits<tick_t>::min();
+			dirtyEnd = std::numeric_limits<tick_t>::max();
+			stream.clear();
+			groups.clear();
+		} else if (!dirty) {
+			return stream;
+		}
+		regular = isRegular;
+
+		this->track = &track;
+		this->tempoList = &tempoList;
+		work.clear();
+		workGroups.clear();
+		for (std::vector<Range>& item : ranges) {
+			item.clear();
+		}
+
+		std::vector<std::string> curves = Factory::getVoiceChangeParameterCurveNames(version);
+		emitVoiceChangeParameters(curves);
+		if (version.substr(0, 4) == "DSB2") {
+			Factory::NrpnEventProvider provider(MidiParameterType::CC_FX2_DELAY, MidiParameterType::CC_FX2_EFFECT2_DEPTH);
+			emitCurve(FX2_DEPTH, *track.curve("fx2depth"), provider);
+		}
+		{
+			Factory::NrpnEventProvider provider(MidiParameterType::CC_E_DELAY, MidiParameterType::CC_E_EXPRESSION);
+			emitCurve(EXPRESSION, *track.curve("dyn"), provider);
+		}
+		{
+			Factory::PitchBendSensitivityNrpnEventProvider provider;
+			emitCurve(PITCH_BEND_SENSITIVITY, *track.curve("pbs"), provider);
+		}
+		{
+			Factory::PitchBendNrpnEventProvider provider;
+			emitCurve(PITCH_BEND, *track.curve("pit"), provider);
+		}
+		emitEvents();
+
+		splice();
+
+		this->track = 0;
+		this->tempoList = 0;
+		valid = true;
+		dirty = false;
+		return stream;
+	}
+
+private:
+	/**
+	 * @brief 音符の出力範囲が, VocaloidMidiEventListFactory::getEventRange の通常の条件で決まっているかどうかを調べる.
+	 * @details Tick が 0 以上のイベントが無い場合など, 範囲の端が時刻と無関係に決まる場合は, 差分での生成を行わない.
+	 */
+	static bool isRegularEventRange(Track const& track, tick_t totalTicks)
+	{
+		Event::List const& events = track.events();
+		if (events.size() == 0) {
+			return true;
+		}
+		int start, end;
+		Factory::getEventRange(track, totalTicks, &start, &end);
+		return 0 <= events.get(start)->tick && events.get(end)->tick <= totalTicks;
+	}
+
+	bool isSameParameters(Track const& track, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend) const
+	{
+		if (this->totalTicks != totalTicks || this->preMeasureTicks != preMeasureTicks || this->msPreSend != msPreSend) {
+			return false;
+		}
+		if (version != track.common().version) {
+			return false;
+		}
+		int const count = tempoList.size();
+		if (tempo.size() != count) {
+			return false;
+		}
+		for (int i = 0; i < count; i++) {
+			Tempo const& item = tempoList.get(i);
+			if (tempo[i].tick != item.tick || tempo[i].tempo != item.tempo) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void storeParameters(Track const& track, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend)
+	{
+		this->totalTicks = totalTicks;
+		this->preMeasureTicks = preMeasureTicks;
+		this->msPreSend = msPreSend;
+		version = track.common().version;
+		tempo.clear();
+		for (int i = 0; i < tempoList.size(); i++) {
+			tempo.push_back(tempoList.get(i));
+		}
+	}
+
+	/**
+	 * @brief 前回の生成結果のうち生成し直した部分を除き, 生成し直した NRPN と時刻順にマージする.
+	 */
+	void splice()
+	{
+		std::sort(workGroups.begin(), workGroups.end(), compareGroup);
+
+		merged.clear();
+		merged.reserve(stream.size() + work.size());
+		mergedGroups.clear();
+		mergedGroups.reserve(groups.size() + workGroups.size());
+
+		std::vector<Group>::const_iterator oldIt = groups.begin();
+		std::vector<Group>::const_iterator newIt = workGroups.begin();
+		while (true) {
+			while (oldIt != groups.end() && isRemoved(*oldIt)) {
+				++oldIt;
+			}
+			bool const hasOld = oldIt != groups.end();
+			bool const hasNew = newIt != workGroups.end();
+			if (!hasOld && !hasNew) {
+				break;
+			}
+			if (hasOld && (!hasNew || compareGroup(*oldIt, *newIt))) {
+				pushGroup(stream, *oldIt);
+				++oldIt;
+			} else {
+				pushGroup(work, *newIt);
+				++newIt;
+			}
+		}
+
+		std::swap(stream, merged);
+		groups.swap(mergedGroups);
+	}
+
+	void pushGroup(NrpnEventBuffer const& source, Group group)
+	{
+		int const start = merged.size();
+		merged.append(source, group.start, group.count);
+		group.start = start;
+		mergedGroups.push_back(group);
+	}
+
+	bool isRemoved(Group const& group) const
+	{
+		if (group.singer) {
+			return true;
+		}
+		for (Range const& range : ranges[group.category * MAX_CURVES + group.curve]) {
+			if (range.start <= group.sourceTick && group.sourceTick <= range.last) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @brief VocaloidMidiEventListFactory::generateNRPN のソート後の順序と同じになるよう, グループを比較する.
+	 * @details 時刻の昇順, NRPN MSB の降順で並べ, 同じ場合は生成元の生成順に並べる.
+	 */
+	static bool compareGroup(Group const& a, Group const& b)
+	{
+		if (a.tick != b.tick) {
+			return a.tick < b.tick;
+		}
+		if (a.nrpnMsb != b.nrpnMsb) {
+			return a.nrpnMsb > b.nrpnMsb;
+		}
+		if (a.category != b.category) {
+			return a.category < b.category;
+		}
+		if (a.curve != b.curve) {
+			return a.curve < b.curve;
+		}
+		if (a.sourceTick != b.sourceTick) {
+			return a.sourceTick < b.sourceTick;
+		}
+		if (a.order != b.order) {
+			return a.order < b.order;
+		}
+		return a.seq < b.seq;
+	}
+
+	void addRange(int category, int curve, tick_t start, tick_t last)
+	{
+		Range range;
+		range.start = start;
+		range.last = last;
+		ranges[category * MAX_CURVES + curve].push_back(range);
+	}
+
+	/**
+	 * @brief work の start 番目以降に生成したレコードをグループに分け, 生成元の情報を付けて記録する.
+	 */
+	void annotate(int start, int category, int curve, tick_t sourceTick, int order, bool singer)
+	{
+		int seq = 0;
+		for (int i = start; i < work.size(); i++) {
+			NrpnEventBuffer::Record const& record = work.get(i);
+			if (record.isGroupHead() || i == start) {
+				int const nrpn = static_cast<int>(record.nrpn);
+				Group group;
+				group.tick = record.tick;
+				group.nrpnMsb = (nrpn - (nrpn % 0x100)) / 0x100;
+				group.category = category;
+				group.curve = curve;
+				group.sourceTick = sourceTick;
+				group.order = order;
+				group.seq = seq++;
+				group.singer = singer;
+				group.start = i;
+				group.count = 0;
+				workGroups.push_back(group);
+			}
+			workGroups.back().count++;
+		}
+	}
+
+	int getDelay(tick_t tick) const
+	{
+		tick_t actualTick;
+		int delay;
+		Factory::_getActualTickAndDelay(*tempoList, tick, msPreSend, &actualTick, &delay);
+		return delay;
+	}
+
+	/**
+	 * @brief 同じ時刻のイベントの中での, 指定したイベントの順番を取得する.
+	 */
+	static int getOrder(Event::List const& events, int index)
+	{
+		tick_t const tick = events.get(index)->tick;
+		int order = 0;
+		while (0 < index - order && events.get(index - order - 1)->tick == tick) {
+			order++;
+		}
+		return order;
+	}
+
+	/**
+	 * @brief ディレイの値が前後のデータ点に依存しないカーブについて, 変更範囲と, その直後のデータ点の NRPN を生成する.
+	 */
+	void emitCurve(Category category, BPList const& list, Factory::NrpnEventProvider const& provider)
+	{
+		int const count = list.size();
+		int const begin = list.lowerBound(dirtyStart);
+		int const next = list.lowerBound(dirtyEnd);
+		int const end = std::min(next + 1, count);
+		addRange(category, 0, dirtyStart, next < count ? list.keyTickAt(next) : std::numeric_limits<tick_t>::max());
+
+		int lastDelay = 0 < begin ? getDelay(list.keyTickAt(begin - 1)) : 0;
+		for (int i = begin; i < end; i++) {
+			int const start = work.size();
+			lastDelay = Factory::generateNRPNByBPList(work, *tempoList, msPreSend, list, provider, i, i + 1, lastDelay);
+			annotate(start, category, 0, list.keyTickAt(i), 0, false);
+		}
+	}
+
+	/**
+	 * @brief Voice Change Parameter の NRPN を生成する.
+	 * @details Voice Change Parameter のディレイはカーブをまたいで引き継がれるため,
+	 *          それまでのカーブの最後のデータ点が変更範囲に含まれうる場合は, 次のカーブの最初のデータ点も生成し直す.
+	 */
+	void emitVoiceChangeParameters(std::vector<std::string> const& curves)
+	{
+		bool carryChanged = false;
+		bool hasCarry = false;
+		tick_t carryTick = 0;
+		for (int k = 0; k < curves.size(); k++) {
+			BPList const& list = *track->curve(curves[k]);
+			int const count = list.size();
+			int const begin = list.lowerBound(dirtyStart);
+			int const next = list.lowerBound(dirtyEnd);
+			int const end = std::min(next + 1, count);
+			int const carry = hasCarry ? getDelay(carryTick) : 0;
+
+			if (carryChanged && 0 < begin) {
+				addRange(VOICE_CHANGE_PARAMETER, k, list.keyTickAt(0), list.keyTickAt(0));
+				emitVoiceChangeParameter(k, list, 0, carry);
+			}
+			addRange(VOICE_CHANGE_PARAMETER, k, dirtyStart, next < count ? list.keyTickAt(next) : std::numeric_limits<tick_t>::max());
+			int lastDelay = 0 < begin ? getDelay(list.keyTickAt(begin - 1)) : carry;
+			for (int i = begin; i < end; i++) {
+				lastDelay = emitVoiceChangeParameter(k, list, i, lastDelay);
+			}
+
+			if (0 < count) {
+				hasCarry = true;
+				carryTick = list.keyTickAt(count - 1);
+			}
+			carryChanged = next == count;
+		}
+	}
+
+	int emitVoiceChangeParameter(int curve, BPList const& list, int index, int lastDelay)
+	{
+		int const start = work.size();
+		int const delay = Factory::addVoiceChangeParameters(work, list, *tempoList, msPreSend, lastDelay, index, index + 1);
+		annotate(start, VOICE_CHANGE_PARAMETER, curve, list.keyTickAt(index), 0, false);
+		return delay;
+	}
+
+	/**
+	 * @brief 歌手変更イベントと音符イベントの NRPN を生成する.
+	 * @details 歌手変更イベントは数が少なく, トラックの先頭の歌手の扱いが他のイベントに依存するため, 毎回全て生成し直す.
+	 *          音符イベントは前後の音符によって接続関係と delay が変わるため, 変更範囲の直前と直後の音符も生成し直す.
+	 */
+	void emitEvents()
+	{
+		Event::List const& events = track->events();
+		int const count = events.size();
+		int noteStart, noteEnd;
+		Factory::getEventRange(*track, totalTicks, &noteStart, &noteEnd);
+
+		int const singerEvent = Factory::findFirstSingerEvent(*track, noteStart);
+		int start = work.size();
+		if (singerEvent >= 0) {
+			Factory::generateSingerNRPN(work, *tempoList, *events.get(singerEvent), 0);
+		} else {
+			work.add(0, MidiParameterType::CC_BS_LANGUAGE_TYPE, 0x0);
+			work.add(0, MidiParameterType::PC_VOICE_TYPE, 0x0);
+		}
+		annotate(start, FIRST_SINGER, 0, 0, 0, true);
+		for (int i = noteStart + 1; i <= noteEnd; i++) {
+			Event const* item = events.get(i);
+			if (item->type() == EventType::SINGER && i != singerEvent) {
+				start = work.size();
+				Factory::generateSingerNRPN(work, *tempoList, *item, msPreSend);
+				annotate(start, EVENT, 0, item->tick, getOrder(events, i), true);
+			}
+		}
+
+		// 変更範囲の直前の音符から生成し直す
+		int first = std::max(noteStart, std::min(noteEnd + 1, events.lowerBound(dirtyStart)));
+		tick_t startTick = dirtyStart;
+		int previous = findPreviousNote(events, first, noteStart);
+		if (0 <= previous) {
+			startTick = events.get(previous)->tick;
+			first = std::max(noteStart, events.lowerBound(startTick));
+		}
+
+		// 変更範囲の直後の音符まで生成し直す
+		tick_t lastTick = std::numeric_limits<tick_t>::max();
+		for (int i = events.lowerBound(dirtyEnd); i < count; i++) {
+			if (events.get(i)->type() == EventType::NOTE) {
+				lastTick = events.get(i)->tick;
+				break;
+			}
+		}
+		addRange(EVENT, 0, startTick, lastTick);
+
+		int lastDelay = 0;
+		tick_t lastNoteEnd = 0;
+		previous = findPreviousNote(events, first, noteStart);
+		if (0 <= previous) {
+			Event const* item = events.get(previous);
+			lastDelay = getDelay(item->tick);
+			lastNoteEnd = item->tick + item->length();
+		}
+		for (int i = first; i <= noteEnd && events.get(i)->tick <= lastTick; i++) {
+			Event const* item = events.get(i);
+			if (item->type() != EventType::NOTE) {
+				continue;
+			}
+			int const noteLocation = Factory::getNoteLocation(*track, i, lastNoteEnd);
+			start = work.size();
+			int delay;
+			Factory::generateNoteNRPN(work, *track, *tempoList, *item, msPreSend, noteLocation, &lastDelay, &delay);
+			lastDelay = delay;
+			Factory::generateVibratoNRPN(work, *tempoList, *item, msPreSend);
+			annotate(start, EVENT, 0, item->tick, getOrder(events, i), false);
+			lastNoteEnd = item->tick + item->length();
+		}
+	}
+
+	/**
+	 * @brief [noteStart, index) の範囲で, 最後の音符イベントのインデックスを取得する. 見つからなければ負の値を返す.
+	 */
+	static int findPreviousNote(Event::List const& events, int index, int noteStart)
+	{
+		for (int i = index - 1; i >= noteStart; i--) {
+			if (events.get(i)->type() == EventType::NOTE) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+private:
+	NrpnEventBuffer stream;
+	std::vector<Group> groups;
+
+	NrpnEventBuffer work;
+	std::vector<Group> workGroups;
+
+	NrpnEventBuffer merged;
+	std::vector<Group> mergedGroups;
+
+	bool valid;
+	bool dirty;
+	tick_t dirtyStart;
+	tick_t dirtyEnd;
+
+	std::vector<Tempo> tempo;
+	std::string version;
+	tick_t totalTicks;
+	tick_t preMeasureTicks;
+	int msPreSend;
+	bool regular;
+
+	std::vector<std::vector<Range>> ranges;
+
+	Track const* track;
+	TempoList const* tempoList;
+};
+
+IncrementalNrpnGenerator::IncrementalNrpnGenerator()
+	: _impl(new Impl())
+{}
+
+IncrementalNrpnGenerator::~IncrementalNrpnGenerator()
+{}
+
+void IncrementalNrpnGenerator::invalidate()
+{
+	_impl->invalidate();
+}
+
+void IncrementalNrpnGenerator::invalidate(tick_t startTick, tick_t endTick)
+{
+	_impl->invalidate(startTick, endTick);
+}
+
+NrpnEventBuffer const& IncrementalNrpnGenerator::generate(Track const& track, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTicks, int msPreSend)
+{
+	return _impl->generate(track, tempoList, totalTicks, preMeasureTicks, msPreSend);
+}
+
+LIBVSQ_END_NAMESPACE
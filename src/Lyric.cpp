@@ -161,10 +161,34 @@ std::string Lyric::phoneticSymbol() const
 
 void Lyric::phoneticSymbol(std::string const& value)
 {
-	std::string s = StringUtil::replace(value, "  ", " ");
-	_phoneticSymbol = StringUtil::explode(" ", s);
-	for (int i = 0; i < _phoneticSymbol.size(); i++) {
-		_phoneticSymbol[i] = StringUtil::replace(_phoneticSymbol[i], "\\"  "\\", "\\");
+	phoneticSymbol(value.data(), value.data() + value.size());
+}
+
+void Lyric::phoneticSymbol(char const* begin, char const* end)
+{
+	_phoneticSymbol.clear();
+	char const* tokenBegin = begin;
+	while (true) {
+		char const* tokenEnd = tokenBegin;
+		while (tokenEnd < end && *tokenEnd != ' ') {
+			++tokenEnd;
+		}
+		_phoneticSymbol.push_back(std::string());
+		std::string& symbol = _phoneticSymbol.back();
+		symbol.reserve(tokenEnd - tokenBegin);
+		for (char const* p = tokenBegin; p < tokenEnd; ++p) {
+			if (*p == '\\' && p > tokenBegin && *(p - 1) == '\\') {
+				continue;
+			}
+			symbol.push_back(*p);
+		}
+		if (tokenEnd == end) {
+			break;
+		}
+		tokenBegin = tokenEnd;
+		while (tokenBegin < end && *tokenBegin == ' ') {
+			++tokenBegin;
+		}
 	}
 }
 
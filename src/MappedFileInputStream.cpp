@@ -0,0 +1,120 @@
+﻿/**
+ * @file MappedFileInputStream.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/MappedFileInputStream.hpp"
+#include <algorithm>
+#include <cstring>
+#if defined(_WIN32)
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+LIBVSQ_BEGIN_NAMESPACE
+
+MappedFileInputStream::MappedFileInputStream(std::string const& filePath)
+	: _data(nullptr)
+	, _length(0)
+	, _pointer(0)
+{
+#if defined(_WIN32)
+	std::ifstream stream(filePath.c_str(), std::ios::binary);
+	if (stream) {
+		_buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		if (!_buffer.empty()) {
+			_data = _buffer.data();
+			_length = _buffer.size();
+		}
+	}
+#else
+	int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+	struct stat status;
+	if (::fstat(fd, &status) == 0 && 0 < status.st_size) {
+		void* address = ::mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (address != MAP_FAILED) {
+			_data = static_cast<uint8_t const*>(address);
+			_length = status.st_size;
+		}
+	}
+	// マップはファイルディスクリプターを閉じた後も有効
+	::close(fd);
+#endif
+}
+
+MappedFileInputStream::~MappedFileInputStream()
+{
+	close();
+}
+
+int MappedFileInputStream::read()
+{
+	if (0 <= _pointer && _pointer < _length) {
+		return _data[_pointer++];
+	} else {
+		return -1;
+	}
+}
+
+size_t MappedFileInputStream::read(char* buffer, int64_t startIndex, int64_t length)
+{
+	if (_pointer < 0 || _length <= _pointer || length <= 0) {
+		return 0;
+	}
+	int64_t const amount = std::min(length, _length - _pointer);
+	::memcpy(buffer + startIndex, _data + _pointer, amount);
+	_pointer += amount;
+	return static_cast<size_t>(amount);
+}
+
+void MappedFileInputStream::seek(int64_t position)
+{
+	_pointer = position;
+}
+
+int64_t MappedFileInputStream::getPointer()
+{
+	return _pointer;
+}
+
+void MappedFileInputStream::close()
+{
+#if defined(_WIN32)
+	_buffer.clear();
+#else
+	if (_data) {
+		::munmap(const_cast<uint8_t*>(_data), _length);
+	}
+#endif
+	_data = nullptr;
+	_length = 0;
+	_pointer = 0;
+}
+
+uint8_t const* MappedFileInputStream::data() const
+{
+	return _data;
+}
+
+int64_t MappedFileInputStream::length() const
+{
+	return _length;
+}
+
+LIBVSQ_END_NAMESPACE
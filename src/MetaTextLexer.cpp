@@ -0,0 +1,43 @@
+﻿/**
+ * @file MetaTextLexer.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/MetaTextLexer.hpp"
+#include "../include/libvsq/TextStream.hpp"
+
+LIBVSQ_BEGIN_NAMESPACE
+
+MetaTextLexer::MetaTextLexer(TextStream& stream)
+	: _stream(stream)
+{}
+
+void MetaTextLexer::next()
+{
+	_stream.readLine(_line.begin, _line.end);
+	char const* equal = _line.empty() ? nullptr : static_cast<char const*>(std::memchr(_line.begin, '=', _line.size()));
+	if (equal) {
+		_key = Range(_line.begin, equal);
+		char const* valueBegin = equal + 1;
+		char const* valueEnd = static_cast<char const*>(std::memchr(valueBegin, '=', _line.end - valueBegin));
+		_value = Range(valueBegin, valueEnd ? valueEnd : _line.end);
+	} else {
+		_key = _line;
+		_value = Range(_line.end, _line.end);
+	}
+}
+
+bool MetaTextLexer::ready() const
+{
+	return _stream.ready();
+}
+
+LIBVSQ_END_NAMESPACE
@@ -16,9 +16,134 @@
 #include "../include/libvsq/InputStream.hpp"
 #include "../include/libvsq/StringUtil.hpp"
 #include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
 
 LIBVSQ_BEGIN_NAMESPACE
 
+const size_t MidiEvent::Data::INLINE_CAPACITY;
+const int MidiEvent::MAX_DELTA_TICK_BYTES;
+
+namespace
+{
+
+/**
+ * @brief 可変長数値が (インデックス + 1) バイトで表せる値の上限. この値は含まない.
+ */
+const uint64_t DELTA_TICK_LIMITS[MidiEvent::MAX_DELTA_TICK_BYTES - 1] = {
+	UINT64_C(1) << 7,
+	UINT64_C(1) << 14,
+	UINT64_C(1) << 21,
+	UINT64_C(1) << 28,
+	UINT64_C(1) << 35,
+	UINT64_C(1) << 42,
+	UINT64_C(1) << 49,
+	UINT64_C(1) << 56,
+	UINT64_C(1) << 63,
+};
+
+}
+
+MidiEvent::Data::Data()
+	: _size(0)
+	, _capacity(INLINE_CAPACITY)
+{}
+
+MidiEvent::Data::Data(Data const& value)
+	: _size(0)
+	, _capacity(INLINE_CAPACITY)
+{
+	assign(value.data(), value.size());
+}
+
+MidiEvent::Data::Data(Data&& value)
+	: _size(value._size)
+	, _capacity(value._capacity)
+{
+	if (value.isInline()) {
+		::memcpy(_storage.inlineBytes, value._storage.inlineBytes, _size);
+	} else {
+		_storage.heapBytes = value._storage.heapBytes;
+		value._capacity = INLINE_CAPACITY;
+	}
+	value._size = 0;
+}
+
+MidiEvent::Data::~Data()
+{
+	if (!isInline()) {
+		delete [] _storage.heapBytes;
+	}
+}
+
+MidiEvent::Data& MidiEvent::Data::operator = (Data const& value)
+{
+	if (this != &value) {
+		assign(value.data(), value.size());
+	}
+	return *this;
+}
+
+MidiEvent::Data& MidiEvent::Data::operator = (Data&& value)
+{
+	if (this != &value) {
+		if (!isInline()) {
+			delete [] _storage.heapBytes;
+		}
+		_size = value._size;
+		_capacity = value._capacity;
+		if (value.isInline()) {
+			::memcpy(_storage.inlineBytes, value._storage.inlineBytes, _size);
+		} else {
+			_storage.heapBytes = value._storage.heapBytes;
+			value._capacity = INLINE_CAPACITY;
+		}
+		value._size = 0;
+	}
+	return *this;
+}
+
+void MidiEvent::Data::resize(size_t size)
+{
+	reserve(size);
+	if (_size < size) {
+		::memset(data() + _size, 0, size - _size);
+	}
+	_size = static_cast<uint32_t>(size);
+}
+
+void MidiEvent::Data::reserve(size_t capacity)
+{
+	if (capacity <= _capacity) {
+		return;
+	}
+	// バイト数は 32 ビットで保持するため, それを超える領域は確保できない
+	if (capacity > UINT32_MAX) {
+		throw std::length_error("MidiEvent::Data::reserve");
+	}
+	uint8_t* bytes = new uint8_t[capacity];
+	::memcpy(bytes, data(), _size);
+	if (!isInline()) {
+		delete [] _storage.heapBytes;
+	}
+	_storage.heapBytes = bytes;
+	_capacity = static_cast<uint32_t>(capacity);
+}
+
+void MidiEvent::Data::assign(uint8_t const* bytes, size_t length)
+{
+	_size = 0;
+	reserve(length);
+	::memmove(data(), bytes, length);
+	_size = static_cast<uint32_t>(length);
+}
+
+bool MidiEvent::Data::operator == (Data const& value) const
+{
+	return _size == value._size && std::equal(begin(), end(), value.begin());
+}
+
 MidiEvent::MidiEvent()
 {
 	tick = 0;
@@ -30,16 +155,13 @@ void MidiEvent::writeData(OutputStream& stream) const
 	stream.write(firstByte);
 	int size = (int)data.size();
 	if (0 < size) {
-		std::vector<char> buffer(size);
-		for (int i = 0; i < size; i++) {
-			buffer[i] = (char)data[i];
-		}
+		char const* buffer = reinterpret_cast<char const*>(data.data());
 		if (firstByte == 0xff) {
 			stream.write(buffer[0]);
 			writeDeltaTick(stream, size - 1);
-			stream.write(buffer.data(), 1, size - 1);
+			stream.write(buffer, 1, size - 1);
 		} else {
-			stream.write(buffer.data(), 0, size);
+			stream.write(buffer, 0, size);
 		}
 	}
 }
@@ -118,36 +240,42 @@ MidiEvent MidiEvent::generateTempoChangeEvent(tick_t tick, int tempo)
 
 void MidiEvent::writeDeltaTick(OutputStream& stream, int number)
 {
-	std::vector<bool> bits;
-	uint64_t val = 0x1;
-	bits.push_back((number & val) == val);
-	for (int i = 1; i < 64; i++) {
-		val = val << 1;
-		bits.push_back((number & val) == val);
+	uint8_t buffer[MAX_DELTA_TICK_BYTES];
+	int length = encodeDeltaTick(number, buffer);
+	stream.write(reinterpret_cast<char const*>(buffer), 0, length);
+}
+
+int MidiEvent::encodeDeltaTick(tick_t number, uint8_t* dest)
+{
+	uint64_t value = static_cast<uint64_t>(number);
+	if (value < DELTA_TICK_LIMITS[0]) {
+		dest[0] = static_cast<uint8_t>(value);
+		return 1;
 	}
-	int first = 0;
-	for (int i = 63; i >= 0; i--) {
-		if (bits[i]) {
-			first = i;
-			break;
-		}
+	int length = 2;
+	while (length < MAX_DELTA_TICK_BYTES && DELTA_TICK_LIMITS[length - 1] <= value) {
+		length++;
 	}
-	// 何バイト必要か？
-	int bytes = first / 7 + 1;
-	for (int i = 1; i <= bytes; i++) {
-		int num = 0;
-		long count = 0x80;
-		for (int j = (bytes - i + 1) * 7 - 1; j >= (bytes - i + 1) * 7 - 6 - 1; j--) {
-			count = count >> 1;
-			if (bits[j]) {
-				num += count;
-			}
-		}
-		if (i != bytes) {
-			num += 0x80;
+	for (int i = length - 1; i > 0; i--) {
+		*dest++ = static_cast<uint8_t>(0x80 | (0x7f & (value >> (7 * i))));
+	}
+	*dest = static_cast<uint8_t>(0x7f & value);
+	return length;
+}
+
+int MidiEvent::decodeDeltaTick(uint8_t const* data, size_t length, tick_t& number)
+{
+	uint64_t value = 0;
+	size_t i = 0;
+	while (i < length) {
+		uint8_t d = data[i++];
+		value = (value << 7) | (d & 0x7f);
+		if ((d & 0x80) == 0x00) {
+			break;
 		}
-		stream.write(num);
 	}
+	number = static_cast<tick_t>(value);
+	return static_cast<int>(i);
 }
 
 tick_t MidiEvent::readDeltaTick(InputStream& stream)
@@ -168,15 +296,138 @@ tick_t MidiEvent::readDeltaTick(InputStream& stream)
 	return ret;
 }
 
-MidiEvent MidiEvent::read(InputStream& stream, tick_t& last_tick, uint8_t& last_status_byte)
+namespace
+{
+
+/**
+ * @brief InputStream から, MIDI イベントのバイト列を読み込むアダプター.
+ */
+class StreamSource
+{
+public:
+	explicit StreamSource(InputStream& stream)
+		: _stream(stream)
+	{}
+
+	int read()
+	{
+		return _stream.read();
+	}
+
+	/**
+	 * @brief 直前に読み込んだ 1 バイトを読み込む前の位置に戻る.
+	 */
+	void unread()
+	{
+		int64_t pos = _stream.getPointer();
+		_stream.seek(pos - 1);
+	}
+
+	tick_t readDeltaTick()
+	{
+		return MidiEvent::readDeltaTick(_stream);
+	}
+
+	/**
+	 * @brief データの指定した位置から末尾までを一括で読み込む.
+	 * @param data 読み込み先. 読み込むバイト数に応じてあらかじめ resize しておく.
+	 * @param offset 読み込みを開始する位置.
+	 */
+	void readPayload(MidiEvent::Data& data, size_t offset)
+	{
+		size_t const length = data.size() - offset;
+		if (length == 0) {
+			return;
+		}
+		char* buffer = reinterpret_cast<char*>(data.data());
+		size_t const amount = _stream.read(buffer, offset, length);
+		if (amount < length) {
+			// ストリームの末尾に達した部分は, read() が返す負の値と同じく 0xff で埋める
+			::memset(buffer + offset + amount, 0xff, length - amount);
+		}
+	}
+
+private:
+	InputStream& _stream;
+};
+
+/**
+ * @brief メモリ上のバイト列から, MIDI イベントのバイト列を読み込むアダプター.
+ * @details 終端を越えて読み込んだ場合は StreamSource と同じく負の値や 0xff を返し, 読み込み位置だけを進める.
+ */
+class SpanSource
+{
+public:
+	SpanSource(uint8_t const* data, size_t length, size_t position)
+		: _data(data)
+		, _length(length)
+		, _position(position)
+	{}
+
+	int read()
+	{
+		size_t const position = _position++;
+		return position < _length ? _data[position] : -1;
+	}
+
+	void unread()
+	{
+		--_position;
+	}
+
+	tick_t readDeltaTick()
+	{
+		tick_t result = 0;
+		if (_position < _length) {
+			_position += MidiEvent::decodeDeltaTick(_data + _position, _length - _position, result);
+		}
+		return result;
+	}
+
+	void readPayload(MidiEvent::Data& data, size_t offset)
+	{
+		size_t const length = data.size() - offset;
+		if (length == 0) {
+			return;
+		}
+		uint8_t* buffer = data.data();
+		size_t const available = _position < _length ? _length - _position : 0;
+		size_t const amount = std::min(available, length);
+		if (0 < amount) {
+			::memcpy(buffer + offset, _data + _position, amount);
+		}
+		if (amount < length) {
+			::memset(buffer + offset + amount, 0xff, length - amount);
+		}
+		_position += length;
+	}
+
+	/**
+	 * @brief 読み込み位置を取得する. 終端を越えて読み込んだ場合は終端の位置を返す.
+	 */
+	size_t position() const
+	{
+		return std::min(_position, _length);
+	}
+
+private:
+	uint8_t const* _data;
+	size_t const _length;
+	size_t _position;
+};
+
+/**
+ * @brief MIDI イベントを一つ読み込む. StreamSource と SpanSource で共通の処理.
+ */
+template<class Source>
+MidiEvent readEvent(Source& source, tick_t& last_tick, uint8_t& last_status_byte)
 {
-	tick_t delta_tick = readDeltaTick(stream);
+	tick_t delta_tick = source.readDeltaTick();
 	last_tick += delta_tick;
-	int first_byte = stream.read();
+	int first_byte = source.read();
 	if (first_byte < 0x80) {
 		// ランニングステータスが適用される
-		int64_t pos = stream.getPointer();
-		stream.seek(pos - 1);
+		source.unread();
 		first_byte = last_status_byte;
 	} else {
 		last_status_byte = first_byte;
@@ -195,8 +446,8 @@ MidiEvent MidiEvent::read(InputStream& stream, tick_t& last_tick, uint8_t& last_
 		me.tick = last_tick;
 		me.firstByte = first_byte;
 		me.data.clear();
-		me.data.push_back(0xff & stream.read());
-		me.data.push_back(0xff & stream.read());
+		me.data.push_back(0xff & source.read());
+		me.data.push_back(0xff & source.read());
 		return me;
 	} else if (ctrl == 0xC0 || ctrl == 0xD0 || first_byte == 0xF1 || first_byte == 0xF3) {
 		// 2byte使用するチャンネルメッセージ
@@ -209,7 +460,7 @@ MidiEvent MidiEvent::read(InputStream& stream, tick_t& last_tick, uint8_t& last_
 		me.tick = last_tick;
 		me.firstByte = first_byte;
 		me.data.clear();
-		me.data.push_back(0xff & stream.read());
+		me.data.push_back(0xff & source.read());
 		return me;
 	} else if (first_byte == 0xF6) {
 		// 1byte使用するシステムメッセージ
@@ -228,44 +479,54 @@ MidiEvent MidiEvent::read(InputStream& stream, tick_t& last_tick, uint8_t& last_
 		return me;
 	} else if (first_byte == 0xff) {
 		// メタイベント
-		int meta_event_type = stream.read();
-		tick_t meta_event_length = readDeltaTick(stream);
+		int meta_event_type = source.read();
+		tick_t meta_event_length = source.readDeltaTick();
 		MidiEvent me;
 		me.tick = last_tick;
 		me.firstByte = first_byte;
-		me.data.clear();
-		me.data.push_back(meta_event_type);
-		for (int i = 0; i < meta_event_length; i++) {
-			me.data.push_back(stream.read());
-		}
+		me.data.resize(meta_event_length + 1);
+		me.data[0] = static_cast<uint8_t>(0xff & meta_event_type);
+		source.readPayload(me.data, 1);
 		return me;
 	} else if (first_byte == 0xf0) {
 		// f0ステータスのSysEx
 		MidiEvent me;
 		me.tick = last_tick;
 		me.firstByte = first_byte;
-		int sysex_length = (int)readDeltaTick(stream);
-		me.data.clear();
-		for (int i = 0; i < sysex_length + 1; i++) {
-			me.data.push_back(stream.read());
-		}
+		int sysex_length = (int)source.readDeltaTick();
+		me.data.resize(sysex_length + 1);
+		source.readPayload(me.data, 0);
 		return me;
 	} else if (first_byte == 0xf7) {
 		// f7ステータスのSysEx
 		MidiEvent me;
 		me.tick = last_tick;
 		me.firstByte = first_byte;
-		int sysex_length = (int)readDeltaTick(stream);
-		me.data.clear();
-		for (int i = 0; i < sysex_length; i++) {
-			me.data.push_back(stream.read());
-		}
+		int sysex_length = (int)source.readDeltaTick();
+		me.data.resize(sysex_length);
+		source.readPayload(me.data, 0);
 		return me;
 	} else {
-		throw ParseException("don't know how to process first_byte: 0x" + StringUtil::toString(first_byte, 16));
+		throw MidiEvent::ParseException("don't know how to process first_byte: 0x" + StringUtil::toString(first_byte, 16));
 	}
 }
 
+}
+
+MidiEvent MidiEvent::read(InputStream& stream, tick_t& last_tick, uint8_t& last_status_byte)
+{
+	StreamSource source(stream);
+	return readEvent(source, last_tick, last_status_byte);
+}
+
+MidiEvent MidiEvent::read(uint8_t const* data, size_t length, size_t& position, tick_t& last_tick, uint8_t& last_status_byte)
+{
+	SpanSource source(data, length, position);
+	MidiEvent result = readEvent(source, last_tick, last_status_byte);
+	position = source.position();
+	return result;
+}
+
 bool MidiEvent::compare(MidiEvent const& a, MidiEvent const& b)
 {
 	return (a.compareTo(b) < 0);
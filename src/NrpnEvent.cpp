@@ -12,9 +12,56 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
  */
 #include "../include/libvsq/NrpnEvent.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
 
 LIBVSQ_BEGIN_NAMESPACE
 
+namespace
+{
+
+/**
+ * @brief 1 つの NRPN を表すコントロールチェンジを, MidiEvent の配列に追加する.
+ * @param dest 追加先の配列.
+ * @param tick Tick 単位の時刻.
+ * @param nrpn NRPN.
+ * @param dataMsb DATA MSB.
+ * @param dataLsb DATA LSB.
+ * @param hasLsb DATA LSB を出力するかどうか.
+ * @param withNrpnMsb NRPN MSB を出力するかどうか.
+ */
+void appendMidiEvents(std::vector<MidiEvent>& dest, tick_t tick, MidiParameterType nrpn, int dataMsb, int dataLsb, bool hasLsb, bool withNrpnMsb)
+{
+	int const value = static_cast<int>(nrpn);
+	int const msb = 0xff & (value >> 8);
+	int const lsb = value - (0xff00 & (msb << 8));
+	MidiEvent e;
+	e.tick = tick;
+	e.firstByte = 0xb0;
+	e.data.resize(2);
+
+	if (withNrpnMsb) {
+		e.data[0] = 0x63;
+		e.data[1] = msb;
+		dest.push_back(e);
+	}
+
+	e.data[0] = 0x62;
+	e.data[1] = lsb;
+	dest.push_back(e);
+
+	e.data[0] = 0x06;
+	e.data[1] = dataMsb;
+	dest.push_back(e);
+
+	if (hasLsb) {
+		e.data[0] = 0x26;
+		e.data[1] = dataLsb;
+		dest.push_back(e);
+	}
+}
+
+}
+
 NrpnEvent::NrpnEvent(tick_t tick, MidiParameterType nrpn, int dataMsb)
 {
 	this->tick = tick;
@@ -105,77 +152,25 @@ bool NrpnEvent::compare(NrpnEvent const& a, NrpnEvent const& b)
 
 std::vector<MidiEvent> NrpnEvent::convert(std::vector<NrpnEvent> const& source)
 {
-	int nrpn = static_cast<int>(source[0].nrpn);
-	int msb = 0xff & (nrpn >> 8);
-	int lsb = nrpn - (0xff00 & (msb << 8));
 	std::vector<MidiEvent> ret;
-	MidiEvent e;
-
-	e = MidiEvent();
-	e.tick = source[0].tick;
-	e.firstByte = 0xb0;
-	e.data.push_back(0x63);
-	e.data.push_back(msb);
-	ret.push_back(e);
-
-	e = MidiEvent();
-	e.tick = source[0].tick;
-	e.firstByte = 0xb0;
-	e.data.push_back(0x62);
-	e.data.push_back(lsb);
-	ret.push_back(e);
-
-	e = MidiEvent();
-	e.tick = source[0].tick;
-	e.firstByte = 0xb0;
-	e.data.push_back(0x06);
-	e.data.push_back(source[0].dataMSB);
-	ret.push_back(e);
-
-	if (source[0].hasLSB) {
-		e = MidiEvent();
-		e.tick = source[0].tick;
-		e.firstByte = 0xb0;
-		e.data.push_back(0x26);
-		e.data.push_back(source[0].dataLSB);
-		ret.push_back(e);
+	ret.reserve(source.size() * 4);
+	for (int i = 0; i < source.size(); i++) {
+		NrpnEvent const& item = source[i];
+		appendMidiEvents(ret, item.tick, item.nrpn, item.dataMSB, item.dataLSB, item.hasLSB,
+						 i == 0 || false == item.isMSBOmittingRequired);
 	}
+	return ret;
+}
 
-	for (int i = 1; i < source.size(); i++) {
-		NrpnEvent item = source[i];
-		int tnrpn = static_cast<int>(item.nrpn);
-		msb = 0xff & (tnrpn >> 8);
-		lsb = tnrpn - (0xff00 & (msb << 8));
-		if (false == item.isMSBOmittingRequired) {
-			e = MidiEvent();
-			e.tick = item.tick;
-			e.firstByte = 0xb0;
-			e.data.push_back(0x63);
-			e.data.push_back(msb);
-			ret.push_back(e);
-		}
-
-		e = MidiEvent();
-		e.tick = item.tick;
-		e.firstByte = 0xb0;
-		e.data.push_back(0x62);
-		e.data.push_back(lsb);
-		ret.push_back(e);
-
-		e = MidiEvent();
-		e.tick = item.tick;
-		e.firstByte = 0xb0;
-		e.data.push_back(0x06);
-		e.data.push_back(item.dataMSB);
-		ret.push_back(e);
-		if (item.hasLSB) {
-			e = MidiEvent();
-			e.tick = item.tick;
-			e.firstByte = 0xb0;
-			e.data.push_back(0x26);
-			e.data.push_back(item.dataLSB);
-			ret.push_back(e);
-		}
+std::vector<MidiEvent> NrpnEvent::convert(NrpnEventBuffer const& source)
+{
+	std::vector<MidiEvent> ret;
+	int const count = source.size();
+	ret.reserve(count * 4);
+	for (int i = 0; i < count; i++) {
+		NrpnEventBuffer::Record const& item = source.get(i);
+		appendMidiEvents(ret, item.tick, item.nrpn, item.dataMSB, item.dataLSB, item.hasLSB(),
+						 i == 0 || false == item.isMSBOmittingRequired());
 	}
 	return ret;
 }
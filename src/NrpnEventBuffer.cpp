@@ -0,0 +1,310 @@
+﻿/**
+ * @file NrpnEventBuffer.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/NrpnEventBuffer.hpp"
+#include "../include/libvsq/NrpnEvent.hpp"
+#include "../include/libvsq/MidiEvent.hpp"
+#include "../include/libvsq/OutputStream.hpp"
+#include <algorithm>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+const uint8_t NrpnEventBuffer::HAS_LSB;
+const uint8_t NrpnEventBuffer::MSB_OMITTING_REQUIRED;
+const uint8_t NrpnEventBuffer::GROUP_HEAD;
+
+namespace
+{
+
+/**
+ * @brief ソート用の, グループの位置情報.
+ */
+struct Group {
+	tick_t tick;
+	int nrpnMsb;
+	int start;
+	int count;
+};
+
+bool compareGroup(Group const& a, Group const& b)
+{
+	if (a.tick == b.tick) {
+		return b.nrpnMsb < a.nrpnMsb;
+	} else {
+		return a.tick < b.tick;
+	}
+}
+
+/**
+ * @brief 固定長の領域にバイト列を溜め, 一杯になったらストリームに出力する.
+ */
+class ChunkedWriter
+{
+public:
+	ChunkedWriter(OutputStream& stream, bool runningStatus)
+		: _stream(stream)
+		, _length(0)
+		, _runningStatus(runningStatus)
+		, _statusWritten(false)
+	{}
+
+	/**
+	 * @brief 1 レコード分のバイト列を書き込める空きを確保する.
+	 */
+	void ensure(int length)
+	{
+		if (CAPACITY < _length + length) {
+			flush();
+		}
+	}
+
+	void put(int byte)
+	{
+		_buffer[_length++] = static_cast<char>(byte);
+	}
+
+	/**
+	 * @brief コントロールチェンジを書き込む. ランニングステータスが有効な場合, 2 つ目以降はステータスバイトを省略する.
+	 */
+	void putControlChange(int control, int value)
+	{
+		if (!_runningStatus || !_statusWritten) {
+			put(0xb0);
+			_statusWritten = true;
+		}
+		put(control);
+		put(value);
+	}
+
+	/**
+	 * @brief 可変長のデルタタイムを書き込む.
+	 */
+	void putDeltaTick(tick_t deltaTick)
+	{
+		_length += MidiEvent::encodeDeltaTick(deltaTick, reinterpret_cast<uint8_t*>(_buffer + _length));
+	}
+
+	void flush()
+	{
+		if (0 < _length) {
+			_stream.write(_buffer, 0, _length);
+			_length = 0;
+		}
+	}
+
+private:
+	static const int CAPACITY = 4096;
+
+	OutputStream& _stream;
+	char _buffer[CAPACITY];
+	int _length;
+	bool const _runningStatus;
+	bool _statusWritten;
+};
+
+}
+
+NrpnEventBuffer::NrpnEventBuffer()
+{}
+
+void NrpnEventBuffer::add(tick_t tick, MidiParameterType nrpn, int dataMsb)
+{
+	push(tick, nrpn, dataMsb, 0, GROUP_HEAD);
+}
+
+void NrpnEventBuffer::add(tick_t tick, MidiParameterType nrpn, int dataMsb, int dataLsb)
+{
+	push(tick, nrpn, dataMsb, dataLsb, GROUP_HEAD | HAS_LSB);
+}
+
+void NrpnEventBuffer::add(NrpnEvent const& event)
+{
+	std::vector<NrpnEvent> expanded = event.expand();
+	for (int i = 0; i < expanded.size(); ++i) {
+		NrpnEvent const& item = expanded[i];
+		uint8_t flags = 0;
+		if (i == 0) {
+			flags |= GROUP_HEAD;
+		}
+		if (item.hasLSB) {
+			flags |= HAS_LSB;
+		}
+		if (item.isMSBOmittingRequired) {
+			flags |= MSB_OMITTING_REQUIRED;
+		}
+		push(item.tick, item.nrpn, item.dataMSB, item.dataLSB, flags);
+	}
+}
+
+void NrpnEventBuffer::append(MidiParameterType nrpn, int dataMsb)
+{
+	push(lastTick(), nrpn, dataMsb, 0, 0);
+}
+
+void NrpnEventBuffer::append(MidiParameterType nrpn, int dataMsb, int dataLsb)
+{
+	push(lastTick(), nrpn, dataMsb, dataLsb, HAS_LSB);
+}
+
+void NrpnEventBuffer::append(MidiParameterType nrpn, int dataMsb, bool isMsbOmittingRequired)
+{
+	push(lastTick(), nrpn, dataMsb, 0, isMsbOmittingRequired ? MSB_OMITTING_REQUIRED : 0);
+}
+
+void NrpnEventBuffer::append(MidiParameterType nrpn, int dataMsb, int dataLsb, bool isMsbOmittingRequired)
+{
+	push(lastTick(), nrpn, dataMsb, dataLsb, HAS_LSB | (isMsbOmittingRequired ? MSB_OMITTING_REQUIRED : 0));
+}
+
+void NrpnEventBuffer::append(NrpnEventBuffer const& source, int start, int count)
+{
+	_records.insert(_records.end(), source._records.begin() + start, source._records.begin() + start + count);
+}
+
+int NrpnEventBuffer::size() const
+{
+	return _records.size();
+}
+
+bool NrpnEventBuffer::empty() const
+{
+	return _records.empty();
+}
+
+NrpnEventBuffer::Record const& NrpnEventBuffer::get(int index) const
+{
+	return _records[index];
+}
+
+void NrpnEventBuffer::clear()
+{
+	_records.clear();
+}
+
+void NrpnEventBuffer::reserve(int count)
+{
+	_records.reserve(count);
+}
+
+void NrpnEventBuffer::sort()
+{
+	std::vector<Group> groups;
+	int const count = _records.size();
+	for (int i = 0; i < count; ++i) {
+		Record const& record = _records[i];
+		if (record.isGroupHead() || groups.empty()) {
+			int const nrpn = static_cast<int>(record.nrpn);
+			Group group;
+			group.tick = record.tick;
+			group.nrpnMsb = (nrpn - (nrpn % 0x100)) / 0x100;
+			group.start = i;
+			group.count = 0;
+			groups.push_back(group);
+		}
+		groups.back().count++;
+	}
+	if (std::is_sorted(groups.begin(), groups.end(), compareGroup)) {
+		return;
+	}
+	std::stable_sort(groups.begin(), groups.end(), compareGroup);
+
+	std::vector<Record> sorted;
+	sorted.reserve(count);
+	for (Group const& group : groups) {
+		sorted.insert(sorted.end(), _records.begin() + group.start, _records.begin() + group.start + group.count);
+	}
+	_records.swap(sorted);
+}
+
+std::vector<NrpnEvent> NrpnEventBuffer::toList() const
+{
+	std::vector<NrpnEvent> result;
+	for (Record const& record : _records) {
+		if (record.isGroupHead() || result.empty()) {
+			if (record.hasLSB()) {
+				result.push_back(NrpnEvent(record.tick, record.nrpn, record.dataMSB, record.dataLSB));
+			} else {
+				result.push_back(NrpnEvent(record.tick, record.nrpn, record.dataMSB));
+			}
+			result.back().isMSBOmittingRequired = record.isMSBOmittingRequired();
+		} else if (record.hasLSB()) {
+			result.back().append(record.nrpn, record.dataMSB, record.dataLSB, record.isMSBOmittingRequired());
+		} else {
+			result.back().append(record.nrpn, record.dataMSB, record.isMSBOmittingRequired());
+		}
+	}
+	return result;
+}
+
+std::vector<NrpnEvent> NrpnEventBuffer::expand() const
+{
+	std::vector<NrpnEvent> result;
+	result.reserve(_records.size());
+	for (Record const& record : _records) {
+		if (record.hasLSB()) {
+			result.push_back(NrpnEvent(record.tick, record.nrpn, record.dataMSB, record.dataLSB));
+		} else {
+			result.push_back(NrpnEvent(record.tick, record.nrpn, record.dataMSB));
+		}
+		result.back().isMSBOmittingRequired = record.isMSBOmittingRequired();
+	}
+	return result;
+}
+
+void NrpnEventBuffer::write(OutputStream& stream, tick_t& lastTick, bool runningStatus) const
+{
+	// 1 レコードあたり最大で, 先頭のデルタタイム 10 バイトと, コントロールチェンジ 4 つ(後続のデルタタイムを含む)分
+	static const int MAX_RECORD_BYTES = MidiEvent::MAX_DELTA_TICK_BYTES + 4 * 4;
+	ChunkedWriter writer(stream, runningStatus);
+	int const count = _records.size();
+	for (int i = 0; i < count; ++i) {
+		Record const& item = _records[i];
+		int const nrpn = static_cast<int>(item.nrpn);
+		int const msb = 0xff & (nrpn >> 8);
+		int const lsb = nrpn - (0xff00 & (msb << 8));
+		writer.ensure(MAX_RECORD_BYTES);
+
+		writer.putDeltaTick(item.tick - lastTick);
+		if (i == 0 || false == item.isMSBOmittingRequired()) {
+			writer.putControlChange(0x63, msb);
+			writer.put(0x00);
+		}
+		writer.putControlChange(0x62, lsb);
+		writer.put(0x00);
+		writer.putControlChange(0x06, item.dataMSB);
+		if (item.hasLSB()) {
+			writer.put(0x00);
+			writer.putControlChange(0x26, item.dataLSB);
+		}
+		lastTick = item.tick;
+	}
+	writer.flush();
+}
+
+void NrpnEventBuffer::push(tick_t tick, MidiParameterType nrpn, int dataMsb, int dataLsb, uint8_t flags)
+{
+	Record record;
+	record.tick = tick;
+	record.nrpn = nrpn;
+	record.dataMSB = static_cast<uint8_t>(0xff & dataMsb);
+	record.dataLSB = static_cast<uint8_t>(0xff & dataLsb);
+	record.flags = flags;
+	_records.push_back(record);
+}
+
+tick_t NrpnEventBuffer::lastTick() const
+{
+	return _records.empty() ? 0 : _records.back().tick;
+}
+
+LIBVSQ_END_NAMESPACE
@@ -13,40 +13,133 @@
  */
 #include "../include/libvsq/SMFReader.hpp"
 #include "../include/libvsq/InputStream.hpp"
+#include "../include/libvsq/BufferedInputStream.hpp"
 #include "../include/libvsq/BitConverter.hpp"
+#include "../include/libvsq/ThreadUtil.hpp"
+#include <vector>
+#include <algorithm>
 
 LIBVSQ_BEGIN_NAMESPACE
 
-void SMFReader::read(InputStream& stream, std::vector<std::vector<MidiEvent>>& dest, int& format, int& timeFormat)
+class SMFReader::Impl
 {
-	// ヘッダ
-	char byte4[4] = { 0 };
-	stream.read(byte4, 0, 4);
-	if (BitConverter::makeUInt32BE(byte4) != 0x4d546864) {
-		throw ParseException();
+public:
+	/**
+	 * @brief MTrk チャンクのデータ部を指すバイト列.
+	 * @details ストリームがメモリ上に配置されている場合はストリームの内容を直接指し, それ以外の場合は読み込み先のバッファーを指す.
+	 */
+	struct Chunk
+	{
+		uint8_t const* data;
+		size_t length;
+	};
+
+	Impl()
+		: parallel(false)
+	{}
+
+	void read(InputStream& stream, std::vector<std::vector<MidiEvent>>& dest, int& format, int& timeFormat)
+	{
+		int tracks = readHeader(stream, format, timeFormat);
+
+		// 各トラックを読込み
+		dest.clear();
+		dest.resize(tracks);
+		if (parallel && 1 < tracks) {
+			readTracksConcurrently(stream, dest);
+			return;
+		}
+		std::vector<uint8_t> buffer;
+		for (int track = 0; track < tracks; track++) {
+			Chunk chunk = readChunk(stream, buffer);
+			decodeChunk(chunk, dest[track]);
+		}
 	}
 
-	// データ長
-	stream.read(byte4, 0, 4);
+	static void readChunks(InputStream& stream, std::vector<std::vector<uint8_t>>& dest, int& format, int& timeFormat)
+	{
+		int tracks = readHeader(stream, format, timeFormat);
+		dest.clear();
+		dest.resize(tracks);
+		for (int track = 0; track < tracks; track++) {
+			Chunk chunk = readChunk(stream, dest[track]);
+			if (chunk.data != dest[track].data()) {
+				dest[track].assign(chunk.data, chunk.data + chunk.length);
+			}
+		}
+	}
 
-	// フォーマット
-	stream.read(byte4, 0, 2);
-	format = BitConverter::makeUInt16BE(byte4);
+	static void readTracks(InputStream& stream, std::function<void(int, std::vector<MidiEvent> const&)> const& callback, int& format, int& timeFormat)
+	{
+		int tracks = readHeader(stream, format, timeFormat);
+		std::vector<uint8_t> buffer;
+		std::vector<MidiEvent> events;
+		for (int track = 0; track < tracks; track++) {
+			Chunk chunk = readChunk(stream, buffer);
+			events.clear();
+			decodeChunk(chunk, events);
+			callback(track, events);
+		}
+	}
 
-	// トラック数
-	stream.read(byte4, 0, 2);
-	int tracks = (int)BitConverter::makeUInt16BE(byte4);
+	/**
+	 * @brief MThd チャンクを読み込む.
+	 * @return トラック数.
+	 */
+	static int readHeader(InputStream& stream, int& format, int& timeFormat)
+	{
+		// ヘッダ
+		char byte4[4] = { 0 };
+		stream.read(byte4, 0, 4);
+		if (BitConverter::makeUInt32BE(byte4) != 0x4d546864) {
+			throw ParseException();
+		}
 
-	// 時間分解能
-	stream.read(byte4, 0, 2);
-	timeFormat = BitConverter::makeUInt16BE(byte4);
+		// データ長
+		stream.read(byte4, 0, 4);
 
-	// 各トラックを読込み
-	dest.clear();
-	for (int track = 0; track < tracks; track++) {
-		dest.push_back(std::vector<MidiEvent>());
+		// フォーマット
+		stream.read(byte4, 0, 2);
+		format = BitConverter::makeUInt16BE(byte4);
 
+		// トラック数
+		stream.read(byte4, 0, 2);
+		int tracks = (int)BitConverter::makeUInt16BE(byte4);
+
+		// 時間分解能
+		stream.read(byte4, 0, 2);
+		timeFormat = BitConverter::makeUInt16BE(byte4);
+		return tracks;
+	}
+
+	/**
+	 * @brief 全トラックの MTrk チャンクを順に読み込んだ後, ワーカースレッド上でデコードする.
+	 */
+	void readTracksConcurrently(InputStream& stream, std::vector<std::vector<MidiEvent>>& dest)
+	{
+		int const count = dest.size();
+		std::vector<std::vector<uint8_t>> buffers(count);
+		std::vector<Chunk> chunks(count);
+		for (int track = 0; track < count; ++track) {
+			chunks[track] = readChunk(stream, buffers[track]);
+		}
+
+		ThreadUtil::runConcurrently(count, [&](int track) {
+			decodeChunk(chunks[track], dest[track]);
+		});
+	}
+
+	/**
+	 * @brief MTrk チャンクを一括でメモリに読み込む.
+	 * @details ストリームがメモリ上に配置されている場合は, コピーせずにストリームの内容を直接指すバイト列を返す.
+	 * @param stream 読み込み元のストリーム.
+	 * @param buffer 読み込み先のバッファー.
+	 * @return チャンクのデータ部. ストリームの終端に達した場合は, 読み込めた長さに切り詰められる.
+	 */
+	static Chunk readChunk(InputStream& stream, std::vector<uint8_t>& buffer)
+	{
 		// ヘッダー
+		char byte4[4] = { 0 };
 		stream.read(byte4, 0, 4);
 		if (BitConverter::makeUInt32BE(byte4) != 0x4d54726b) {
 			throw ParseException();// "header error; MTrk" );
@@ -54,17 +147,96 @@ void SMFReader::read(InputStream& stream, std::vector<std::vector<MidiEvent>>& d
 
 		// チャンクサイズ
 		stream.read(byte4, 0, 4);
-		long size = (long)BitConverter::makeUInt32BE(byte4);
-		int64_t startpos = stream.getPointer();
+		size_t size = (size_t)BitConverter::makeUInt32BE(byte4);
+
+		uint8_t const* data = stream.data();
+		if (data) {
+			int64_t const position = stream.getPointer();
+			int64_t const remain = std::max((int64_t)0, stream.length() - position);
+			size_t const amount = (size_t)std::min((int64_t)size, remain);
+			stream.seek(position + amount);
+			Chunk result = { data + position, amount };
+			return result;
+		}
+
+		buffer.resize(size);
+		size_t amount = 0;
+		if (0 < size) {
+			amount = stream.read(reinterpret_cast<char*>(buffer.data()), 0, size);
+		}
+		buffer.resize(amount);
+		Chunk result = { buffer.data(), amount };
+		return result;
+	}
 
-		// チャンクの終わりまで読込み
+	/**
+	 * @brief メモリ上の MTrk チャンクのデータ部から, MIDI イベントを読み取る.
+	 */
+	static void decodeChunk(Chunk const& chunk, std::vector<MidiEvent>& dest)
+	{
 		tick_t tick = 0;
 		uint8_t last_status_byte = 0x00;
-		while (stream.getPointer() < startpos + size) {
-			MidiEvent mi = MidiEvent::read(stream, tick, last_status_byte);
-			dest[track].push_back(mi);
+		size_t position = 0;
+		while (position < chunk.length) {
+			dest.push_back(MidiEvent::read(chunk.data, chunk.length, position, tick, last_status_byte));
 		}
 	}
+
+public:
+	bool parallel;
+};
+
+SMFReader::SMFReader()
+	: _impl(new Impl())
+{}
+
+SMFReader::~SMFReader()
+{}
+
+void SMFReader::read(InputStream& stream, std::vector<std::vector<MidiEvent>>& dest, int& format, int& timeFormat)
+{
+	if (stream.data()) {
+		_impl->read(stream, dest, format, timeFormat);
+	} else {
+		BufferedInputStream buffered(stream);
+		_impl->read(buffered, dest, format, timeFormat);
+	}
+}
+
+void SMFReader::readChunks(InputStream& stream, std::vector<std::vector<uint8_t>>& dest, int& format, int& timeFormat)
+{
+	if (stream.data()) {
+		Impl::readChunks(stream, dest, format, timeFormat);
+	} else {
+		BufferedInputStream buffered(stream);
+		Impl::readChunks(buffered, dest, format, timeFormat);
+	}
+}
+
+void SMFReader::decodeChunk(std::vector<uint8_t> const& chunk, std::vector<MidiEvent>& dest)
+{
+	Impl::Chunk span = { chunk.data(), chunk.size() };
+	Impl::decodeChunk(span, dest);
+}
+
+void SMFReader::readTracks(InputStream& stream, std::function<void(int, std::vector<MidiEvent> const&)> const& callback, int& format, int& timeFormat)
+{
+	if (stream.data()) {
+		Impl::readTracks(stream, callback, format, timeFormat);
+	} else {
+		BufferedInputStream buffered(stream);
+		Impl::readTracks(buffered, callback, format, timeFormat);
+	}
+}
+
+bool SMFReader::parallel() const
+{
+	return _impl->parallel;
+}
+
+void SMFReader::parallel(bool value)
+{
+	_impl->parallel = value;
 }
 
 LIBVSQ_END_NAMESPACE
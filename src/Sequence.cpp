@@ -12,6 +12,7 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
  */
 #include "../include/libvsq/Sequence.hpp"
+#include <algorithm>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -32,6 +33,7 @@ Sequence Sequence::clone() const
 	for (int i = 0; i < _track.size(); i++) {
 		ret._track.push_back(_track[i].clone());
 	}
+	ret._trackLoaders = _trackLoaders;
 
 	ret.tempoList = TempoList();
 	for (int i = 0; i < tempoList.size(); i++) {
@@ -51,24 +53,53 @@ Sequence Sequence::clone() const
 
 Track const& Sequence::track(int trackIndex) const
 {
+	_loadTrack(trackIndex);
 	return _track[trackIndex];
 }
 
 Track& Sequence::track(int trackIndex)
 {
+	_loadTrack(trackIndex);
 	return _track[trackIndex];
 }
 
 std::vector<Track> const& Sequence::tracks() const
 {
+	_loadAllTracks();
 	return _track;
 }
 
 std::vector<Track>& Sequence::tracks()
 {
+	_loadAllTracks();
 	return _track;
 }
 
+int Sequence::trackCount() const
+{
+	return _track.size();
+}
+
+std::string Sequence::trackName(int trackIndex) const
+{
+	return _track[trackIndex].name();
+}
+
+std::string Sequence::trackSinger(int trackIndex) const
+{
+	Track const& track = _track[trackIndex];
+	EventListIndexIterator itr = track.getIndexIterator(EventListIndexIteratorKind::SINGER);
+	if (itr.hasNext()) {
+		return track.events().get(itr.next())->singerHandle.ids;
+	}
+	return "";
+}
+
+bool Sequence::isTrackLoaded(int trackIndex) const
+{
+	return trackIndex >= _trackLoaders.size() || !_trackLoaders[trackIndex];
+}
+
 int Sequence::baseTempo() const
 {
 	return _baseTempo;
@@ -113,10 +144,47 @@ std::vector<std::string> Sequence::curveNameList()
 
 void Sequence::updateTotalTicks()
 {
+	_totalTicks = calculateTotalTicks();
+}
+
+void Sequence::setTrackLoaders(std::vector<Track> placeholders, std::vector<std::function<Track()>> loaders, tick_t totalTicks)
+{
+	_track.swap(placeholders);
+	_trackLoaders.swap(loaders);
+	_totalTicks = totalTicks;
+}
+
+void Sequence::_loadTrack(int trackIndex) const
+{
+	if (isTrackLoaded(trackIndex)) {
+		return;
+	}
+	// 読み込みに失敗した場合は, 次に参照されたときに再度読み込めるよう, ローダーを残しておく
+	_track[trackIndex] = _trackLoaders[trackIndex]();
+	_trackLoaders[trackIndex] = nullptr;
+
+	bool const pending = std::any_of(_trackLoaders.begin(), _trackLoaders.end(), [](std::function<Track()> const& item) {
+		return (bool)item;
+	});
+	if (!pending) {
+		_trackLoaders.clear();
+	}
+}
+
+void Sequence::_loadAllTracks() const
+{
+	for (int i = 0; i < _trackLoaders.size(); ++i) {
+		_loadTrack(i);
+	}
+}
+
+tick_t Sequence::calculateTotalTicks() const
+{
+	_loadAllTracks();
 	tick_t max = preMeasureTicks();
 	std::vector<std::string> curveNameList = this->curveNameList();
 	for (int i = 0; i < _track.size(); i++) {
-		Track& track = _track[i];
+		Track const& track = _track[i];
 		int numEvents = track.events().size();
 		if (0 < numEvents) {
 			Event const* lastItem = track.events().get(numEvents - 1);
@@ -134,7 +202,7 @@ void Sequence::updateTotalTicks()
 			}
 		}
 	}
-	_totalTicks = max;
+	return max;
 }
 
 tick_t Sequence::_calculatePreMeasureInTick() const
@@ -13,6 +13,7 @@
  */
 #include "../include/libvsq/StreamWriter.hpp"
 #include "../include/libvsq/FileOutputStream.hpp"
+#include "../include/libvsq/BufferedOutputStream.hpp"
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -23,38 +24,50 @@ StreamWriter::StreamWriter(std::string const& filePath)
 	} catch (OutputStream::IOException) {
 		throw TextOutputStream::IOException();
 	}
+	buffer.reset(new BufferedOutputStream(*stream));
 }
 
 StreamWriter::StreamWriter(OutputStream* stream)
 {
 	this->stream.reset(stream);
+	if (stream) {
+		buffer.reset(new BufferedOutputStream(*stream));
+	}
 }
 
 StreamWriter::~StreamWriter()
 {
-	close();
+	// デストラクタから例外を送出すると std::terminate が呼ばれるため, 書き出しの失敗は無視する.
+	// 失敗を検出したい場合は, 先に close を呼ぶこと
+	try {
+		close();
+	} catch (...) {
+	}
 }
 
 void StreamWriter::close()
 {
 	if (stream) {
+		// 書き出しに失敗した場合も, バッファーとストリームは解放する
+		std::unique_ptr<BufferedOutputStream> buffer(std::move(this->buffer));
+		std::unique_ptr<OutputStream> stream(std::move(this->stream));
+		buffer->flush();
 		stream->close();
-		stream.reset();
 	}
 }
 
 void StreamWriter::write(std::string const& text)
 {
-	if (stream) {
-		stream->write(text.c_str(), 0, text.length());
+	if (buffer) {
+		buffer->write(text.c_str(), 0, text.length());
 	}
 }
 
 void StreamWriter::writeLine(std::string const& text)
 {
 	write(text);
-	if (stream) {
-		stream->write(0x0A);
+	if (buffer) {
+		buffer->write(0x0A);
 	}
 }
 
@@ -16,6 +16,7 @@
 #include <functional>
 #include <sstream>
 #include <iomanip>
+#include <limits>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -123,4 +124,50 @@ char StringUtil::_toLower(char c)
 	return tolower(c);
 }
 
+long long StringUtil::_parseLongLong(char const* begin, char const* end, int baseNumber)
+{
+	char const* p = begin;
+	while (p < end && ::isspace((unsigned char)*p)) {
+		++p;
+	}
+	bool negative = false;
+	if (p < end && (*p == '+' || *p == '-')) {
+		negative = *p == '-';
+		++p;
+	}
+	if (baseNumber == 16 && p + 1 < end && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+		p += 2;
+	}
+
+	unsigned long long const limit = negative
+		? (unsigned long long)std::numeric_limits<long long>::max() + 1
+		: (unsigned long long)std::numeric_limits<long long>::max();
+	unsigned long long value = 0;
+	char const* digits = p;
+	for (; p < end; ++p) {
+		char const c = *p;
+		int digit;
+		if ('0' <= c && c <= '9') {
+			digit = c - '0';
+		} else if ('a' <= c && c <= 'z') {
+			digit = c - 'a' + 10;
+		} else if ('A' <= c && c <= 'Z') {
+			digit = c - 'A' + 10;
+		} else {
+			break;
+		}
+		if (baseNumber <= digit) {
+			break;
+		}
+		if ((limit - digit) / baseNumber < value) {
+			throw IntegerParseException();
+		}
+		value = value * baseNumber + digit;
+	}
+	if (p == digits) {
+		throw IntegerParseException();
+	}
+	return negative ? (long long)(0 - value) : (long long)value;
+}
+
 LIBVSQ_END_NAMESPACE
@@ -49,7 +49,16 @@ std::string TextStream::get()
 
 std::string TextStream::readLine()
 {
-	std::ostringstream sb;
+	char const* begin;
+	char const* end;
+	readLine(begin, end);
+	return std::string(begin, end);
+}
+
+void TextStream::readLine(char const*& begin, char const*& end)
+{
+	begin = _array.data() + _position + 1;
+	end = begin;
 	// '\n'が来るまで読み込み
 	while (_position + 1 < _length) {
 		_position++;
@@ -57,9 +66,8 @@ std::string TextStream::readLine()
 		if (c == (char)0x0A || c == 0) {
 			break;
 		}
-		sb << c;
+		++end;
 	}
-	return sb.str();
 }
 
 bool TextStream::ready() const
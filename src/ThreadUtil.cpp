@@ -0,0 +1,63 @@
+﻿/**
+ * @file ThreadUtil.cpp
+ * Copyright © 2014 kbinani
+ *
+ * This file is part of libvsq.
+ *
+ * libvsq is free software; you can redistribute it and/or
+ * modify it under the terms of the BSD License.
+ *
+ * libvsq is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ */
+#include "../include/libvsq/ThreadUtil.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+LIBVSQ_BEGIN_NAMESPACE
+
+void ThreadUtil::runConcurrently(int count, std::function<void(int)> const& task)
+{
+	std::vector<std::exception_ptr> errors(std::max(0, count));
+	std::atomic<int> next(0);
+
+	auto worker = [&]() {
+		int index;
+		while ((index = next++) < count) {
+			try {
+				task(index);
+			} catch (...) {
+				errors[index] = std::current_exception();
+			}
+		}
+	};
+
+	int const concurrency = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	int const numThreads = std::min(count, concurrency) - 1;
+	std::vector<std::thread> threads;
+	try {
+		threads.reserve(std::max(0, numThreads));
+		for (int i = 0; i < numThreads; ++i) {
+			threads.emplace_back(worker);
+		}
+	} catch (...) {
+		// スレッドを作れなかった場合は, 作れたスレッドと呼び出し元のスレッドだけで残りの task を実行する.
+		// 起動済みのスレッドは join する前に破棄できないので, ここで例外を止める
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	for (auto const& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
+
+LIBVSQ_END_NAMESPACE
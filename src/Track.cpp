@@ -14,6 +14,7 @@
 #include "../include/libvsq/Track.hpp"
 #include "../include/libvsq/StringUtil.hpp"
 #include <memory>
+#include <mutex>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -486,10 +487,8 @@ std::vector<std::string> const* Track::curveNameList() const
 {
 	static std::vector<std::string> vocaloid1;
 	static std::vector<std::string> vocaloid2;
-	if (vocaloid1.empty() || vocaloid2.empty()) {
-		vocaloid1.clear();
-		vocaloid2.clear();
-
+	static std::once_flag initialized;
+	std::call_once(initialized, [this]() {
 		addCurveNameTo(vocaloid1, vocaloid2, kBPListNamePit, true, true);
 		addCurveNameTo(vocaloid1, vocaloid2, kBPListNamePbs, true, true);
 		addCurveNameTo(vocaloid1, vocaloid2, kBPListNameDyn, true, true);
@@ -516,7 +515,7 @@ std::vector<std::string> const* Track::curveNameList() const
 		addCurveNameTo(vocaloid1, vocaloid2, kBPListNamePor, true, true);
 
 		addCurveNameTo(vocaloid1, vocaloid2, kBPListNameOpe, false, true);
-	}
+	});
 
 	if (common().version.substr(0, 4) == "DSB2") {
 		return &vocaloid1;
@@ -17,7 +17,16 @@
 #include "../include/libvsq/TextStream.hpp"
 #include "../include/libvsq/StringUtil.hpp"
 #include "../include/libvsq/CP932Converter.hpp"
+#include "../include/libvsq/MetaTextLexer.hpp"
+#include "../include/libvsq/VSQContentHandler.hpp"
+#include "../include/libvsq/ThreadUtil.hpp"
 #include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <tuple>
 
 LIBVSQ_BEGIN_NAMESPACE
 
@@ -55,6 +64,10 @@ class VSQFileReader::Impl
 			: base_type(other)
 		{}
 
+		explicit TentativeEvent(base_type&& other)
+			: base_type(std::move(other))
+		{}
+
 		void setEOS(bool value)
 		{
 			isEos = value;
@@ -66,6 +79,129 @@ class VSQFileReader::Impl
 		}
 	};
 
+	/**
+	 * @brief [ID#nnnn] セクションのイベントと, [EventList] セクションに記録されたその時刻.
+	 */
+	struct EventSlot
+	{
+		std::unique_ptr<TentativeEvent> event;
+		tick_t tick;
+		bool hasTick;
+		bool parsed;
+
+		EventSlot()
+			: tick(0)
+			, hasTick(false)
+			, parsed(false)
+		{}
+	};
+
+	/**
+	 * @brief [h#nnnn] セクションのハンドルと, それを参照するイベントの数.
+	 */
+	struct HandleSlot
+	{
+		Handle handle;
+		bool present;
+		int references;
+
+		HandleSlot()
+			: present(false)
+			, references(0)
+		{}
+	};
+
+	/**
+	 * @brief [ID#nnnn] や [h#nnnn] の番号をキーとして, 要素を番号順に保持する表.
+	 * @details 番号は通常 0 から始まる連番なので, 番号をインデックスとする配列に格納する.
+	 *          それまでに参照された番号の数に比べて大きすぎる番号は, 不正なファイルでメモリを使い尽くさないよう, 配列ではなく map に格納する.
+	 */
+	template<class Slot>
+	class SlotTable
+	{
+	public:
+		SlotTable()
+			: _count(0)
+		{}
+
+		/**
+		 * @brief 番号に対応する要素を取得する. 要素がなければ作成する.
+		 * @param index 番号.
+		 * @return 要素. 番号が負の場合は nullptr を返す.
+		 */
+		Slot* at(int index)
+		{
+			if (index < 0) {
+				return nullptr;
+			}
+			_count++;
+			size_t const position = static_cast<size_t>(index);
+			if (position < _dense.size()) {
+				return &_dense[position];
+			}
+			if (position >= 2 * _count + MAX_GAP) {
+				return &_sparse[index];
+			}
+			_dense.resize(position + 1);
+			// 配列の範囲に入った要素を, map から移す
+			auto it = _sparse.begin();
+			while (it != _sparse.end() && it->first <= index) {
+				_dense[it->first] = std::move(it->second);
+				it = _sparse.erase(it);
+			}
+			return &_dense[position];
+		}
+
+		/**
+		 * @brief 番号に対応する要素を取得する.
+		 * @param index 番号.
+		 * @return 要素. 要素がない場合は nullptr を返す.
+		 */
+		Slot* find(int index)
+		{
+			if (index < 0) {
+				return nullptr;
+			}
+			if (static_cast<size_t>(index) < _dense.size()) {
+				return &_dense[index];
+			}
+			auto it = _sparse.find(index);
+			return it == _sparse.end() ? nullptr : &it->second;
+		}
+
+		/**
+		 * @brief 全ての要素について, 番号順に function を呼ぶ.
+		 */
+		template<class Function>
+		void forEach(Function function)
+		{
+			for (Slot& slot : _dense) {
+				function(slot);
+			}
+			for (auto& item : _sparse) {
+				function(item.second);
+			}
+		}
+
+		/**
+		 * @brief 格納している要素の数を取得する.
+		 */
+		size_t size() const
+		{
+			return _dense.size() + _sparse.size();
+		}
+
+	private:
+		/**
+		 * @brief 配列に格納する番号の, 参照された番号の数の 2 倍に対する余裕.
+		 */
+		static size_t const MAX_GAP = 1024;
+
+		std::vector<Slot> _dense;
+		std::map<int, Slot> _sparse;
+		size_t _count;
+	};
+
 	class TentativeTrack : public Track
 	{
 	public:
@@ -84,49 +220,696 @@ class VSQFileReader::Impl
 		}
 	};
 
+	/**
+	 * @brief 通知された内容から, 1 つのトラックを組み立てるハンドラー.
+	 */
+	class TrackBuilder : public VSQContentHandler
+	{
+	public:
+		/**
+		 * @param master [Master] セクションの内容の格納先. 不要な場合は nullptr を指定する.
+		 * @param mixer [Mixer] セクションの内容の格納先. 不要な場合は nullptr を指定する.
+		 */
+		explicit TrackBuilder(Master* master = nullptr, Mixer* mixer = nullptr)
+			: _master(master)
+			, _mixer(mixer)
+			, _hasContent(false)
+			, _curve(nullptr)
+		{}
+
+		void startTrack(int track, std::string const& name) override
+		{
+			_track.name(name);
+		}
+
+		void common(int track, Common const& common) override
+		{
+			_track.setCommon(common);
+			_hasContent = true;
+		}
+
+		void master(Master const& master) override
+		{
+			if (_master) {
+				*_master = master;
+			}
+		}
+
+		void mixer(Mixer const& mixer) override
+		{
+			if (_mixer) {
+				*_mixer = mixer;
+			}
+		}
+
+		void event(int track, int id, Event& item, int singerHandleIndex, int lyricHandleIndex, int vibratoHandleIndex, int noteHeadHandleIndex) override
+		{
+			_hasContent = true;
+			EventSlot* slot = _eventSlots.at(id);
+			if (!slot || slot->event) {
+				return;
+			}
+			slot->event.reset(new TentativeEvent(std::move(item)));
+			slot->event->singerHandleIndex = singerHandleIndex;
+			slot->event->lyricHandleIndex = lyricHandleIndex;
+			slot->event->vibratoHandleIndex = vibratoHandleIndex;
+			slot->event->noteHeadHandleIndex = noteHeadHandleIndex;
+		}
+
+		void handle(int track, int index, Handle& item) override
+		{
+			_hasContent = true;
+			HandleSlot* slot = _handleSlots.at(index);
+			if (slot && !slot->present) {
+				slot->handle = std::move(item);
+				slot->present = true;
+			}
+		}
+
+		void curvePoint(int track, std::string const& curveName, tick_t tick, int value) override
+		{
+			_hasContent = true;
+			// データ点はカーブごとに続けて通知されるので, 直前のカーブを使い回す
+			if (!_curve || curveName != _curveName) {
+				_curve = _track.curve(curveName);
+				_curveName = curveName;
+			}
+			if (_curve) {
+				_curve->addWithoutSort(tick, value);
+			}
+		}
+
+		/**
+		 * @brief 通知されたイベントにハンドルを埋め込み, トラックを組み立てる.
+		 * @return トラック. トラック名以外が何も通知されなかった場合は, トラック名以外が既定値のトラック.
+		 */
+		Track build()
+		{
+			if (!_hasContent) {
+				return std::move(_track);
+			}
+
+			// まずhandleをidに埋め込み. 最後に参照するイベントへはムーブし, それ以外へはコピーする
+			SlotTable<HandleSlot>& handleSlots = _handleSlots;
+			_eventSlots.forEach([&handleSlots](EventSlot& slot) {
+				if (!slot.event) {
+					return;
+				}
+				TentativeEvent const& item = *slot.event;
+				bool const hasSingerHandle = item.type() == EventType::SINGER || item.type() == EventType::ICON;
+				int const indices[] = { hasSingerHandle ? item.singerHandleIndex : -1, item.lyricHandleIndex, item.vibratoHandleIndex, item.noteHeadHandleIndex };
+				for (int index : indices) {
+					if (HandleSlot* handleSlot = handleSlots.find(index)) {
+						handleSlot->references++;
+					}
+				}
+			});
+			auto takeHandle = [&handleSlots](int index, Handle& destination) {
+				HandleSlot* slot = handleSlots.find(index);
+				if (!slot || !slot->present) {
+					return;
+				}
+				if (--slot->references == 0) {
+					destination = std::move(slot->handle);
+				} else {
+					destination = slot->handle;
+				}
+			};
+			_eventSlots.forEach([&takeHandle](EventSlot& slot) {
+				if (!slot.event) {
+					return;
+				}
+				TentativeEvent& item = *slot.event;
+				if (item.type() == EventType::SINGER) {
+					takeHandle(item.singerHandleIndex, item.singerHandle);
+				} else if (item.type() == EventType::ICON) {
+					takeHandle(item.singerHandleIndex, item.iconDynamicsHandle);
+				}
+				takeHandle(item.lyricHandleIndex, item.lyricHandle);
+				takeHandle(item.vibratoHandleIndex, item.vibratoHandle);
+				takeHandle(item.noteHeadHandleIndex, item.noteHeadHandle);
+			});
+
+			// idをeventListに埋め込み. イベント ID は番号順に振り, イベントは時刻順に並べる
+			std::vector<std::pair<int, TentativeEvent*>> ordered;
+			ordered.reserve(_eventSlots.size());
+			int count = 0;
+			_eventSlots.forEach([&ordered, &count](EventSlot& slot) {
+				if (slot.event) {
+					count++;
+					ordered.push_back(std::make_pair(count, slot.event.get()));
+				}
+			});
+			auto less = [](std::pair<int, TentativeEvent*> const& a, std::pair<int, TentativeEvent*> const& b) {
+				return Event::comp(a.second, b.second);
+			};
+			// [EventList] は通常時刻順に並んでいるので, 並べ替えが必要な場合だけ行う
+			if (!std::is_sorted(ordered.begin(), ordered.end(), less)) {
+				std::stable_sort(ordered.begin(), ordered.end(), less);
+			}
+			Event::List& events = _track.events();
+			events.clear();
+			for (auto const& item : ordered) {
+				events.addWithoutSort(std::move(static_cast<Event&>(*item.second)), item.first);
+			}
+
+			return std::move(_track);
+		}
+
+	private:
+		TentativeTrack _track;
+		Master* _master;
+		Mixer* _mixer;
+		bool _hasContent;
+		SlotTable<EventSlot> _eventSlots;
+		SlotTable<HandleSlot> _handleSlots;
+		BPList* _curve;
+		std::string _curveName;
+	};
+
+	/**
+	 * @brief 通知された内容から, トラックを組み立てずに, 曲の長さと最初の歌手名だけを求めるハンドラー.
+	 * @details TrackBuilder で組み立てたトラックと同じ結果になるよう, イベントは時刻・種類・ID の順に並べた時の末尾と,
+	 *          歌手変更イベントの先頭だけを, カーブはそれぞれ最後に通知されたデータ点だけを保持する.
+	 */
+	class TrackSummary : public VSQContentHandler
+	{
+	public:
+		TrackSummary()
+			: _hasContent(false)
+			, _hasLastEvent(false)
+			, _hasSinger(false)
+		{}
+
+		void common(int /*track*/, Common const& /*common*/) override
+		{
+			_hasContent = true;
+		}
+
+		void event(int /*track*/, int id, Event& item, int singerHandleIndex, int /*lyricHandleIndex*/, int /*vibratoHandleIndex*/, int /*noteHeadHandleIndex*/) override
+		{
+			_hasContent = true;
+			if (id < 0) {
+				return;
+			}
+			int const type = static_cast<int>(item.type());
+			if (!_hasLastEvent || std::make_tuple(_lastEvent.tick, _lastEvent.type, _lastEvent.id) < std::make_tuple(item.tick, type, id)) {
+				_hasLastEvent = true;
+				_lastEvent.tick = item.tick;
+				_lastEvent.type = type;
+				_lastEvent.id = id;
+				_lastEvent.end = item.tick + item.length();
+			}
+			if (item.type() == EventType::SINGER) {
+				if (!_hasSinger || std::make_pair(item.tick, id) < std::make_pair(_singer.tick, _singer.id)) {
+					_hasSinger = true;
+					_singer.tick = item.tick;
+					_singer.id = id;
+					_singer.handleIndex = singerHandleIndex;
+					_singer.ids = item.singerHandle.ids;
+				}
+			}
+		}
+
+		void handle(int /*track*/, int index, Handle& item) override
+		{
+			_hasContent = true;
+			if (0 <= index) {
+				_handleIds.insert(std::make_pair(index, item.ids));
+			}
+		}
+
+		void curvePoint(int /*track*/, std::string const& curveName, tick_t tick, int /*value*/) override
+		{
+			_hasContent = true;
+			_lastKeys[StringUtil::toLower(curveName)] = tick;
+		}
+
+		/**
+		 * @brief トラック名以外の内容が通知されたかどうかを取得する.
+		 * @return 通知された場合は <code>true</code> を返す. 返さない場合, 組み立てられるトラックは既定値のトラックとなる.
+		 */
+		bool hasContent() const
+		{
+			return _hasContent;
+		}
+
+		/**
+		 * @brief 末尾のイベントの終了時刻と, 曲の長さの計算に使うカーブの最後のデータ点の時刻のうち, 最大のものを取得する.
+		 * @param value 比較する初期値.
+		 * @return Tick 単位の時刻.
+		 */
+		tick_t maxTick(tick_t value) const
+		{
+			if (_hasLastEvent) {
+				value = std::max(value, _lastEvent.end);
+			}
+			for (std::string const& name : Sequence::curveNameList()) {
+				auto lastKey = _lastKeys.find(StringUtil::toLower(name));
+				if (lastKey != _lastKeys.end()) {
+					value = std::max(value, lastKey->second);
+				}
+			}
+			return value;
+		}
+
+		/**
+		 * @brief 最初の歌手変更イベントの歌手名を取得する.
+		 * @return 歌手名. 歌手変更イベントが無い場合は空文字.
+		 */
+		std::string singer() const
+		{
+			if (!_hasSinger) {
+				return "";
+			}
+			auto ids = _handleIds.find(_singer.handleIndex);
+			return ids == _handleIds.end() ? _singer.ids : ids->second;
+		}
+
+	private:
+		bool _hasContent;
+		bool _hasLastEvent;
+		bool _hasSinger;
+		struct {
+			tick_t tick;
+			int type;
+			int id;
+			tick_t end;
+		} _lastEvent;
+		struct {
+			tick_t tick;
+			int id;
+			int handleIndex;
+			std::string ids;
+		} _singer;
+		std::map<int, std::string> _handleIds;
+		std::map<std::string, tick_t> _lastKeys;
+	};
+
+	/**
+	 * @brief 通知された内容から, Sequence を組み立てるハンドラー.
+	 * @details トラックは endTrack の時点で組み立てるので, 組み立て途中のイベントとハンドルは 1 トラック分だけ保持する.
+	 */
+	class SequenceBuilder : public VSQContentHandler
+	{
+	public:
+		void tempo(Tempo const& tempo) override
+		{
+			_tempoList.push(tempo);
+		}
+
+		void timesig(Timesig const& timesig) override
+		{
+			_timesigList.push(timesig);
+		}
+
+		void startTrack(int track, std::string const& name) override
+		{
+			_current.reset(new TrackBuilder());
+			_current->startTrack(track, name);
+		}
+
+		void endTrack(int track) override
+		{
+			_tracks.push_back(_current->build());
+			_current.reset();
+		}
+
+		void common(int track, Common const& common) override
+		{
+			_current->common(track, common);
+		}
+
+		void master(Master const& master) override
+		{
+			_master = master;
+		}
+
+		void mixer(Mixer const& mixer) override
+		{
+			_mixer = mixer;
+		}
+
+		void event(int track, int id, Event& item, int singerHandleIndex, int lyricHandleIndex, int vibratoHandleIndex, int noteHeadHandleIndex) override
+		{
+			_current->event(track, id, item, singerHandleIndex, lyricHandleIndex, vibratoHandleIndex, noteHeadHandleIndex);
+		}
+
+		void handle(int track, int index, Handle& item) override
+		{
+			_current->handle(track, index, item);
+		}
+
+		void curvePoint(int track, std::string const& curveName, tick_t tick, int value) override
+		{
+			_current->curvePoint(track, curveName, tick, value);
+		}
+
+		/**
+		 * @brief 組み立てたトラックのリストを取得する.
+		 * @return トラックのリスト.
+		 */
+		std::vector<Track>& tracks()
+		{
+			return _tracks;
+		}
+
+		/**
+		 * @brief 組み立てた内容を Sequence に格納し, 曲の長さを計算する.
+		 * @param[out] sequence 格納先.
+		 */
+		void assignTo(Sequence& sequence)
+		{
+			bool const hasTracks = !_tracks.empty();
+			// 曲の長さは, テンポと拍子を格納した後で計算し直す
+			sequence.setTrackLoaders(std::move(_tracks), std::vector<std::function<Track()>>(), 0);
+			if (hasTracks) {
+				sequence.master = _master;
+				sequence.mixer = _mixer;
+			}
+			sequence.tempoList = _tempoList;
+			sequence.timesigList = _timesigList;
+
+			// 曲の長さを計算
+			sequence.tempoList.updateTempoInfo();
+			sequence.updateTotalTicks();
+		}
+
+	private:
+		TempoList _tempoList;
+		TimesigList _timesigList;
+		Master _master;
+		Mixer _mixer;
+		std::vector<Track> _tracks;
+		std::unique_ptr<TrackBuilder> _current;
+	};
+
 public:
 	Impl()
+		: lazy(false)
+		, parallel(false)
 	{}
 
 	~Impl()
 	{}
 
 	void read(Sequence& sequence, InputStream& stream, std::string const& encoding)
+	{
+		if (lazy) {
+			readLazily(sequence, stream, encoding);
+			return;
+		}
+		SequenceBuilder builder;
+		if (parallel) {
+			readConcurrently(stream, builder, encoding);
+		} else {
+			parse(stream, builder, encoding);
+		}
+		builder.assignTo(sequence);
+	}
+
+	/**
+	 * @brief ストリームから VSQ ファイルを読み込み, 読み込んだ内容をトラック 1 つずつ handler に通知する.
+	 * @details メモリに保持するのは, 読み込み中のトラック 1 つ分の MTrk チャンク, MIDI イベントとメタテキストだけとなる.
+	 */
+	void parse(InputStream& stream, VSQContentHandler& handler, std::string const& encoding)
+	{
+		int format, timeFormat;
+		SMFReader::readTracks(stream, [&](int index, std::vector<MidiEvent> const& events) {
+			if (index == 0) {
+				parseTempoAndTimesig(events, handler);
+			} else {
+				parseTrack(events, index - 1, encoding, handler);
+			}
+		}, format, timeFormat);
+	}
+
+	/**
+	 * @brief MTrk チャンクのデコードと, 各トラックの読み込みをワーカースレッド上で行う.
+	 * @details トラックはそれぞれ別の TrackBuilder で組み立て, トラック順に builder へ格納する.
+	 */
+	void readConcurrently(InputStream& stream, SequenceBuilder& builder, std::string const& encoding)
 	{
 		std::vector<std::vector<MidiEvent>> events;
 		SMFReader reader;
+		reader.parallel(true);
 		int format, timeFormat;
 		reader.read(stream, events, format, timeFormat);
 
 		int num_track = events.size();
-		sequence.tracks().clear();
-		for (int i = 1; i < num_track; i++) {
-			TextStream textStream;
-			std::string trackName;
-			getMetatextByMidiEventList(events[i], encoding, textStream, trackName);
-			Track track;
-			if (i == 1) {
+		if (0 < num_track) {
+			parseTempoAndTimesig(events[0], builder);
+		}
+		std::vector<Track> tracks(std::max(0, num_track - 1));
+		Master master;
+		Mixer mixer;
+		ThreadUtil::runConcurrently(tracks.size(), [&](int index) {
+			TrackBuilder trackBuilder(&master, &mixer);
+			parseTrack(events[index + 1], index, encoding, trackBuilder);
+			tracks[index] = trackBuilder.build();
+		});
+		builder.master(master);
+		builder.mixer(mixer);
+		builder.tracks().swap(tracks);
+	}
+
+	/**
+	 * @brief テンポトラックの MIDI イベントのリストから, テンポ変更と拍子変更を読み込んで handler に通知する.
+	 */
+	void parseTempoAndTimesig(std::vector<MidiEvent> const& events, VSQContentHandler& handler)
+	{
+		TempoList tempoList;
+		parseTempoList(events, tempoList);
+		for (int i = 0; i < tempoList.size(); i++) {
+			handler.tempo(tempoList.get(i));
+		}
+		TimesigList timesigList;
+		parseTimesigList(events, timesigList);
+		for (int i = 0; i < timesigList.size(); i++) {
+			handler.timesig(timesigList.get(i));
+		}
+	}
+
+	/**
+	 * @brief 歌唱トラックの MIDI イベントのリストから, トラックの内容を読み込んで handler に通知する.
+	 * @details 読み込まないトラックについては, startTrack と endTrack (先頭のトラックの場合は Master と Mixer も) だけを通知する.
+	 * @param events MIDI イベントのリスト.
+	 * @param track トラックの番号. Sequence::track に指定する番号.
+	 * @param encoding マルチバイト文字のテキストエンコーディング(現在は Shift_JIS 固定で, 引数は無視される).
+	 * @param handler 通知先.
+	 */
+	void parseTrack(std::vector<MidiEvent> const& events, int track, std::string const& encoding, VSQContentHandler& handler)
+	{
+		if (!isTrackSelected(track)) {
+			if (track == 0) {
+				TextStream textStream;
+				std::string trackName;
+				getMetatextByMidiEventList(events, encoding, textStream, trackName);
+				handler.startTrack(track, trackName);
 				Master master;
 				Mixer mixer;
-				track = getTrackByTextStream(textStream, &master, &mixer);
-				sequence.master = master;
-				sequence.mixer = mixer;
+				parseMasterAndMixer(textStream, master, mixer);
+				handler.master(master);
+				handler.mixer(mixer);
 			} else {
-				track = getTrackByTextStream(textStream);
+				handler.startTrack(track, getTrackName(events));
 			}
-			track.name(trackName);
-			sequence.tracks().push_back(track);
+			handler.endTrack(track);
+			return;
 		}
+		TextStream textStream;
+		std::string trackName;
+		getMetatextByMidiEventList(events, encoding, textStream, trackName);
+		handler.startTrack(track, trackName);
+		parseTrackText(textStream, track, track == 0, handler);
+		handler.endTrack(track);
+	}
+
+	/**
+	 * @brief 指定した番号のトラックを読み込むかどうかを取得する.
+	 * @param trackIndex トラックの番号. Sequence::track に指定する番号.
+	 * @return 読み込む場合は <code>true</code> を返す.
+	 */
+	bool isTrackSelected(int trackIndex) const
+	{
+		return options.tracks.empty() || options.tracks.find(trackIndex) != options.tracks.end();
+	}
 
-		parseTempoList(events[0], sequence.tempoList);
-		parseTimesigList(events[0], sequence.timesigList);
+	/**
+	 * @brief トラックの読み込みを, 各トラックを初めて参照する時まで遅延させて VSQ ファイルを読み込む.
+	 * @details この時点ではトラックを組み立てず, テンポ・拍子, トラック名, Master と Mixer, 曲の長さと各トラックの最初の歌手名だけを求める.
+	 *          読み込むトラックのメタテキストはここで組み立てて保持し, トラックを参照した時にそこから組み立てる.
+	 */
+	void readLazily(Sequence& sequence, InputStream& stream, std::string const& encoding)
+	{
+		std::vector<std::vector<uint8_t>> chunks;
+		int format, timeFormat;
+		SMFReader::readChunks(stream, chunks, format, timeFormat);
 
-		// 曲の長さを計算
+		int const num_track = chunks.size();
+		int const count = std::max(0, num_track - 1);
+		std::vector<std::string> trackNames(count);
+		std::vector<std::shared_ptr<TextStream>> texts(count);
+		std::vector<TrackSummary> summaries(count);
+		auto indexTrack = [&](int track) {
+			std::vector<uint8_t> chunk;
+			chunk.swap(chunks[track + 1]);
+			// Master と Mixer を得るため, 先頭の歌唱トラックは読み込まない場合もメタテキストを組み立てる
+			if (track != 0 && !isTrackSelected(track)) {
+				trackNames[track] = getTrackName(chunk, encoding);
+				return;
+			}
+			std::vector<MidiEvent> events;
+			SMFReader::decodeChunk(chunk, events);
+			texts[track] = std::make_shared<TextStream>();
+			getMetatextByMidiEventList(events, encoding, *texts[track], trackNames[track]);
+			if (isTrackSelected(track)) {
+				// 曲の長さと歌手名には影響しないので, ビブラートと音符の表情のハンドルは読み飛ばす
+				Impl impl;
+				impl.options = options;
+				impl.options.skipVibratoHandles = true;
+				impl.options.skipNoteHeadHandles = true;
+				TextStream copy = *texts[track];
+				copy.setPointer(-1);
+				impl.parseTrackText(copy, track, false, summaries[track]);
+			}
+		};
+		if (parallel) {
+			ThreadUtil::runConcurrently(count, indexTrack);
+		} else {
+			for (int track = 0; track < count; ++track) {
+				indexTrack(track);
+			}
+		}
+
+		if (0 < count) {
+			TextStream copy = *texts[0];
+			copy.setPointer(-1);
+			Master master;
+			Mixer mixer;
+			parseMasterAndMixer(copy, master, mixer);
+			sequence.master = master;
+			sequence.mixer = mixer;
+		}
+
+		std::vector<Track> tracks;
+		std::vector<std::function<Track()>> loaders;
+		for (int track = 0; track < count; ++track) {
+			std::string const& trackName = trackNames[track];
+			std::function<Track()> loader;
+			if (isTrackSelected(track)) {
+				std::shared_ptr<TextStream> text = texts[track];
+				Options const options = this->options;
+				loader = [text, track, trackName, options]() {
+					TextStream copy = *text;
+					copy.setPointer(-1);
+					Impl impl;
+					impl.options = options;
+					TrackBuilder builder;
+					builder.startTrack(track, trackName);
+					// Master と Mixer は読み込み済みなので, 読み飛ばす
+					impl.parseTrackText(copy, track, false, builder);
+					return builder.build();
+				};
+			}
+			// 読み込むまでの間, トラック名と最初の歌手名だけを持つ仮のトラックを置いておく
+			if (summaries[track].hasContent()) {
+				tracks.push_back(Track(trackName, summaries[track].singer()));
+			} else {
+				Track placeholder;
+				placeholder.name(trackName);
+				tracks.push_back(std::move(placeholder));
+			}
+			loaders.push_back(loader);
+		}
+
+		std::vector<MidiEvent> events;
+		if (0 < num_track) {
+			SMFReader::decodeChunk(chunks[0], events);
+		}
+		parseTempoList(events, sequence.tempoList);
+		parseTimesigList(events, sequence.timesigList);
 		sequence.tempoList.updateTempoInfo();
-		sequence.updateTotalTicks();
+
+		// 読み込まないトラックと内容の無いトラックは既定値のトラックとなり, 曲の長さには影響しない
+		tick_t totalTicks = sequence.preMeasureTicks();
+		for (TrackSummary const& summary : summaries) {
+			totalTicks = summary.maxTick(totalTicks);
+		}
+
+		sequence.setTrackLoaders(std::move(tracks), std::move(loaders), totalTicks);
 	}
 
-	Event parseEvent(TextStream& stream, std::string& lastLine, EventType& type, int& lyricHandleIndex, int& singerHandleIndex, int& vibratoHandleIndex, int& noteHeadHandleIndex)
+	/**
+	 * @brief メタテキストから, Master と Mixer のセクションだけを読み込む. [EventList] セクションに達した時点で読み込みを終える.
+	 * @param stream 読み込むテキストストリーム.
+	 * @param[out] master 読み込まれた Master 情報.
+	 * @param[out] mixer 読み込まれた Mixer 情報.
+	 */
+	void parseMasterAndMixer(TextStream& stream, Master& master, Mixer& mixer)
+	{
+		MetaTextLexer lexer(stream);
+		lexer.next();
+		while (!lexer.line().empty()) {
+			if (lexer.line() == "[Master]") {
+				master = parseMaster(lexer);
+			} else if (lexer.line() == "[Mixer]") {
+				mixer = parseMixer(lexer);
+			} else if (lexer.line() == "[EventList]") {
+				break;
+			} else if (lexer.ready()) {
+				lexer.next();
+				continue;
+			} else {
+				break;
+			}
+			if (!lexer.ready()) {
+				break;
+			}
+		}
+	}
+
+	/**
+	 * @brief MIDI イベントのリストから, メタテキストを組み立てずにトラック名だけを取得する.
+	 * @param events MIDI イベントのリスト.
+	 * @return トラック名.
+	 */
+	static std::string getTrackName(std::vector<MidiEvent> const& events)
+	{
+		std::string trackName;
+		for (MidiEvent const& item : events) {
+			if (item.firstByte == 0xff && item.data.size() > 0 && item.data[0] == 0x03) {
+				std::string name(item.data.begin() + 1, item.data.end());
+				trackName = CP932Converter::convertToUTF8(name);
+			}
+		}
+		return trackName;
+	}
+
+	/**
+	 * @brief MTrk チャンクのデータ部から, メタテキストを組み立てずにトラック名だけを取得する.
+	 * @param chunk チャンクのデータ部.
+	 * @param encoding マルチバイト文字のテキストエンコーディング(現在は Shift_JIS 固定で, 引数は無視される).
+	 * @return トラック名.
+	 */
+	static std::string getTrackName(std::vector<uint8_t> const& chunk, std::string const& encoding)
+	{
+		std::string trackName;
+		tick_t tick = 0;
+		uint8_t last_status_byte = 0x00;
+		size_t position = 0;
+		size_t const length = chunk.size();
+		while (position < length) {
+			MidiEvent item = MidiEvent::read(chunk.data(), length, position, tick, last_status_byte);
+			if (item.firstByte == 0xff && item.data.size() > 0 && item.data[0] == 0x03) {
+				std::string name(item.data.begin() + 1, item.data.end());
+				trackName = CP932Converter::convertToUTF8(name);
+			}
+		}
+		return trackName;
+	}
+
+	Event parseEvent(MetaTextLexer& lexer, EventType& type, int& lyricHandleIndex, int& singerHandleIndex, int& vibratoHandleIndex, int& noteHeadHandleIndex)
 	{
 		Event result(0, EventType::UNKNOWN);
 		type = EventType::UNKNOWN;
@@ -143,56 +926,129 @@ public:
 		result.demDecGainRate = 50;
 		result.demAccent = 50;
 		result.vibratoDelay = 0;
-		lastLine = stream.readLine();
-		while (lastLine.find("[") != 0) {
-			std::vector<std::string> parameters = StringUtil::explode("=", lastLine);
-			std::string search = parameters[0];
-			if (search == "Type") {
-				if (parameters[1] == "Anote") {
-					type = EventType::NOTE;
-				} else if (parameters[1] == "Singer") {
-					type = EventType::SINGER;
-				} else if (parameters[1] == "Aicon") {
-					type = EventType::ICON;
-				} else {
-					type = EventType::UNKNOWN;
-				}
-			} else if (search == "Length") {
-				result.length(StringUtil::parseInt<tick_t>(parameters[1]));
-			} else if (search == "Note#") {
-				result.note = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "Dynamics") {
-				result.dynamics = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "PMBendDepth") {
-				result.pmBendDepth = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "PMBendLength") {
-				result.pmBendLength = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "DEMdecGainRate") {
-				result.demDecGainRate = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "DEMaccent") {
-				result.demAccent = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "LyricHandle") {
-				lyricHandleIndex = Handle::getHandleIndexFromString(parameters[1]);
-			} else if (search == "IconHandle") {
-				singerHandleIndex = Handle::getHandleIndexFromString(parameters[1]);
-			} else if (search == "VibratoHandle") {
-				vibratoHandleIndex = Handle::getHandleIndexFromString(parameters[1]);
-			} else if (search == "VibratoDelay") {
-				result.vibratoDelay = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "PMbPortamentoUse") {
-				result.pmbPortamentoUse = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "NoteHeadHandle") {
-				noteHeadHandleIndex = Handle::getHandleIndexFromString(parameters[1]);
-			}
-			if (! stream.ready()) {
-				break;
-			}
-			lastLine = stream.readLine();
+		lexer.next();
+		while (!lexer.line().startsWith('[')) {
+			MetaTextLexer::Range const& key = lexer.key();
+			MetaTextLexer::Range const& value = lexer.value();
+			switch (key.hash()) {
+			case MetaTextLexer::hash("Type"):
+				if (key == "Type") {
+					if (value == "Anote") {
+						type = EventType::NOTE;
+					} else if (value == "Singer") {
+						type = EventType::SINGER;
+					} else if (value == "Aicon") {
+						type = EventType::ICON;
+					} else {
+						type = EventType::UNKNOWN;
+					}
+				}
+				break;
+			case MetaTextLexer::hash("Length"):
+				if (key == "Length") {
+					result.length(value.toInt<tick_t>());
+				}
+				break;
+			case MetaTextLexer::hash("Note#"):
+				if (key == "Note#") {
+					result.note = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("Dynamics"):
+				if (key == "Dynamics") {
+					result.dynamics = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("PMBendDepth"):
+				if (key == "PMBendDepth") {
+					result.pmBendDepth = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("PMBendLength"):
+				if (key == "PMBendLength") {
+					result.pmBendLength = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("DEMdecGainRate"):
+				if (key == "DEMdecGainRate") {
+					result.demDecGainRate = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("DEMaccent"):
+				if (key == "DEMaccent") {
+					result.demAccent = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("LyricHandle"):
+				if (key == "LyricHandle") {
+					lyricHandleIndex = parseIndex(value);
+				}
+				break;
+			case MetaTextLexer::hash("IconHandle"):
+				if (key == "IconHandle") {
+					singerHandleIndex = parseIndex(value);
+				}
+				break;
+			case MetaTextLexer::hash("VibratoHandle"):
+				if (key == "VibratoHandle") {
+					vibratoHandleIndex = parseIndex(value);
+				}
+				break;
+			case MetaTextLexer::hash("VibratoDelay"):
+				if (key == "VibratoDelay") {
+					result.vibratoDelay = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("PMbPortamentoUse"):
+				if (key == "PMbPortamentoUse") {
+					result.pmbPortamentoUse = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("NoteHeadHandle"):
+				if (key == "NoteHeadHandle") {
+					noteHeadHandleIndex = parseIndex(value);
+				}
+				break;
+			}
+			if (! lexer.ready()) {
+				break;
+			}
+			lexer.next();
 		}
 		return result;
 	}
 
-	Handle parseHandle(TextStream& stream, int index, std::string& lastLine)
+	/**
+	 * @brief 現在のセクションの内容を解析せずに読み飛ばす. 次のセクションの先頭の行, またはメタテキストの末尾の行で読み込みを終える.
+	 * @param lexer 読み込むメタテキスト.
+	 */
+	static void skipSection(MetaTextLexer& lexer)
+	{
+		lexer.next();
+		while (!lexer.line().startsWith('[')) {
+			if (!lexer.ready()) {
+				break;
+			}
+			lexer.next();
+		}
+	}
+
+	/**
+	 * @brief "h#0001" や "ID#0001" のような指定子から, "#" に続く番号を取得する.
+	 * @param value 指定子の範囲.
+	 * @return 番号.
+	 */
+	static int parseIndex(MetaTextLexer::Range const& value)
+	{
+		char const* sharp = value.empty() ? nullptr : static_cast<char const*>(std::memchr(value.begin, '#', value.size()));
+		if (!sharp) {
+			throw StringUtil::IntegerParseException();
+		}
+		char const* end = static_cast<char const*>(std::memchr(sharp + 1, '#', value.end - (sharp + 1)));
+		return StringUtil::parseInt<int>(sharp + 1, end ? end : value.end);
+	}
+
+	Handle parseHandle(MetaTextLexer& lexer, int index)
 	{
 		TentativeHandle result(HandleType::UNKNOWN);
 		result.index = index;
@@ -213,81 +1069,26 @@ public:
 		result.duration = 0;
 		result.depth = 64;
 
-		std::string tmpDepthBPX = "";
-		std::string tmpDepthBPY = "";
-		std::string tmpDepthBPNum = "";
+		MetaTextLexer::Range tmpDepthBPX;
+		MetaTextLexer::Range tmpDepthBPY;
+		MetaTextLexer::Range tmpDepthBPNum;
 
-		std::string tmpRateBPX = "";
-		std::string tmpRateBPY = "";
-		std::string tmpRateBPNum = "";
+		MetaTextLexer::Range tmpRateBPX;
+		MetaTextLexer::Range tmpRateBPY;
+		MetaTextLexer::Range tmpRateBPNum;
 
-		std::string tmpDynBPX = "";
-		std::string tmpDynBPY = "";
-		std::string tmpDynBPNum = "";
+		MetaTextLexer::Range tmpDynBPX;
+		MetaTextLexer::Range tmpDynBPY;
+		MetaTextLexer::Range tmpDynBPNum;
 
 		// "["にぶち当たるまで読込む
-		lastLine = stream.readLine();
-		while (lastLine.find("[") != 0) {
-			std::vector<std::string> parameters = StringUtil::explode("=", lastLine);
-			std::string search = parameters[0];
-			if (search == "Language") {
-				result.setHandleType(HandleType::SINGER);
-				result.language = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "Program") {
-				result.program = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "IconID") {
-				result.iconId = parameters[1];
-			} else if (search == "IDS") {
-				result.ids = parameters[1];
-				for (int i = 2; i < parameters.size(); i++) {
-					result.ids = result.ids + "=" + parameters[i];
-				}
-			} else if (search == "Original") {
-				result.original = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "Caption") {
-				result.caption = parameters[1];
-				for (int i = 2; i < parameters.size(); i++) {
-					result.caption = result.caption + "=" + parameters[i];
-				}
-			} else if (search == "Length") {
-				result.length(StringUtil::parseInt<tick_t>(parameters[1]));
-			} else if (search == "StartDepth") {
-				result.startDepth = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "DepthBPNum") {
-				tmpDepthBPNum = parameters[1];
-			} else if (search == "DepthBPX") {
-				tmpDepthBPX = parameters[1];
-			} else if (search == "DepthBPY") {
-				tmpDepthBPY = parameters[1];
-			} else if (search == "StartRate") {
-				result.setHandleType(HandleType::VIBRATO);
-				result.startRate = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "RateBPNum") {
-				tmpRateBPNum = parameters[1];
-			} else if (search == "RateBPX") {
-				tmpRateBPX = parameters[1];
-			} else if (search == "RateBPY") {
-				tmpRateBPY = parameters[1];
-			} else if (search == "Duration") {
-				result.setHandleType(HandleType::NOTE_HEAD);
-				result.duration = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "Depth") {
-				result.depth = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "StartDyn") {
-				result.setHandleType(HandleType::DYNAMICS);
-				result.startDyn = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "EndDyn") {
-				result.setHandleType(HandleType::DYNAMICS);
-				result.endDyn = StringUtil::parseInt<int>(parameters[1]);
-			} else if (search == "DynBPNum") {
-				tmpDynBPNum = parameters[1];
-			} else if (search == "DynBPX") {
-				tmpDynBPX = parameters[1];
-			} else if (search == "DynBPY") {
-				tmpDynBPY = parameters[1];
-			} else if (search.find("L") == 0 && search.size() >= 2) {
-				int index = StringUtil::parseInt<int>(search.substr(1, 1));
-				Lyric lyric = parseLyric(parameters[1]);
+		lexer.next();
+		while (!lexer.line().startsWith('[')) {
+			MetaTextLexer::Range const& key = lexer.key();
+			MetaTextLexer::Range const& value = lexer.value();
+			if (key.startsWith('L') && key.size() >= 2 && '0' <= key.begin[1] && key.begin[1] <= '9') {
+				int index = key.begin[1] - '0';
+				Lyric lyric = parseLyric(value);
 				result.setHandleType(HandleType::LYRIC);
 				if (result.size() <= index + 1) {
 					int amount = index + 1 - result.size();
@@ -296,24 +1097,142 @@ public:
 					}
 				}
 				result.set(index, lyric);
+			} else {
+				switch (key.hash()) {
+				case MetaTextLexer::hash("Language"):
+					if (key == "Language") {
+						result.setHandleType(HandleType::SINGER);
+						result.language = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("Program"):
+					if (key == "Program") {
+						result.program = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("IconID"):
+					if (key == "IconID") {
+						result.iconId = value.toString();
+					}
+					break;
+				case MetaTextLexer::hash("IDS"):
+					if (key == "IDS") {
+						result.ids = lexer.rest().toString();
+					}
+					break;
+				case MetaTextLexer::hash("Original"):
+					if (key == "Original") {
+						result.original = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("Caption"):
+					if (key == "Caption") {
+						result.caption = lexer.rest().toString();
+					}
+					break;
+				case MetaTextLexer::hash("Length"):
+					if (key == "Length") {
+						result.length(value.toInt<tick_t>());
+					}
+					break;
+				case MetaTextLexer::hash("StartDepth"):
+					if (key == "StartDepth") {
+						result.startDepth = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("DepthBPNum"):
+					if (key == "DepthBPNum") {
+						tmpDepthBPNum = value;
+					}
+					break;
+				case MetaTextLexer::hash("DepthBPX"):
+					if (key == "DepthBPX") {
+						tmpDepthBPX = value;
+					}
+					break;
+				case MetaTextLexer::hash("DepthBPY"):
+					if (key == "DepthBPY") {
+						tmpDepthBPY = value;
+					}
+					break;
+				case MetaTextLexer::hash("StartRate"):
+					if (key == "StartRate") {
+						result.setHandleType(HandleType::VIBRATO);
+						result.startRate = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("RateBPNum"):
+					if (key == "RateBPNum") {
+						tmpRateBPNum = value;
+					}
+					break;
+				case MetaTextLexer::hash("RateBPX"):
+					if (key == "RateBPX") {
+						tmpRateBPX = value;
+					}
+					break;
+				case MetaTextLexer::hash("RateBPY"):
+					if (key == "RateBPY") {
+						tmpRateBPY = value;
+					}
+					break;
+				case MetaTextLexer::hash("Duration"):
+					if (key == "Duration") {
+						result.setHandleType(HandleType::NOTE_HEAD);
+						result.duration = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("Depth"):
+					if (key == "Depth") {
+						result.depth = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("StartDyn"):
+					if (key == "StartDyn") {
+						result.setHandleType(HandleType::DYNAMICS);
+						result.startDyn = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("EndDyn"):
+					if (key == "EndDyn") {
+						result.setHandleType(HandleType::DYNAMICS);
+						result.endDyn = value.toInt<int>();
+					}
+					break;
+				case MetaTextLexer::hash("DynBPNum"):
+					if (key == "DynBPNum") {
+						tmpDynBPNum = value;
+					}
+					break;
+				case MetaTextLexer::hash("DynBPX"):
+					if (key == "DynBPX") {
+						tmpDynBPX = value;
+					}
+					break;
+				case MetaTextLexer::hash("DynBPY"):
+					if (key == "DynBPY") {
+						tmpDynBPY = value;
+					}
+					break;
+				}
 			}
-			if (! stream.ready()) {
+			if (! lexer.ready()) {
 				break;
 			}
-			lastLine = stream.readLine();
+			lexer.next();
 		}
 
 		// parse RateBPX and RateBPY
 		if (result.type() == HandleType::VIBRATO) {
-			if (tmpRateBPNum != "") {
-				result.rateBP = VibratoBPList(tmpRateBPNum, tmpRateBPX, tmpRateBPY);
+			if (!tmpRateBPNum.empty()) {
+				result.rateBP = VibratoBPList(tmpRateBPNum.toString(), tmpRateBPX.toString(), tmpRateBPY.toString());
 			} else {
 				result.rateBP = VibratoBPList();
 			}
 
 			// parse DepthBPX, DepthBPY
-			if (tmpDepthBPNum != "") {
-				result.depthBP = VibratoBPList(tmpDepthBPNum, tmpDepthBPX, tmpDepthBPY);
+			if (!tmpDepthBPNum.empty()) {
+				result.depthBP = VibratoBPList(tmpDepthBPNum.toString(), tmpDepthBPX.toString(), tmpDepthBPY.toString());
 			} else {
 				result.depthBP = VibratoBPList();
 			}
@@ -322,8 +1241,8 @@ public:
 			result.rateBP = VibratoBPList();
 		}
 
-		if (tmpDynBPNum != "") {
-			result.dynBP = VibratoBPList(tmpDynBPNum, tmpDynBPX, tmpDynBPY);
+		if (!tmpDynBPNum.empty()) {
+			result.dynBP = VibratoBPList(tmpDynBPNum.toString(), tmpDynBPX.toString(), tmpDynBPY.toString());
 		} else {
 			result.dynBP = VibratoBPList();
 		}
@@ -393,7 +1312,7 @@ public:
 		tempoList.updateTempoInfo();
 	}
 
-	Common parseCommon(TextStream& stream, std::string& lastLine)
+	Common parseCommon(MetaTextLexer& lexer)
 	{
 		Common common;
 		common.version = "";
@@ -401,37 +1320,54 @@ public:
 		common.color = "0,0,0";
 		common.dynamicsMode = DynamicsMode::STANDARD;
 		common.playMode(PlayMode::PLAY_WITH_SYNTH);
-		lastLine = stream.readLine();
-		while (lastLine.find("[") != 0) {
-			auto spl = StringUtil::explode("=", lastLine);
-			std::string search = spl[0];
-			if (search == "Version") {
-				common.version = spl[1];
-			} else if (search == "Name") {
-				common.name = spl[1];
-			} else if (search == "Color") {
-				common.color = spl[1];
-			} else if (search == "DynamicsMode") {
-				common.dynamicsMode = StringUtil::parseInt<DynamicsMode>(spl[1]);
-			} else if (search == "PlayMode") {
-				common.playMode(StringUtil::parseInt<PlayMode>(spl[1]));
-			}
-			if (!stream.ready()) {
-				break;
-			}
-			lastLine = stream.readLine();
+		lexer.next();
+		while (!lexer.line().startsWith('[')) {
+			MetaTextLexer::Range const& key = lexer.key();
+			MetaTextLexer::Range const& value = lexer.value();
+			switch (key.hash()) {
+			case MetaTextLexer::hash("Version"):
+				if (key == "Version") {
+					common.version = value.toString();
+				}
+				break;
+			case MetaTextLexer::hash("Name"):
+				if (key == "Name") {
+					common.name = value.toString();
+				}
+				break;
+			case MetaTextLexer::hash("Color"):
+				if (key == "Color") {
+					common.color = value.toString();
+				}
+				break;
+			case MetaTextLexer::hash("DynamicsMode"):
+				if (key == "DynamicsMode") {
+					common.dynamicsMode = value.toInt<DynamicsMode>();
+				}
+				break;
+			case MetaTextLexer::hash("PlayMode"):
+				if (key == "PlayMode") {
+					common.playMode(value.toInt<PlayMode>());
+				}
+				break;
+			}
+			if (!lexer.ready()) {
+				break;
+			}
+			lexer.next();
 		}
 		return common;
 	}
 
 	/**
 	 * @brief 文字列を元に Lyric オブジェクトを作成する.
+	 * @details 引用符で囲まれた "," を区切りとみなさない CSV として, 一時的な文字列を作らずに 1 回の走査で解析する.
 	 * @param line 「"あ","a",0.0000,0.0」などのような文字列.
 	 */
-	Lyric parseLyric(std::string const& line)
+	static Lyric parseLyric(MetaTextLexer::Range const& line)
 	{
 		Lyric lyric("", "");
-		if (line.size() == 0) {
+		if (line.empty()) {
 			lyric.phrase = "a";
 			lyric.phoneticSymbol("a");
 			lyric.lengthRatio = 1.0;
@@ -439,113 +1375,135 @@ public:
 			lyric.consonantAdjustment("0");
 			return lyric;
 		}
-		int len = line.size();
-		int indx = 0;
-		int dquote_count = 0;
-		std::string work = "";
-		std::string consonantAdjustment = "";
-		for (int i = 0; i < len; i++) {
-			char c = line[i];
-			if (c == ',' || i + 1 == len) {
-				if (i + 1 == len) {
-					work = work + c;
-				}
-				if (dquote_count % 2 == 0) {
-					// ,の左側に偶数個の"がある場合→,は区切り文字
-					indx = indx + 1;
-					std::string search = "\"";
-					if (indx == 1) {
-						// phrase
-						work = StringUtil::replace(work, "\"\"", "\"");   // "は""として保存される
-						if (work.find(search) == 0 && work.find_last_of(search) == (work.size() - search.size())) {
-							int l = work.size();
-							if (l > search.size() * 2) {
-								lyric.phrase = work.substr(search.size(), l - search.size() * 2);
-							} else {
-								lyric.phrase = "a";
-							}
-						} else {
-							lyric.phrase = work;
-						}
-						work = "";
-					} else if (indx == 2) {
-						// symbols
-						std::string symbols = "";
-						if ((work.find(search) == 0) && (work.find_last_of(search) == (work.size() - search.size()))) {
-							int l = work.size();
-							if (l > search.size() * 2) {
-								symbols = work.substr(search.size(), l - search.size() * 2);
-							} else {
-								symbols = "a";
-							}
-						} else {
-							symbols = work;
-						}
-						lyric.phoneticSymbol(symbols);
-						work = "";
-					} else if (indx == 3) {
-						// lengthRatio
-						lyric.lengthRatio = atof(work.c_str());
-						work = "";
+		std::vector<int> consonantAdjustment;
+		int symbolCount = 0;
+		int fieldIndex = 0;
+		int dquoteCount = 0;
+		char const* fieldBegin = line.begin;
+		for (char const* p = line.begin; p <= line.end; ++p) {
+			if (p < line.end) {
+				if (*p == '"') {
+					dquoteCount++;
+					continue;
+				}
+				// ,の左側に奇数個の"がある場合→,は歌詞等の一部
+				if (*p != ',' || dquoteCount % 2 != 0) {
+					continue;
+				}
+			}
+			MetaTextLexer::Range field(fieldBegin, p);
+			fieldBegin = p + 1;
+			fieldIndex++;
+			if (fieldIndex == 1) {
+				parseLyricPhrase(field, lyric.phrase);
+			} else if (fieldIndex == 2) {
+				// symbols
+				if (isQuoted(field)) {
+					if (field.size() > 2) {
+						lyric.phoneticSymbol(field.begin + 1, field.end - 1);
 					} else {
-						if (indx - 3 <= lyric._phoneticSymbol.size()) {
-							// consonant adjustment
-							if (indx - 3 == 1) {
-								consonantAdjustment = consonantAdjustment + work;
-							} else {
-								consonantAdjustment = consonantAdjustment + "," + work;
-							}
-						} else {
-							// protected
-							lyric.isProtected = (work == "1");
-						}
-						work = "";
+						lyric.phoneticSymbol("a");
 					}
 				} else {
-					// ,の左側に奇数個の"がある場合→,は歌詞等の一部
-					work = work + "" + c;
+					lyric.phoneticSymbol(field.begin, field.end);
 				}
-			} else {
-				work = work + "" + c;
-				if (c == '"') {
-					dquote_count = dquote_count + 1;
+				symbolCount = lyric.phoneticSymbolList().size();
+			} else if (fieldIndex == 3) {
+				// lengthRatio
+				lyric.lengthRatio = parseDouble(field);
+			} else if (fieldIndex - 3 <= symbolCount) {
+				// consonant adjustment
+				int value = 0;
+				try {
+					value = StringUtil::parseInt<int>(field.begin, field.end);
+				} catch (...) {
 				}
+				consonantAdjustment.push_back(value);
+			} else {
+				// protected
+				lyric.isProtected = (field == "1");
 			}
 		}
-		lyric.consonantAdjustment(consonantAdjustment);
+		if (consonantAdjustment.empty()) {
+			consonantAdjustment.push_back(0);
+		}
+		lyric.consonantAdjustmentList(consonantAdjustment);
 
 		return lyric;
 	}
 
 	/**
-	 * @brief テキストストリームから読み込むことで Master のオブジェクトを作成する.
-	 * @param stream 読み込むテキストストリーム.
-	 * @param lastLine 読み込んだ最後の行.
+	 * @brief 範囲が引用符で始まり, 引用符で終わるかどうかを取得する.
+	 */
+	static bool isQuoted(MetaTextLexer::Range const& field)
+	{
+		return field.startsWith('"') && *(field.end - 1) == '"';
+	}
+
+	/**
+	 * @brief 歌詞の欄を読み込む. 連続する引用符は 1 つの引用符とみなし, 前後の引用符を取り除く.
+	 * @param field 歌詞の欄.
+	 * @param[out] phrase 歌詞の格納先.
 	 */
-	Master parseMaster(TextStream& stream, std::string& lastLine)
+	static void parseLyricPhrase(MetaTextLexer::Range const& field, std::string& phrase)
+	{
+		phrase.clear();
+		phrase.reserve(field.size());
+		for (char const* p = field.begin; p < field.end; ++p) {
+			// "は""として保存される
+			if (*p == '"' && p > field.begin && *(p - 1) == '"') {
+				continue;
+			}
+			phrase.push_back(*p);
+		}
+		if (!phrase.empty() && phrase.front() == '"' && phrase.back() == '"') {
+			if (phrase.size() > 2) {
+				phrase.erase(phrase.size() - 1);
+				phrase.erase(0, 1);
+			} else {
+				phrase = "a";
+			}
+		}
+	}
+
+	/**
+	 * @brief 範囲を浮動小数点数として読み込む. 数値として読み込めない部分以降は無視する.
+	 */
+	static double parseDouble(MetaTextLexer::Range const& field)
+	{
+		char buffer[64];
+		size_t const length = std::min(field.size(), sizeof(buffer) - 1);
+		std::memcpy(buffer, field.begin, length);
+		buffer[length] = '\0';
+		return std::atof(buffer);
+	}
+
+	/**
+	 * @brief メタテキストを読み込むことで Master のオブジェクトを作成する.
+	 * @param lexer 読み込むメタテキスト. 読み込みを終えた時点で, 最後に読み込んだ行を指す.
+	 */
+	Master parseMaster(MetaTextLexer& lexer)
 	{
 		Master m;
 		m.preMeasure = 0;
-		lastLine = stream.readLine();
-		while (lastLine.find("[") == std::string::npos) {
-			std::vector<std::string> spl = StringUtil::explode("=", lastLine);
-			if (spl[0] == "PreMeasure") {
-				m.preMeasure = StringUtil::parseInt<int>(spl[1]);
+		lexer.next();
+		while (!lexer.line().contains('[')) {
+			if (lexer.key() == "PreMeasure") {
+				m.preMeasure = lexer.value().toInt<int>();
 			}
-			if (!stream.ready()) {
+			if (!lexer.ready()) {
 				break;
 			}
-			lastLine = stream.readLine();
+			lexer.next();
 		}
 		return m;
 	}
 
 	/**
-	 * @brief テキストストリームから読み込みを行い, 初期化を行う.
-	 * @param stream 読み込むテキストストリーム.
-	 * @param lastLine 読み込んだ最後の行.
+	 * @brief メタテキストから読み込みを行い, Mixer を初期化する.
+	 * @param lexer 読み込むメタテキスト. 読み込みを終えた時点で, 最後に読み込んだ行を指す.
 	 */
-	static Mixer parseMixer(TextStream& stream, std::string& lastLine)
+	static Mixer parseMixer(MetaTextLexer& lexer)
 	{
 		Mixer m;
 		m.masterFeder = 0;
@@ -553,58 +1511,78 @@ public:
 		m.masterMute = 0;
 		m.outputMode = 0;
 		int tracks = 0;
-		std::string buffer = "";
-		lastLine = stream.readLine();
-		while (lastLine.at(0) != '[') {
-			std::vector<std::string> params = StringUtil::explode("=", lastLine);
-			if (params[0] == "MasterFeder") {
-				m.masterFeder = StringUtil::parseInt<int>(params[1]);
-			} else if (params[0] == "MasterPanpot") {
-				m.masterPanpot = StringUtil::parseInt<int>(params[1]);
-			} else if (params[0] == "MasterMute") {
-				m.masterMute = StringUtil::parseInt<int>(params[1]);
-			} else if (params[0] == "OutputMode") {
-				m.outputMode = StringUtil::parseInt<int>(params[1]);
-			} else if (params[0] == "Tracks") {
-				tracks = StringUtil::parseInt<int>(params[1]);
-			} else {
-				if (params[0].find("Feder") == 0 ||
-					params[0].find("Panpot") == 0 ||
-					params[0].find("Mute") == 0 ||
-					params[0].find("Solo") == 0) {
-					buffer = buffer + params[0] + "=" + params[1] + "\n";
+
+		// トラック数が確定するまで, トラック毎の値を保留しておく
+		struct SlaveValue
+		{
+			int kind;
+			MetaTextLexer::Range index;
+			MetaTextLexer::Range value;
+		};
+		std::vector<SlaveValue> slaveValues;
+
+		lexer.next();
+		while (!lexer.line().startsWith('[')) {
+			MetaTextLexer::Range const& key = lexer.key();
+			MetaTextLexer::Range const& value = lexer.value();
+			switch (key.hash()) {
+			case MetaTextLexer::hash("MasterFeder"):
+				if (key == "MasterFeder") {
+					m.masterFeder = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("MasterPanpot"):
+				if (key == "MasterPanpot") {
+					m.masterPanpot = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("MasterMute"):
+				if (key == "MasterMute") {
+					m.masterMute = value.toInt<int>();
 				}
+				break;
+			case MetaTextLexer::hash("OutputMode"):
+				if (key == "OutputMode") {
+					m.outputMode = value.toInt<int>();
+				}
+				break;
+			case MetaTextLexer::hash("Tracks"):
+				if (key == "Tracks") {
+					tracks = value.toInt<int>();
+				}
+				break;
+			default:
+				if (key.startsWith("Feder")) {
+					slaveValues.push_back(SlaveValue{0, MetaTextLexer::Range(key.begin + 5, key.end), value});
+				} else if (key.startsWith("Panpot")) {
+					slaveValues.push_back(SlaveValue{1, MetaTextLexer::Range(key.begin + 6, key.end), value});
+				} else if (key.startsWith("Mute")) {
+					slaveValues.push_back(SlaveValue{2, MetaTextLexer::Range(key.begin + 4, key.end), value});
+				} else if (key.startsWith("Solo")) {
+					slaveValues.push_back(SlaveValue{3, MetaTextLexer::Range(key.begin + 4, key.end), value});
+				}
+				break;
 			}
-			if (!stream.ready()) {
+			if (!lexer.ready()) {
 				break;
 			}
-			lastLine = stream.readLine();
+			lexer.next();
 		}
 
 		for (int i = 0; i < tracks; i++) {
 			m.slave.push_back(MixerItem(0, 0, 0, 0));
 		}
-		std::vector<std::string> spl = StringUtil::explode("\n", buffer);
-		for (std::string const& s : spl) {
-			std::string ind = "";
-			int index;
-			std::vector<std::string> spl2 = StringUtil::explode("=", s);
-			if (spl2[0].find("Feder") == 0) {
-				ind = spl2[0].substr(std::string("Feder").size());
-				index = StringUtil::parseInt<int>(ind);
-				m.slave[index].feder = StringUtil::parseInt<int>(spl2[1]);
-			} else if (spl2[0].find("Panpot") == 0) {
-				ind = spl2[0].substr(std::string("Panpot").size());
-				index = StringUtil::parseInt<int>(ind);
-				m.slave[index].panpot = StringUtil::parseInt<int>(spl2[1]);
-			} else if (spl2[0].find("Mute") == 0) {
-				ind = spl2[0].substr(std::string("Mute").size());
-				index = StringUtil::parseInt<int>(ind);
-				m.slave[index].mute = StringUtil::parseInt<int>(spl2[1]);
-			} else if (spl2[0].find("Solo") == 0) {
-				ind = spl2[0].substr(std::string("Solo").size());
-				index = StringUtil::parseInt<int>(ind);
-				m.slave[index].solo = StringUtil::parseInt<int>(spl2[1]);
+		for (SlaveValue const& item : slaveValues) {
+			int index = item.index.toInt<int>();
+			int value = item.value.toInt<int>();
+			if (item.kind == 0) {
+				m.slave[index].feder = value;
+			} else if (item.kind == 1) {
+				m.slave[index].panpot = value;
+			} else if (item.kind == 2) {
+				m.slave[index].mute = value;
+			} else {
+				m.slave[index].solo = value;
 			}
 		}
 
@@ -621,197 +1599,238 @@ public:
 	 */
 	void getMetatextByMidiEventList(std::vector<MidiEvent> const& midiEventList, std::string const& encoding, TextStream& stream, std::string& trackName)
 	{
-		int count = midiEventList.size();
-		std::vector<int> buffer;
-		for (int i = 0; i < count; i++) {
-			MidiEvent const& item = midiEventList[i];
-			if (item.firstByte == 0xff && item.data.size() > 0) {
-				// meta textを抽出
-				int type = item.data[0];
-				if (type == 0x01 || type == 0x03) {
-					if (type == 0x01) {
-						int colonCount = 0;
-						for (int j = 1; j < item.data.size(); j++) {
-							int d = item.data[j];
-							if (d == 0x3a) {
-								colonCount++;
-								if (colonCount <= 2) {
-									continue;
-								}
-							}
-							if (colonCount < 2) {
-								continue;
-							}
-							buffer.push_back(d);
-						}
-
-						auto lineFeedPosition = std::find(buffer.begin(), buffer.end(), 0x0a);
-						while (lineFeedPosition != buffer.end()) {
-							std::ostringstream copy;
-							int lineFeedIndex = lineFeedPosition - buffer.begin();
-							for (int j = 0; j < lineFeedIndex; j++) {
-								copy << (char)(0xff & buffer[0]);
-								buffer.erase(buffer.begin());
-							}
+		// トラック全体のメタテキストを CP932 のまま連結し, 最後に一括で UTF8 に変換する
+		std::string text;
+		// 改行で終わっていない, 末尾の行の開始位置. この行の断片は次のメタテキストのイベントに続く
+		size_t lineStart = 0;
+		for (MidiEvent const& item : midiEventList) {
+			if (item.firstByte != 0xff || item.data.empty()) {
+				continue;
+			}
+			// meta textを抽出
+			int type = item.data[0];
+			if (type == 0x01) {
+				// "DM:nnnn:" の接頭辞を読み飛ばす
+				size_t const size = item.data.size();
+				size_t j = 1;
+				int colonCount = 0;
+				while (j < size && colonCount < 2) {
+					if (item.data[j] == 0x3a) {
+						colonCount++;
+					}
+					j++;
+				}
+				size_t const offset = text.size();
+				text.append(reinterpret_cast<char const*>(item.data.data()) + j, size - j);
 
-							std::string line = CP932Converter::convertToUTF8(copy.str());
-							stream.writeLine(line);
-							buffer.erase(buffer.begin());
-							lineFeedPosition = std::find(buffer.begin(), buffer.end(), 0x0a);
-						}
-					} else {
-						for (int j = 1; j < item.data.size(); j++) {
-							buffer.push_back(item.data[j]);
-						}
-						int c = buffer.size();
-						std::ostringstream copy;
-						for (int j = 0; j < c; j++) {
-							copy << (char)(0xff & buffer[j]);
-						}
-						trackName = CP932Converter::convertToUTF8(copy.str());
-						buffer.clear();
+				// 新たに追加された部分だけを走査して, 末尾の行の開始位置を更新する
+				for (size_t k = text.size(); k > offset; --k) {
+					if (text[k - 1] == (char)0x0a) {
+						lineStart = k;
+						break;
 					}
 				}
-			} else {
-				continue;
+			} else if (type == 0x03) {
+				std::string name = text.substr(lineStart);
+				name.append(reinterpret_cast<char const*>(item.data.data()) + 1, item.data.size() - 1);
+				trackName = CP932Converter::convertToUTF8(name);
+				text.resize(lineStart);
 			}
 		}
 
-		int remain = buffer.size();
-		if (0 < remain) {
-			std::ostringstream copy;
-			for (int j = 0; j < remain; j++) {
-				copy << (char)(0xff & buffer[j]);
-			}
-			std::string line = CP932Converter::convertToUTF8(copy.str());
-			stream.writeLine(line);
+		if (lineStart < text.size()) {
+			text.push_back((char)0x0a);
 		}
 
+		stream.write(CP932Converter::convertLinesToUTF8(text));
 		stream.setPointer(-1);
 	}
 
 	/**
-	 * @brief メタテキストが格納されたストリームから, トラックを初期化する.
-	 * @param 読み込むストリーム.
-	 * @param[out] master 読み込まれた Master 情報.
-	 * @param[out] mixer 読み込まれた Mixer 情報.
+	 * @brief メタテキストとカーブのセクション名の対応表を取得する.
+	 * @return セクション名から Track::curve に指定する名前への対応表.
 	 */
-	Track getTrackByTextStream(TextStream& stream, Master* master = nullptr, Mixer* mixer = nullptr)
+	static std::map<std::string, std::string> const& getSectionNameMap()
 	{
-		std::map<int, tick_t> eventTickMap;
-		std::map<int, std::shared_ptr<TentativeEvent>> eventIdMap;
-		std::map<int, Handle> handleIdMap;
-		std::vector<std::shared_ptr<TentativeEvent>> temporaryEventList;
+		static std::map<std::string, std::string> const result = TentativeTrack().getSectionNameMap();
+		return result;
+	}
 
-		TentativeTrack result;
-		std::map<std::string, std::string> sectionNameMap = result.getSectionNameMap();
+	/**
+	 * @brief [EventList] セクションで時刻が分かったイベントを, handler に通知する.
+	 */
+	static void notifyEvent(VSQContentHandler& handler, int track, int id, TentativeEvent& item, tick_t tick)
+	{
+		item.tick = tick;
+		handler.event(track, id, item, item.singerHandleIndex, item.lyricHandleIndex, item.vibratoHandleIndex, item.noteHeadHandleIndex);
+	}
+
+	/**
+	 * @brief メタテキストが格納されたストリームから, トラックの内容を読み込んで handler に通知する.
+	 * @details [EventList] セクションは通常 [ID#nnnn] セクションより前にあるため, イベントは読み込んだ時点で通知する.
+	 *          時刻が未定のイベントだけを, [EventList] セクションで時刻が分かるまで保持する.
+	 * @param stream 読み込むストリーム.
+	 * @param track トラックの番号.
+	 * @param readMasterAndMixer [Master] と [Mixer] のセクションを読み込むかどうか.
+	 * @param handler 通知先.
+	 */
+	void parseTrackText(TextStream& stream, int track, bool readMasterAndMixer, VSQContentHandler& handler)
+	{
+		// [ID#nnnn] の番号ごとに, 時刻と, 時刻が未定のイベントを格納する
+		SlotTable<EventSlot> eventSlots;
 
-		std::string lastLine = stream.readLine();
+		std::map<std::string, std::string> const& sectionNameMap = getSectionNameMap();
+
+		// 読み込まないカーブのセクション名
+		std::set<std::string> skippedCurveSections;
+		if (!options.skipCurves.empty()) {
+			std::set<std::string> skipCurves;
+			for (std::string const& name : options.skipCurves) {
+				skipCurves.insert(StringUtil::toLower(name));
+			}
+			for (auto const& section : sectionNameMap) {
+				if (skipCurves.find(StringUtil::toLower(section.second)) != skipCurves.end()) {
+					skippedCurveSections.insert(section.first);
+				}
+			}
+		}
+		// 読み込まないハンドルの番号. ハンドルを参照するイベントは, ハンドルより前に記録されている
+		std::set<int> skippedHandles;
+
+		MetaTextLexer lexer(stream);
+		lexer.next();
 		while (1) {
 			// TextMemoryStreamから順次読込み
-			if (lastLine.length() == 0) {
-				break;
-			}
-
-			auto index = sectionNameMap.find(lastLine);
-			if (index != sectionNameMap.end()) {
-				std::string name = index->second;
-				lastLine = result.curve(name)->appendFromText(stream);
-			} else if (lastLine == "[Common]") {
-				result.setCommon(parseCommon(stream, lastLine));
-			} else if (lastLine == "[Master]" && master != 0) {
-				*master = parseMaster(stream, lastLine);
-			} else if (lastLine == "[Mixer]" && mixer != 0) {
-				*mixer = parseMixer(stream, lastLine);
-			} else if (lastLine == "[EventList]") {
-				lastLine = stream.readLine();
-				while (lastLine.find("[") != 0) {
-					auto parameters = StringUtil::explode("=", lastLine);
-					tick_t tick = StringUtil::parseInt<tick_t>(parameters[0]);
-					if (parameters[1] != "EOS") {
-						auto idList = StringUtil::explode(",", parameters[1]);
-						for (int i = 0; i < idList.size(); i++) {
-							auto idParameters = StringUtil::explode("#", idList[i]);
-							int id = StringUtil::parseInt<int>(idParameters[1]);
-							eventTickMap.insert(std::make_pair(id, tick));
-						}
+			MetaTextLexer::Range const& line = lexer.line();
+			if (line.empty()) {
+				break;
+			}
+
+			if (line.startsWith("[ID#")) {
+				int index = parseIndex(line);
+				int lyricHandleIndex, singerHandleIndex, vibratoHandleIndex, noteHeadHandleIndex;
+				EventType type;
+				std::unique_ptr<TentativeEvent> item(new TentativeEvent(parseEvent(lexer, type, lyricHandleIndex, singerHandleIndex, vibratoHandleIndex, noteHeadHandleIndex)));
+				item->setType(type);
+				item->lyricHandleIndex = lyricHandleIndex;
+				item->vibratoHandleIndex = vibratoHandleIndex;
+				item->noteHeadHandleIndex = noteHeadHandleIndex;
+				item->singerHandleIndex = singerHandleIndex;
+				item->setEOS(false);
+				EventSlot* slot = eventSlots.at(index);
+				if (slot && !slot->parsed) {
+					slot->parsed = true;
+					if (slot->hasTick) {
+						notifyEvent(handler, track, index, *item, slot->tick);
 					} else {
-						eventTickMap.insert(std::make_pair(-1, tick));
+						slot->event = std::move(item);
+					}
+				}
+				if (options.skipVibratoHandles && 0 <= vibratoHandleIndex) {
+					skippedHandles.insert(vibratoHandleIndex);
+				}
+				if (options.skipNoteHeadHandles && 0 <= noteHeadHandleIndex) {
+					skippedHandles.insert(noteHeadHandleIndex);
+				}
+			} else if (line.startsWith("[h#")) {
+				int index = parseIndex(line);
+				if (skippedHandles.find(index) != skippedHandles.end()) {
+					skipSection(lexer);
+				} else {
+					Handle handle = parseHandle(lexer, index);
+					bool const skip = (options.skipVibratoHandles && handle.type() == HandleType::VIBRATO)
+						|| (options.skipNoteHeadHandles && handle.type() == HandleType::NOTE_HEAD);
+					if (!skip) {
+						handler.handle(track, index, handle);
+					}
+				}
+			} else if (line == "[EventList]") {
+				lexer.next();
+				while (!lexer.line().startsWith('[')) {
+					tick_t tick = lexer.key().toInt<tick_t>();
+					MetaTextLexer::Range const& value = lexer.value();
+					if (!(value == "EOS")) {
+						// "ID#0001,ID#0002" のような, カンマ区切りのイベント指定子の列
+						char const* itemBegin = value.begin;
+						while (itemBegin <= value.end) {
+							char const* itemEnd = static_cast<char const*>(std::memchr(itemBegin, ',', value.end - itemBegin));
+							if (!itemEnd) {
+								itemEnd = value.end;
+							}
+							int id = parseIndex(MetaTextLexer::Range(itemBegin, itemEnd));
+							EventSlot* slot = eventSlots.at(id);
+							if (slot && !slot->hasTick) {
+								slot->tick = tick;
+								slot->hasTick = true;
+								if (slot->event) {
+									notifyEvent(handler, track, id, *slot->event, tick);
+									slot->event.reset();
+								}
+							}
+							itemBegin = itemEnd + 1;
+						}
 					}
-					if (! stream.ready()) {
+					if (! lexer.ready()) {
 						break;
 					} else {
-						lastLine = stream.readLine();
+						lexer.next();
 					}
 				}
+			} else if (line == "[Common]") {
+				handler.common(track, parseCommon(lexer));
+			} else if (line == "[Master]" && readMasterAndMixer) {
+				handler.master(parseMaster(lexer));
+			} else if (line == "[Mixer]" && readMasterAndMixer) {
+				handler.mixer(parseMixer(lexer));
 			} else {
-				std::string buffer = lastLine;
-				buffer = StringUtil::replace(buffer, "[", "");
-				buffer = StringUtil::replace(buffer, "]", "");
-				auto parameters = StringUtil::explode("#", buffer);
-				int index = StringUtil::parseInt<int>(parameters[1]);
-				if (lastLine.find("[ID#") == 0) {
-					int lyricHandleIndex, singerHandleIndex, vibratoHandleIndex, noteHeadHandleIndex;
-					EventType type;
-					Event e = parseEvent(stream, lastLine, type, lyricHandleIndex, singerHandleIndex, vibratoHandleIndex, noteHeadHandleIndex);
-					auto item = std::make_shared<TentativeEvent>(e);
-					item->setType(type);
-					item->lyricHandleIndex = lyricHandleIndex;
-					item->vibratoHandleIndex = vibratoHandleIndex;
-					item->noteHeadHandleIndex = noteHeadHandleIndex;
-					item->singerHandleIndex = singerHandleIndex;
-					item->setEOS(false);
-					temporaryEventList.push_back(item);
-					eventIdMap.insert(std::make_pair(index, item));
-				} else if (lastLine.find("[h#") == 0) {
-					handleIdMap.insert(std::make_pair(index, parseHandle(stream, index, lastLine)));
+				std::string const* curveName = nullptr;
+				bool skip = false;
+				for (auto const& section : sectionNameMap) {
+					if (line == section.first) {
+						curveName = &section.second;
+						skip = skippedCurveSections.find(section.first) != skippedCurveSections.end();
+						break;
+					}
+				}
+				if (skip) {
+					skipSection(lexer);
+				} else if (curveName) {
+					parseCurve(lexer, track, *curveName, handler);
+				} else if (lexer.ready()) {
+					// 未知のセクション, またはセクション外の行は読み飛ばす
+					lexer.next();
 				}
 			}
 
-			if (! stream.ready()) {
+			if (! lexer.ready()) {
 				break;
 			}
 		}
+	}
 
-		// まずhandleをidに埋め込み
-		for (auto const& i : eventIdMap) {
-			auto id = i.second;
-			if (handleIdMap.find(id->singerHandleIndex) != handleIdMap.end()) {
-				if (id->type() == EventType::SINGER) {
-					id->singerHandle = handleIdMap[id->singerHandleIndex];
-				} else if (id->type() == EventType::ICON) {
-					id->iconDynamicsHandle = handleIdMap[id->singerHandleIndex];
-				}
-			}
-			if (handleIdMap.find(id->lyricHandleIndex) != handleIdMap.end()) {
-				id->lyricHandle = handleIdMap[id->lyricHandleIndex];
-			}
-			if (handleIdMap.find(id->vibratoHandleIndex) != handleIdMap.end()) {
-				id->vibratoHandle = handleIdMap[id->vibratoHandleIndex];
+	/**
+	 * @brief カーブのセクションのデータ点を読み込み, handler に通知する. 次のセクションの先頭の行, またはメタテキストの末尾の行で読み込みを終える.
+	 */
+	static void parseCurve(MetaTextLexer& lexer, int track, std::string const& curveName, VSQContentHandler& handler)
+	{
+		while (lexer.ready()) {
+			lexer.next();
+			MetaTextLexer::Range const& line = lexer.line();
+			if (line.startsWith('[')) {
+				break;
 			}
-			if (handleIdMap.find(id->noteHeadHandleIndex) != handleIdMap.end()) {
-				id->noteHeadHandle = handleIdMap[id->noteHeadHandleIndex];
+			tick_t tick;
+			int value;
+			if (BPList::parsePoint(line.begin, line.end, tick, value)) {
+				handler.curvePoint(track, curveName, tick, value);
 			}
 		}
-
-		// idをeventListに埋め込み
-		Event::List& events = result.events();
-		events.clear();
-		int count = 0;
-		for (auto i : eventTickMap) {
-			int id = i.first;
-			tick_t tick = i.second;
-			if (eventIdMap.find(id) != eventIdMap.end()) {
-				count++;
-				Event item = *eventIdMap[id];
-				item.tick = tick;
-				events.add(item, count);
-			}
-		}
-		events.sort();
-
-		return result;
 	}
+
+public:
+	bool lazy;
+	bool parallel;
+	Options options;
 };
 
 VSQFileReader::VSQFileReader()
@@ -829,15 +1848,69 @@ void VSQFileReader::read(Sequence& sequence, InputStream& stream, std::string co
 }
 
 
+void VSQFileReader::read(InputStream& stream, VSQContentHandler& handler, std::string const& encoding)
+{
+	_impl->parse(stream, handler, encoding);
+}
+
+
+VSQFileReader::Options::Options()
+	: skipVibratoHandles(false)
+	, skipNoteHeadHandles(false)
+{}
+
+
+bool VSQFileReader::lazy() const
+{
+	return _impl->lazy;
+}
+
+
+void VSQFileReader::lazy(bool value)
+{
+	_impl->lazy = value;
+}
+
+
+bool VSQFileReader::parallel() const
+{
+	return _impl->parallel;
+}
+
+
+void VSQFileReader::parallel(bool value)
+{
+	_impl->parallel = value;
+}
+
+
+VSQFileReader::Options const& VSQFileReader::options() const
+{
+	return _impl->options;
+}
+
+
+void VSQFileReader::options(Options const& value)
+{
+	_impl->options = value;
+}
+
+
 Event VSQFileReader::parseEvent(TextStream& stream, std::string& lastLine, EventType& type, int& lyricHandleIndex, int& singerHandleIndex, int& vibratoHandleIndex, int& noteHeadHandleIndex)
 {
-	return _impl->parseEvent(stream, lastLine, type, lyricHandleIndex, singerHandleIndex, vibratoHandleIndex, noteHeadHandleIndex);
+	MetaTextLexer lexer(stream);
+	Event result = _impl->parseEvent(lexer, type, lyricHandleIndex, singerHandleIndex, vibratoHandleIndex, noteHeadHandleIndex);
+	lastLine = lexer.line().toString();
+	return result;
 }
 
 
 Handle VSQFileReader::parseHandle(TextStream& stream, int index, std::string& lastLine)
 {
-	return _impl->parseHandle(stream, index, lastLine);
+	MetaTextLexer lexer(stream);
+	Handle result = _impl->parseHandle(lexer, index);
+	lastLine = lexer.line().toString();
+	return result;
 }
 
 LIBVSQ_END_NAMESPACE
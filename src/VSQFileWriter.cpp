@@ -14,42 +14,64 @@
 #include "../include/libvsq/VSQFileWriter.hpp"
 #include "../include/libvsq/Sequence.hpp"
 #include "../include/libvsq/OutputStream.hpp"
+#include "../include/libvsq/BufferedOutputStream.hpp"
 #include "../include/libvsq/TextStream.hpp"
 #include "../include/libvsq/StringUtil.hpp"
 #include "../include/libvsq/CP932Converter.hpp"
 #include "../include/libvsq/VocaloidMidiEventListFactory.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
 #include "../include/libvsq/BitConverter.hpp"
 #include "../include/libvsq/VoiceLanguage.hpp"
+#include "../include/libvsq/ByteArrayOutputStream.hpp"
+#include "../include/libvsq/ThreadUtil.hpp"
 #include <string.h>
 #include <sstream>
+#include <algorithm>
 
 LIBVSQ_BEGIN_NAMESPACE
 
 class VSQFileWriter::Impl
 {
 private:
-	class TempEvent : public Event
+	/**
+	 * @brief "DM:nnnn:" の接頭辞の最大バイト数. int の最大値は 10 桁なので, 12 桁に 0 埋めした場合の長さとなる.
+	 */
+	static int const LINE_PREFIX_CAPACITY = 16;
+
+	/**
+	 * @brief VSQ メタテキストに出力されるイベントの ID と, イベントが参照するハンドルの番号.
+	 * @details イベントをコピーせずに出力するため, 出力時に決まる番号はイベントとは別に保持する.
+	 */
+	struct EventIndex
 	{
-	public:
-		/**
-		 * @brief VSQ メタテキストに出力されるこのオブジェクトの ID.
-		 */
 		int index;
-
 		int singerHandleIndex;
 		int lyricHandleIndex;
 		int vibratoHandleIndex;
 		int noteHeadHandleIndex;
+		int iconDynamicsHandleIndex;
 
-		explicit TempEvent(Event const& item)
-			: Event(item)
-		{
-			index = -1;
-			singerHandleIndex = -1;
-			lyricHandleIndex = -1;
-			vibratoHandleIndex = -1;
-			noteHeadHandleIndex = -1;
-		}
+		/**
+		 * @brief イベントが保持しているハンドルの番号で初期化する.
+		 */
+		explicit EventIndex(Event const& item)
+			: index(-1)
+			, singerHandleIndex(item.singerHandle.index)
+			, lyricHandleIndex(item.lyricHandle.index)
+			, vibratoHandleIndex(item.vibratoHandle.index)
+			, noteHeadHandleIndex(item.noteHeadHandle.index)
+			, iconDynamicsHandleIndex(item.iconDynamicsHandle.index)
+		{}
+	};
+
+	/**
+	 * @brief VSQ メタテキストに出力されるハンドルと, 出力時に上書きされる値.
+	 */
+	struct HandleEntry
+	{
+		Handle const* handle;
+		bool addQuotationMark;
+		tick_t length;
 	};
 
 	class TempTrack : public Track
@@ -62,16 +84,29 @@ private:
 	};
 
 public:
+	/**
+	 * @brief トラックのエンコードを並列に行うかどうか.
+	 */
+	bool parallel;
+
+	/**
+	 * @brief ランニングステータスを使って出力するかどうか.
+	 */
+	bool runningStatus;
+
 	Impl()
+		: parallel(false)
+		, runningStatus(false)
 	{}
 
 	~Impl()
 	{}
 
-	void write(Sequence const& sequence, OutputStream& stream, int msPreSend, std::string const& encoding, bool printPitch)
+	void write(Sequence const& sequence, OutputStream& output, int msPreSend, std::string const& encoding, bool printPitch)
 	{
-		Sequence targetSequence = sequence;
-		targetSequence.updateTotalTicks();
+		BufferedOutputStream stream(output);
+		// シーケンスはコピーせず, 曲の長さだけを計算し直して使う
+		tick_t const totalTicks = sequence.calculateTotalTicks();
 		int64_t first_position; //チャンクの先頭のファイル位置
 
 		// ヘッダ
@@ -87,7 +122,7 @@ public:
 		stream.write(0x00);
 		stream.write(0x01);
 		// トラック数
-		writeUnsignedShort(stream, targetSequence.tracks().size() + 1);
+		writeUnsignedShort(stream, sequence.tracks().size() + 1);
 		// 時間単位
 		stream.write(0x01);
 		stream.write(0xe0);
@@ -110,11 +145,11 @@ public:
 		stream.write(masterTrackName, 0, masterTrackNameLength);
 
 		std::vector<MidiEvent> events;
-		for (int i = 0; i < targetSequence.timesigList.size(); i++) {
-			Timesig entry = targetSequence.timesigList.get(i);
+		for (int i = 0; i < sequence.timesigList.size(); i++) {
+			Timesig const& entry = sequence.timesigList.get(i);
 			events.push_back(MidiEvent::generateTimeSigEvent(entry.tick(), entry.numerator, entry.denominator));
 		}
-		TempoList::Iterator itr = targetSequence.tempoList.iterator();
+		TempoList::Iterator itr = sequence.tempoList.iterator();
 		while (itr.hasNext()) {
 			Tempo entry = itr.next();
 			events.push_back(MidiEvent::generateTempoChangeEvent(entry.tick, entry.tempo));
@@ -138,27 +173,45 @@ public:
 		stream.seek(pos);
 
 		// トラック
-		Sequence temp = targetSequence.clone();
-		_printTrack(temp, 0, stream, msPreSend, encoding, printPitch, &targetSequence.master, &targetSequence.mixer);
-		int count = targetSequence.tracks().size();
-		for (int track = 1; track < count; track++) {
-			_printTrack(targetSequence, track, stream, msPreSend, encoding, printPitch, 0, 0);
+		int count = sequence.tracks().size();
+		if (parallel && 1 < count) {
+			_printTracksConcurrently(sequence, totalTicks, stream, msPreSend, encoding, printPitch, &sequence.master, &sequence.mixer);
+			stream.flush();
+			return;
+		}
+		for (int track = 0; track < count; track++) {
+			_printTrack(sequence, totalTicks, track, stream, msPreSend, encoding, printPitch,
+						track == 0 ? &sequence.master : 0, track == 0 ? &sequence.mixer : 0);
 		}
+		stream.flush();
 	}
 
 	void writeHandle(Handle const& item, TextStream& stream)
 	{
-		stream.writeLine(std::string("[h#") + StringUtil::toString(item.index, "%04d") + std::string("]"));
+		writeHandle(item, item.index, item.addQuotationMark, item.length(), stream);
+	}
+
+	/**
+	 * @brief ハンドルをストリームに書き込む.
+	 * @param item 書き込むハンドル.
+	 * @param index ハンドルの番号. item の index の代わりに出力される.
+	 * @param addQuotationMark 歌詞に引用符を付けるかどうか. item の addQuotationMark の代わりに使われる.
+	 * @param length ハンドルの長さ. item の length の代わりに出力される.
+	 * @param stream 書き込み先のストリーム.
+	 */
+	void writeHandle(Handle const& item, int index, bool addQuotationMark, tick_t length, TextStream& stream)
+	{
+		stream.writeLine(std::string("[h#") + StringUtil::toString(index, "%04d") + std::string("]"));
 		if (item.type() == HandleType::LYRIC) {
 			for (int i = 0; i < item.size(); i++) {
-				stream.writeLine(std::string("L") + StringUtil::toString(i) + "=" + item.get(i).toString(item.addQuotationMark));
+				stream.writeLine(std::string("L") + StringUtil::toString(i) + "=" + item.get(i).toString(addQuotationMark));
 			}
 		} else if (item.type() == HandleType::VIBRATO) {
 			stream.writeLine(std::string("IconID=") + item.iconId);
 			stream.writeLine(std::string("IDS=") + item.ids);
 			stream.writeLine(std::string("Original=") + StringUtil::toString(item.original));
 			stream.writeLine(std::string("Caption=") + item.caption);
-			stream.writeLine(std::string("Length=") + StringUtil::toString(item.length()));
+			stream.writeLine(std::string("Length=") + StringUtil::toString(length));
 			stream.writeLine(std::string("StartDepth=") + StringUtil::toString(item.startDepth));
 			stream.writeLine(std::string("DepthBPNum=") + StringUtil::toString(item.depthBP.size()));
 			if (item.depthBP.size() > 0) {
@@ -192,7 +245,7 @@ public:
 			stream.writeLine(std::string("IDS=") + item.ids);
 			stream.writeLine(std::string("Original=") + StringUtil::toString(item.original));
 			stream.writeLine(std::string("Caption=") + item.caption);
-			stream.writeLine(std::string("Length=") + StringUtil::toString(item.length()));
+			stream.writeLine(std::string("Length=") + StringUtil::toString(length));
 			stream.writeLine(std::string("Language=") + StringUtil::toString(item.language));
 			stream.writeLine(std::string("Program=") + StringUtil::toString(item.program));
 		} else if (item.type() == HandleType::NOTE_HEAD) {
@@ -200,7 +253,7 @@ public:
 			stream.writeLine(std::string("IDS=") + item.ids);
 			stream.writeLine(std::string("Original=") + StringUtil::toString(item.original));
 			stream.writeLine(std::string("Caption=") + item.caption);
-			stream.writeLine(std::string("Length=") + StringUtil::toString(item.length()));
+			stream.writeLine(std::string("Length=") + StringUtil::toString(length));
 			stream.writeLine(std::string("Duration=") + StringUtil::toString(item.duration));
 			stream.writeLine(std::string("Depth=") + StringUtil::toString(item.depth));
 		} else if (item.type() == HandleType::DYNAMICS) {
@@ -210,7 +263,7 @@ public:
 			stream.writeLine(std::string("Caption=") + item.caption);
 			stream.writeLine(std::string("StartDyn=") + StringUtil::toString(item.startDyn));
 			stream.writeLine(std::string("EndDyn=") + StringUtil::toString(item.endDyn));
-			stream.writeLine(std::string("Length=") + StringUtil::toString(item.length()));
+			stream.writeLine(std::string("Length=") + StringUtil::toString(length));
 			if (item.dynBP.size() <= 0) {
 				stream.writeLine("DynBPNum=0");
 			} else {
@@ -232,6 +285,20 @@ public:
 
 	void writeEvent(Event const* item, int event_index, TextStream& stream) const
 	{
+		EventIndex indices(*item);
+		indices.index = event_index;
+		writeEvent(item, indices, stream);
+	}
+
+	/**
+	 * @brief テキストストリームにイベントを書き出す.
+	 * @param item 書き出すイベント.
+	 * @param indices イベントの ID と, イベントが参照するハンドルの番号.
+	 * @param stream 出力先.
+	 */
+	void writeEvent(Event const* item, EventIndex const& indices, TextStream& stream) const
+	{
+		int const event_index = indices.index;
 		stream.write("[ID#");
 		stream.write(StringUtil::toString(event_index, "%04d"));
 		stream.writeLine("]");
@@ -264,30 +331,30 @@ public:
 
 			if (item->lyricHandle.type() == HandleType::LYRIC) {
 				stream.write("LyricHandle=h#");
-				stream.writeLine(StringUtil::toString(item->lyricHandle.index, "%04d"));
+				stream.writeLine(StringUtil::toString(indices.lyricHandleIndex, "%04d"));
 			}
 			if (item->vibratoHandle.type() == HandleType::VIBRATO) {
 				stream.write("VibratoHandle=h#");
-				stream.writeLine(StringUtil::toString(item->vibratoHandle.index, "%04d"));
+				stream.writeLine(StringUtil::toString(indices.vibratoHandleIndex, "%04d"));
 				stream.write("VibratoDelay=");
 				stream.writeLine(StringUtil::toString(item->vibratoDelay, "%d"));
 			}
 			if (item->noteHeadHandle.type() == HandleType::NOTE_HEAD) {
 				stream.write("NoteHeadHandle=h#");
-				stream.writeLine(StringUtil::toString(item->noteHeadHandle.index, "%04d"));
+				stream.writeLine(StringUtil::toString(indices.noteHeadHandleIndex, "%04d"));
 			}
 		} else if (item->type() == EventType::SINGER) {
 			stream.write("IconHandle=h#");
-			stream.writeLine(StringUtil::toString(item->singerHandle.index, "%04d"));
+			stream.writeLine(StringUtil::toString(indices.singerHandleIndex, "%04d"));
 		} else if (item->type() == EventType::ICON) {
 			stream.write("IconHandle=h#");
-			stream.writeLine(StringUtil::toString(item->iconDynamicsHandle.index, "%04d"));
+			stream.writeLine(StringUtil::toString(indices.iconDynamicsHandleIndex, "%04d"));
 			stream.write("Note#=");
 			stream.writeLine(StringUtil::toString(item->note, "%d"));
 		}
 	}
 
-	void printMetaText(Track const& track, TextStream& stream, int eos, tick_t start, bool printPitch, Master* master, Mixer* mixer)
+	void printMetaText(Track const& track, TextStream& stream, int eos, tick_t start, bool printPitch, Master const* master, Mixer const* mixer)
 	{
 		_printCommon(track.common(), stream);
 		if (master) {
@@ -297,27 +364,28 @@ public:
 			_printMixer(*mixer, stream);
 		}
 
-		std::vector<Handle> handle;
-		{
-			std::vector<std::unique_ptr<TempEvent>> eventList;
-			Event::ListConstIterator itr = track.events().iterator();
-			while (itr.hasNext()) {
-				Event* item = itr.next();
-				eventList.emplace_back(new TempEvent(*item));
-			}
+		// イベントとハンドルはコピーせず, 出力時に決まる番号だけを別に保持する
+		std::vector<Event const*> eventList;
+		eventList.reserve(track.events().size());
+		Event::ListConstIterator itr = track.events().iterator();
+		while (itr.hasNext()) {
+			eventList.push_back(itr.next());
+		}
+		std::vector<EventIndex> indices;
+		indices.reserve(eventList.size());
+		for (Event const* item : eventList) {
+			indices.push_back(EventIndex(*item));
+		}
 
-			handle = _writeEventList(eventList, stream, eos);
-			for (auto const& item : eventList) {
-				writeEvent(item.get(), item->index, stream);
-			}
+		std::vector<HandleEntry> handle = _writeEventList(eventList, indices, stream, eos);
+		for (int i = 0; i < eventList.size(); ++i) {
+			writeEvent(eventList[i], indices[i], stream);
 		}
 		for (int i = 0; i < handle.size(); ++i) {
-			writeHandle(handle[i], stream);
+			writeHandle(*handle[i].handle, i, handle[i].addQuotationMark, handle[i].length, stream);
 		}
 
-		TempTrack tempTrack;
-		std::map<std::string, std::string> sectionNameMap
-			= tempTrack.getSectionNameMap();
+		std::map<std::string, std::string> const& sectionNameMap = getSectionNameMap();
 
 		// prepare list of curve name to be printed
 		const std::vector<std::string>* curveNameList = track.curveNameList();
@@ -339,83 +407,46 @@ public:
 
 	std::vector<MidiEvent> getMidiEventsFromMetaText(TextStream* sr, std::string const& encoding)
 	{
-		std::string _NL = "\n";// + (char)0x0a;
 		std::vector<MidiEvent> ret;
 		sr->setPointer(-1);
-		std::string tmp = "";
-		if (sr->ready()) {
-			int line_count = -1;
-			std::vector<int> buffer;
-			bool first = true;
-			while (sr->ready()) {
-				if (first) {
-					tmp = sr->readLine();
-					first = false;
-				} else {
-					tmp = _NL + sr->readLine();
-				}
-				std::string line = CP932Converter::convertFromUTF8(tmp);
-				for (int i = 0; i < line.size(); i++) {
-					buffer.push_back(0xff & line[i]);
-				}
-				std::vector<int> prefix = getLinePrefixBytes(line_count + 1);
-				while (prefix.size() + buffer.size() >= 127) {
-					line_count++;
-					prefix = getLinePrefixBytes(line_count);
-					MidiEvent add;
-					add.tick = 0;
-					add.firstByte = 0xff;
-					add.data.push_back(0x01);
-					for (int i = 0; i < prefix.size(); i++) {
-						add.data.push_back(prefix[i]);
-					}
-					int remain = 127;
-					for (int i = 0; !buffer.empty() && prefix.size() + i < remain; i++) {
-						add.data.push_back(buffer[0]);
-						buffer.erase(buffer.begin());
-					}
-					ret.push_back(add);
-					prefix = getLinePrefixBytes(line_count + 1);
-				}
-			}
-			if (false == buffer.empty()) {
-				std::vector<int> prefix = getLinePrefixBytes(line_count + 1);
-				while (prefix.size() + buffer.size() >= 127) {
-					line_count = line_count + 1;
-					prefix = getLinePrefixBytes(line_count);
-					MidiEvent add;
-					add.tick = 0;
-					add.firstByte = 0xff;
-					add.data.push_back(0x01);
-					int remain = 127;
-					for (int i = 0; i < prefix.size(); i++) {
-						add.data.push_back(prefix[i]);
-					}
-					for (int i = 0; !buffer.empty() && prefix.size() + i < remain; i++) {
-						add.data.push_back(buffer[0]);
-						buffer.erase(buffer.begin());
-					}
-					ret.push_back(add);
-					prefix = getLinePrefixBytes(line_count + 1);
-				}
-				if (false == buffer.empty()) {
-					line_count = line_count + 1;
-					prefix = getLinePrefixBytes(line_count);
-					MidiEvent add;
-					add.tick = 0;
-					add.firstByte = 0xff;
-					int remain = prefix.size() + buffer.size();
-					add.data.push_back(0x01);
-					for (int i = 0; i < prefix.size(); i++) {
-						add.data.push_back(prefix[i]);
-					}
-					for (int i = 0; !buffer.empty() && prefix.size() + i < remain; i++) {
-						add.data.push_back(buffer[0]);
-						buffer.erase(buffer.begin());
-					}
-					ret.push_back(add);
-				}
+		if (!sr->ready()) {
+			return ret;
+		}
+
+		// 行を改行で連結し, 一括で CP932 に変換する
+		std::string text;
+		char const* begin;
+		char const* end;
+		bool first = true;
+		while (sr->ready()) {
+			sr->readLine(begin, end);
+			if (first) {
+				first = false;
+			} else {
+				text.push_back((char)0x0a);
 			}
+			text.append(begin, end);
+		}
+		std::string const bytes = CP932Converter::convertFromUTF8(text);
+
+		// 変換後のバイト列を先頭から順に, "DM:nnnn:" の接頭辞と合わせて 127 バイトずつのテキストイベントにする
+		int const maxLength = 127;
+		char prefix[LINE_PREFIX_CAPACITY];
+		ret.reserve(bytes.size() / (maxLength - 8) + 1);
+		size_t position = 0;
+		for (int count = 0; position < bytes.size(); count++) {
+			int const prefixLength = formatLinePrefix(count, prefix);
+			size_t const length = std::min(bytes.size() - position, static_cast<size_t>(maxLength - prefixLength));
+			MidiEvent add;
+			add.tick = 0;
+			add.firstByte = 0xff;
+			add.data.resize(1 + prefixLength + length);
+			uint8_t* data = add.data.data();
+			data[0] = 0x01;
+			memcpy(data + 1, prefix, prefixLength);
+			memcpy(data + 1 + prefixLength, bytes.data() + position, length);
+			ret.push_back(std::move(add));
+			position += length;
 		}
 
 		return ret;
@@ -423,28 +454,24 @@ public:
 
 	std::vector<int> getLinePrefixBytes(int count)
 	{
-		int digits = getHowManyDigits(count);
-		int c = (int)::floor((digits - 1) / 4) + 1;
-		std::ostringstream format;
-		format << "DM:%0" << (c * 4) << "d:";
-
-		std::string resultString = StringUtil::toString(count, format.str());
-
+		char prefix[LINE_PREFIX_CAPACITY];
+		int const length = formatLinePrefix(count, prefix);
 		std::vector<int> result;
-		for (int i = 0; i < resultString.size(); i++) {
-			result.push_back(0xff & resultString[i]);
+		for (int i = 0; i < length; i++) {
+			result.push_back(0xff & prefix[i]);
 		}
 		return result;
 	}
 
-	int getHowManyDigits(int number)
+	static int getHowManyDigits(int number)
 	{
-		number = ::abs(number);
-		if (number == 0) {
-			return 1;
-		} else {
-			return (int)::floor(::log10(number)) + 1;
+		// 絶対値を取ると INT_MIN で桁あふれするので, 符号を保ったまま数える
+		int digits = 1;
+		while (number <= -10 || 10 <= number) {
+			number /= 10;
+			digits++;
 		}
+		return digits;
 	}
 
 	void writeUnsignedShort(OutputStream& stream, int data)
@@ -460,7 +487,33 @@ public:
 	}
 
 private:
-	void _printTrack(Sequence const& sequence, int track, OutputStream& stream, int msPreSend, std::string const& encoding, bool printPitch, Master* master, Mixer* mixer)
+	/**
+	 * @brief 全トラックの MTrk チャンクをワーカースレッドで並列にエンコードし, トラック順にストリームへ出力する.
+	 * @param sequence 出力するシーケンス.
+	 * @param totalTicks Tick 単位の曲の長さ.
+	 * @param stream 出力先のストリーム.
+	 * @param msPreSend ミリ秒単位のプリセンドタイム.
+	 * @param encoding マルチバイト文字のテキストエンコーディング.
+	 * @param printPitch pitch を含めて出力するかどうか.
+	 * @param master 先頭トラックに出力する Master 情報.
+	 * @param mixer 先頭トラックに出力する Mixer 情報.
+	 */
+	void _printTracksConcurrently(Sequence const& sequence, tick_t totalTicks, OutputStream& stream, int msPreSend, std::string const& encoding, bool printPitch, Master const* master, Mixer const* mixer)
+	{
+		int const count = sequence.tracks().size();
+		std::vector<ByteArrayOutputStream> chunks(count);
+		ThreadUtil::runConcurrently(count, [&](int track) {
+			_printTrack(sequence, totalTicks, track, chunks[track], msPreSend, encoding, printPitch,
+						track == 0 ? master : 0, track == 0 ? mixer : 0);
+		});
+
+		for (int track = 0; track < count; ++track) {
+			std::vector<char> chunk = chunks[track].release();
+			stream.write(chunk.data(), 0, chunk.size());
+		}
+	}
+
+	void _printTrack(Sequence const& sequence, tick_t totalTicks, int track, OutputStream& stream, int msPreSend, std::string const& encoding, bool printPitch, Master const* master, Mixer const* mixer)
 	{
 		// ヘッダ
 		std::string mtrk = _getTrackHeader();
@@ -480,7 +533,7 @@ private:
 
 		// Meta Textを準備
 		TextStream textStream;
-		printMetaText(sequence.track(track), textStream, sequence.totalTicks() + 120,
+		printMetaText(sequence.track(track), textStream, totalTicks + 120,
 					  0, printPitch, master, mixer);
 		tick_t lastTick = 0;
 		std::vector<MidiEvent> meta = getMidiEventsFromMetaText(&textStream, encoding);
@@ -492,17 +545,12 @@ private:
 		tick_t maxTick = lastTick;
 
 		lastTick = 0;
-		std::vector<MidiEvent> nrpns =
-			VocaloidMidiEventListFactory::generateMidiEventList(
-				sequence.track(track), sequence.tempoList,
-				sequence.totalTicks(), sequence.preMeasureTicks(), msPreSend
-			);
-		for (int i = 0; i < nrpns.size(); i++) {
-			MidiEvent item = nrpns[i];
-			MidiEvent::writeDeltaTick(stream, item.tick - lastTick);
-			item.writeData(stream);
-			lastTick = item.tick;
-		}
+		NrpnEventBuffer nrpns;
+		VocaloidMidiEventListFactory::generateNRPN(
+			nrpns, sequence.track(track), sequence.tempoList,
+			totalTicks, sequence.preMeasureTicks(), msPreSend
+		);
+		nrpns.write(stream, lastTick, runningStatus);
 		maxTick = std::max(maxTick, lastTick);
 
 		// トラックエンド
@@ -525,29 +573,37 @@ private:
 
 	/**
 	 * @brief イベントリストをテキストストリームに出力する.
+	 * @param eventList 出力するイベントのリスト.
+	 * @param[in,out] indices eventList の各イベントの ID と, イベントが参照するハンドルの番号. ID とハンドルの番号が設定される.
 	 * @param stream 出力先のストリーム.
 	 * @param eos EOS として出力する Tick 単位の時刻.
 	 * @return リスト中のイベントに含まれるハンドルの一覧.
 	 */
-	std::vector<Handle> _writeEventList(std::vector<std::unique_ptr<TempEvent>>& eventList, TextStream& stream, tick_t eos)
+	std::vector<HandleEntry> _writeEventList(std::vector<Event const*> const& eventList, std::vector<EventIndex>& indices, TextStream& stream, tick_t eos)
 	{
-		std::vector<Handle> handles = _getHandleList(eventList);
+		std::vector<HandleEntry> handles = _getHandleList(eventList, indices);
 		stream.writeLine("[EventList]");
-		std::vector<TempEvent> temp;
-		for (auto const& item : eventList) {
-			temp.push_back(*item);
+		std::vector<int> order(eventList.size());
+		for (int i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		auto less = [&eventList](int a, int b) {
+			return Event::compare(*eventList[a], *eventList[b]);
+		};
+		// イベントは通常時刻順に並んでいるので, 並べ替えが必要な場合だけ行う
+		if (!std::is_sorted(order.begin(), order.end(), less)) {
+			std::stable_sort(order.begin(), order.end(), less);
 		}
-		std::stable_sort(temp.begin(), temp.end(), Event::compare);
 		int i = 0;
-		while (i < temp.size()) {
-			TempEvent item = temp[i];
-			if (! item.isEOS()) {
+		while (i < order.size()) {
+			Event const* item = eventList[order[i]];
+			if (! item->isEOS()) {
 				std::ostringstream ids;
-				ids << "ID#" << StringUtil::toString(item.index, "%04d");
-				tick_t tick = temp[i].tick;
-				while (i + 1 < temp.size() && tick == temp[i + 1].tick) {
+				ids << "ID#" << StringUtil::toString(indices[order[i]].index, "%04d");
+				tick_t tick = item->tick;
+				while (i + 1 < order.size() && tick == eventList[order[i + 1]]->tick) {
 					i++;
-					ids << ",ID#" << StringUtil::toString(temp[i].index, "%04d");
+					ids << ",ID#" << StringUtil::toString(indices[order[i]].index, "%04d");
 				}
 				std::ostringstream oss;
 				oss << tick << "=" << ids.str();
@@ -577,62 +633,63 @@ private:
 
 	/**
 	 * @brief リスト内のイベントから, ハンドルの一覧を作成する. 同時に, 各イベント, ハンドルの番号を設定する.
-	 * @return ハンドルの一覧.
+	 * @param eventList イベントのリスト.
+	 * @param[in,out] indices eventList の各イベントの ID と, イベントが参照するハンドルの番号.
+	 * @return ハンドルの一覧. ハンドルの番号は, 一覧の中での位置と同じになる.
 	 */
-	std::vector<Handle> _getHandleList(std::vector<std::unique_ptr<TempEvent>>& eventList)
+	std::vector<HandleEntry> _getHandleList(std::vector<Event const*> const& eventList, std::vector<EventIndex>& indices)
 	{
-		std::vector<Handle> handle;
+		std::vector<HandleEntry> handle;
 		int current_id = -1;
 		int current_handle = -1;
 		bool add_quotation_mark = true;
-		for (auto const& item : eventList) {
+		auto add = [&handle, &current_handle](Handle const& item, bool addQuotationMark, tick_t length) {
+			current_handle = current_handle + 1;
+			handle.push_back(HandleEntry{ &item, addQuotationMark, length });
+			return current_handle;
+		};
+		for (int i = 0; i < eventList.size(); ++i) {
+			Event const* item = eventList[i];
+			EventIndex& index = indices[i];
 			current_id = current_id + 1;
-			item->index = current_id;
+			index.index = current_id;
 			// SingerHandle
 			if (item->singerHandle.type() == HandleType::SINGER) {
-				current_handle = current_handle + 1;
-				item->singerHandle.index = current_handle;
-				handle.push_back(item->singerHandle);
-				item->singerHandleIndex = current_handle;
+				index.singerHandleIndex = add(item->singerHandle, item->singerHandle.addQuotationMark, item->singerHandle.length());
 				VoiceLanguage lang = VoiceLanguageUtil::valueFromSingerName(item->singerHandle.ids);
 				add_quotation_mark = lang == VoiceLanguage::JAPANESE;
 			}
 			// LyricHandle
 			if (item->lyricHandle.type() == HandleType::LYRIC) {
-				current_handle = current_handle + 1;
-				item->lyricHandle.index = current_handle;
-				item->lyricHandle.addQuotationMark = add_quotation_mark;
-				handle.push_back(item->lyricHandle);
-				item->lyricHandleIndex = current_handle;
+				index.lyricHandleIndex = add(item->lyricHandle, add_quotation_mark, item->lyricHandle.length());
 			}
 			// VibratoHandle
 			if (item->vibratoHandle.type() == HandleType::VIBRATO) {
-				current_handle = current_handle + 1;
-				item->vibratoHandle.index = current_handle;
-				handle.push_back(item->vibratoHandle);
-				item->vibratoHandleIndex = current_handle;
+				index.vibratoHandleIndex = add(item->vibratoHandle, item->vibratoHandle.addQuotationMark, item->vibratoHandle.length());
 			}
 			// NoteHeadHandle
 			if (item->noteHeadHandle.type() == HandleType::NOTE_HEAD) {
-				current_handle = current_handle + 1;
-				item->noteHeadHandle.index = current_handle;
-				handle.push_back(item->noteHeadHandle);
-				item->noteHeadHandleIndex = current_handle;
+				index.noteHeadHandleIndex = add(item->noteHeadHandle, item->noteHeadHandle.addQuotationMark, item->noteHeadHandle.length());
 			}
 			// IconDynamicsHandle
 			if (item->iconDynamicsHandle.type() == HandleType::DYNAMICS) {
-				current_handle = current_handle + 1;
-				item->iconDynamicsHandle.index = current_handle;
-				item->iconDynamicsHandle.length(item->length());
-				handle.push_back(item->iconDynamicsHandle);
-				// IconDynamicsHandleは, 歌手ハンドルと同じ扱いなので
-				// _singerHandleIndexでよい
-				item->singerHandleIndex = current_handle;
+				// IconDynamicsHandleの長さは, イベントの長さとして出力する
+				index.iconDynamicsHandleIndex = add(item->iconDynamicsHandle, item->iconDynamicsHandle.addQuotationMark, item->length());
 			}
 		}
 		return handle;
 	}
 
+	/**
+	 * @brief カーブのセクション名の対応表を取得する.
+	 * @return セクション名から Track::curve に指定する名前への対応表.
+	 */
+	static std::map<std::string, std::string> const& getSectionNameMap()
+	{
+		static std::map<std::string, std::string> const result = TempTrack().getSectionNameMap();
+		return result;
+	}
+
 	/**
 	 * @brief Master のオブジェクトをテキストストリームに出力する.
 	 * @param m 出力するオブジェクト.
@@ -668,6 +725,29 @@ private:
 		}
 	}
 
+	/**
+	 * @brief "DM:0001:" のような, メタテキストの行の先頭につくヘッダー文字列を書き込む.
+	 * @details 番号は 4 桁単位で 0 埋めする. sprintf などを使わず, 整数演算だけで書式化する.
+	 * @param count ヘッダーの番号. 0 以上の値.
+	 * @param[out] dest 書き込み先. LINE_PREFIX_CAPACITY バイト以上の領域.
+	 * @return 書き込んだバイト数.
+	 */
+	static int formatLinePrefix(int count, char* dest)
+	{
+		int const digits = getHowManyDigits(count);
+		int const width = ((digits - 1) / 4 + 1) * 4;
+		dest[0] = 'D';
+		dest[1] = 'M';
+		dest[2] = ':';
+		int value = count;
+		for (int i = width; i > 0; i--) {
+			dest[2 + i] = static_cast<char>('0' + value % 10);
+			value /= 10;
+		}
+		dest[3 + width] = ':';
+		return 4 + width;
+	}
+
 	/**
 	 * @brief SMF のトラックヘッダー文字列を取得する.
 	 */
@@ -693,6 +773,30 @@ void VSQFileWriter::write(Sequence const& sequence, OutputStream& stream, int ms
 }
 
 
+bool VSQFileWriter::parallel() const
+{
+	return _impl->parallel;
+}
+
+
+void VSQFileWriter::parallel(bool value)
+{
+	_impl->parallel = value;
+}
+
+
+bool VSQFileWriter::runningStatus() const
+{
+	return _impl->runningStatus;
+}
+
+
+void VSQFileWriter::runningStatus(bool value)
+{
+	_impl->runningStatus = value;
+}
+
+
 void VSQFileWriter::_writeHandle(Handle const& item, TextStream& stream)
 {
 	_impl->writeHandle(item, stream);
@@ -705,7 +809,7 @@ void VSQFileWriter::_writeEvent(Event const* item, int event_index, TextStream&
 }
 
 
-void VSQFileWriter::_printMetaText(Track const& track, TextStream& stream, int eos, tick_t start, bool printPitch, Master* master, Mixer* mixer)
+void VSQFileWriter::_printMetaText(Track const& track, TextStream& stream, int eos, tick_t start, bool printPitch, Master const* master, Mixer const* mixer)
 {
 	_impl->printMetaText(track, stream, eos, start, printPitch, master, mixer);
 }
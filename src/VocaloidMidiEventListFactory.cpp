@@ -12,6 +12,7 @@
  * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
  */
 #include "../include/libvsq/VocaloidMidiEventListFactory.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
 #include "../include/libvsq/Track.hpp"
 #include "../include/libvsq/TempoList.hpp"
 #include "../include/libvsq/StringUtil.hpp"
@@ -24,78 +25,61 @@ LIBVSQ_BEGIN_NAMESPACE
 std::vector<MidiEvent> VocaloidMidiEventListFactory::generateMidiEventList(
 	Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTick, int msPreSend)
 {
-	std::vector<NrpnEvent> nrpnEventList = generateNRPN(target, tempoList, totalTicks, preMeasureTick, msPreSend);
-	return NrpnEvent::convert(nrpnEventList);
+	NrpnEventBuffer buffer;
+	generateNRPN(buffer, target, tempoList, totalTicks, preMeasureTick, msPreSend);
+	return NrpnEvent::convert(buffer);
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateNRPN(
 	Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTick, int msPreSend)
 {
-	std::vector<NrpnEvent> list;
+	NrpnEventBuffer buffer;
+	generateNRPN(buffer, target, tempoList, totalTicks, preMeasureTick, msPreSend);
+	return buffer.expand();
+}
+
+void VocaloidMidiEventListFactory::generateNRPN(
+	NrpnEventBuffer& dest,
+	Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTick, int msPreSend)
+{
+	NrpnEventBuffer& list = dest;
+	list.clear();
 
 	std::string version = target.common().version;
 	Event::List const& events = target.events();
 
 	int count = events.size();
-	int note_start = 0;
-	int note_end = count - 1;
-	for (int i = 0; i < count; i++) {
-		if (0 <= events.get(i)->tick) {
-			note_start = i;
-			break;
-		}
-		note_start = i;
-	}
-	for (int i = count - 1; i >= 0; i--) {
-		if (events.get(i)->tick <= totalTicks) {
-			note_end = i;
-			break;
-		}
-	}
+	int note_start, note_end;
+	getEventRange(target, totalTicks, &note_start, &note_end);
+
+	// 音符 1 つあたり 30 レコード程度, カーブのデータ点 1 つあたり 2 レコード程度
+	list.reserve(count * 30 + (target.curve("dyn")->size() + target.curve("pbs")->size() + target.curve("pit")->size()) * 2);
 
 	// determine first singer
-	int singer_event = -1;
-	for (int i = note_start; i >= 0; i--) {
-		if (events.get(i)->type() == EventType::SINGER) {
-			singer_event = i;
-			break;
-		}
-	}
+	int singer_event = findFirstSingerEvent(target, note_start);
 	if (singer_event >= 0) {
 		// first singer was found
-		std::vector<NrpnEvent> singerNrpnList = generateSingerNRPN(tempoList, *events.get(singer_event), 0);
-		list.insert(list.end(), singerNrpnList.begin(), singerNrpnList.end());
+		generateSingerNRPN(list, tempoList, *events.get(singer_event), 0);
 	} else {
 		// first singer was not found. may be rate-case
-		list.push_back(NrpnEvent(0, MidiParameterType::CC_BS_LANGUAGE_TYPE, 0x0));
-		list.push_back(NrpnEvent(0, MidiParameterType::PC_VOICE_TYPE, 0x0));
+		list.add(0, MidiParameterType::CC_BS_LANGUAGE_TYPE, 0x0);
+		list.add(0, MidiParameterType::PC_VOICE_TYPE, 0x0);
 	}
 
-	std::vector<NrpnEvent> voiceChangeParameterNrpn = generateVoiceChangeParameterNRPN(target, tempoList, msPreSend, preMeasureTick);
-	list.insert(list.end(), voiceChangeParameterNrpn.begin(), voiceChangeParameterNrpn.end());
+	generateVoiceChangeParameterNRPN(list, target, tempoList, msPreSend, preMeasureTick);
 	if (version.substr(0, 4) == "DSB2") {
-		std::vector<NrpnEvent> fx2DepthNrpn = generateFx2DepthNRPN(target, tempoList, msPreSend);
-		list.insert(list.end(), fx2DepthNrpn.begin(), fx2DepthNrpn.end());
+		generateFx2DepthNRPN(list, target, tempoList, msPreSend);
 	}
 
 	int ms_presend = msPreSend;
 	if (target.curve("dyn")->size() > 0) {
-		std::vector<NrpnEvent> listdyn = generateExpressionNRPN(target, tempoList, ms_presend);
-		if (! listdyn.empty()) {
-			list.insert(list.end(), listdyn.begin(), listdyn.end());
-		}
+		generateExpressionNRPN(list, target, tempoList, ms_presend);
 	}
 	if (target.curve("pbs")->size() > 0) {
-		std::vector<NrpnEvent> listpbs = generatePitchBendSensitivityNRPN(target, tempoList, ms_presend);
-		if (! listpbs.empty()) {
-			list.insert(list.end(), listpbs.begin(), listpbs.end());
-		}
+		generatePitchBendSensitivityNRPN(list, target, tempoList, ms_presend);
 	}
 	if (target.curve("pit")->size() > 0) {
-		std::vector<NrpnEvent> listpit = generatePitchBendNRPN(target, tempoList, ms_presend);
-		if (! listpit.empty()) {
-			list.insert(list.end(), listpit.begin(), listpit.end());
-		}
+		generatePitchBendNRPN(list, target, tempoList, ms_presend);
 	}
 
 	int lastDelay = 0;
@@ -103,58 +87,153 @@ std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateNRPN(
 	for (int i = note_start; i <= note_end; i++) {
 		Event const* item = events.get(i);
 		if (item->type() == EventType::NOTE) {
-			int note_loc = 0x03;
-			if (item->tick == last_note_end) {
-				note_loc = note_loc - 0x02;
-			}
-
-			// find next note event
-			tick_t nexttick = item->tick + item->length() + 1;
-			int event_count = events.size();
-			for (int j = i + 1; j < event_count; j++) {
-				Event const* itemj = events.get(j);
-				if (itemj->type() == EventType::NOTE) {
-					nexttick = itemj->tick;
-					break;
-				}
-			}
-			if (item->tick + item->length() == nexttick) {
-				note_loc = note_loc - 0x01;
-			}
+			int note_loc = getNoteLocation(target, i, last_note_end);
 
 			int delay;
-			NrpnEvent noteNrpn =
-				generateNoteNRPN(target, tempoList, *item, msPreSend, note_loc, &lastDelay, &delay);
+			generateNoteNRPN(list, target, tempoList, *item, msPreSend, note_loc, &lastDelay, &delay);
 			lastDelay = delay;
 
-			list.push_back(noteNrpn);
-			std::vector<NrpnEvent> vibratoNrpn = generateVibratoNRPN(tempoList, *item, msPreSend);
-			list.insert(list.end(), vibratoNrpn.begin(), vibratoNrpn.end());
+			generateVibratoNRPN(list, tempoList, *item, msPreSend);
 			last_note_end = item->tick + item->length();
 		} else if (item->type() == EventType::SINGER) {
 			if (i > note_start && i != singer_event) {
-				std::vector<NrpnEvent> singerNrpn = generateSingerNRPN(tempoList, *item, msPreSend);
-				list.insert(list.end(), singerNrpn.begin(), singerNrpn.end());
+				generateSingerNRPN(list, tempoList, *item, msPreSend);
 			}
 		}
 	}
 
-	std::stable_sort(list.begin(), list.end(), NrpnEvent::compare);
-	std::vector<NrpnEvent> merged;
-	for (int i = 0; i < list.size(); i++) {
-		std::vector<NrpnEvent> expanded = list[i].expand();
-		merged.insert(merged.end(), expanded.begin(), expanded.end());
+	// 各グループ内のソートはここでの安定ソートに包含されるので, まとめて 1 回だけ行う
+	list.sort();
+}
+
+std::vector<MidiEvent> VocaloidMidiEventListFactory::generateMidiEventList(
+	Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTick, int msPreSend, tick_t startTick, tick_t endTick)
+{
+	NrpnEventBuffer buffer;
+	generateNRPN(buffer, target, tempoList, totalTicks, preMeasureTick, msPreSend, startTick, endTick);
+	return NrpnEvent::convert(buffer);
+}
+
+void VocaloidMidiEventListFactory::generateNRPN(
+	NrpnEventBuffer& dest,
+	Track const& target, TempoList const& tempoList, tick_t totalTicks, tick_t preMeasureTick, int msPreSend,
+	tick_t startTick, tick_t endTick)
+{
+	NrpnEventBuffer& list = dest;
+	list.clear();
+
+	std::string version = target.common().version;
+	Event::List const& events = target.events();
+
+	int note_start, note_end;
+	getEventRange(target, totalTicks, &note_start, &note_end);
+	int first = std::max(note_start, events.lowerBound(startTick));
+	int last = std::min(note_end + 1, events.lowerBound(endTick));
+
+	// 開始時刻の時点で有効な歌手を, 開始時刻に出力する
+	int singer_event = -1;
+	for (int i = events.lowerBound(startTick + 1) - 1; i >= 0; i--) {
+		if (events.get(i)->type() == EventType::SINGER) {
+			singer_event = i;
+			break;
+		}
+	}
+	if (singer_event >= 0) {
+		Event singer = *events.get(singer_event);
+		singer.tick = std::max(singer.tick, startTick);
+		generateSingerNRPN(list, tempoList, singer, 0);
+	} else {
+		tick_t tick = std::max((tick_t)0, startTick);
+		list.add(tick, MidiParameterType::CC_BS_LANGUAGE_TYPE, 0x0);
+		list.add(tick, MidiParameterType::PC_VOICE_TYPE, 0x0);
+	}
+
+	std::vector<std::string> curves = getVoiceChangeParameterCurveNames(version);
+	int lastDelay = 0;
+	for (int i = 0; i < curves.size(); i++) {
+		BPList const* curve = target.curve(curves[i]);
+		int id = MidiParameterTypeUtil::getVoiceChangeParameterId(curve->name());
+		int begin = curve->lowerBound(startTick);
+		int end = curve->lowerBound(endTick);
+		if (0 < begin && (begin == curve->size() || curve->keyTickAt(begin) != startTick)) {
+			lastDelay = addVoiceChangeParameter(list, id, startTick, curve->get(begin - 1).value, tempoList, msPreSend, lastDelay);
+		}
+		lastDelay = addVoiceChangeParameters(list, *curve, tempoList, msPreSend, lastDelay, begin, end);
+	}
+	if (version.substr(0, 4) == "DSB2") {
+		NrpnEventProvider provider(MidiParameterType::CC_FX2_DELAY, MidiParameterType::CC_FX2_EFFECT2_DEPTH);
+		generateNRPNByBPList(list, tempoList, msPreSend, *target.curve("fx2depth"), provider, startTick, endTick);
+	}
+	{
+		NrpnEventProvider provider(MidiParameterType::CC_E_DELAY, MidiParameterType::CC_E_EXPRESSION);
+		generateNRPNByBPList(list, tempoList, msPreSend, *target.curve("dyn"), provider, startTick, endTick);
 	}
-	return merged;
+	{
+		PitchBendSensitivityNrpnEventProvider provider;
+		generateNRPNByBPList(list, tempoList, msPreSend, *target.curve("pbs"), provider, startTick, endTick);
+	}
+	{
+		PitchBendNrpnEventProvider provider;
+		generateNRPNByBPList(list, tempoList, msPreSend, *target.curve("pit"), provider, startTick, endTick);
+	}
+
+	// 音符の接続関係は範囲外の音符も含めて判定し, delay は範囲の先頭で出力し直す
+	lastDelay = 0;
+	tick_t last_note_end = 0;
+	for (int i = first - 1; i >= note_start; i--) {
+		Event const* item = events.get(i);
+		if (item->type() == EventType::NOTE) {
+			last_note_end = item->tick + item->length();
+			break;
+		}
+	}
+	for (int i = first; i < last; i++) {
+		Event const* item = events.get(i);
+		if (item->type() == EventType::NOTE) {
+			int note_loc = getNoteLocation(target, i, last_note_end);
+			int delay;
+			generateNoteNRPN(list, target, tempoList, *item, msPreSend, note_loc, &lastDelay, &delay);
+			lastDelay = delay;
+			generateVibratoNRPN(list, tempoList, *item, msPreSend);
+			last_note_end = item->tick + item->length();
+		} else if (item->type() == EventType::SINGER) {
+			if (i > singer_event) {
+				generateSingerNRPN(list, tempoList, *item, msPreSend);
+			}
+		}
+	}
+
+	list.sort();
+}
+
+void VocaloidMidiEventListFactory::generateNRPNByBPList(
+	NrpnEventBuffer& result,
+	TempoList const& tempoList, int preSendMilliseconds,
+	BPList const& list, NrpnEventProvider const& provider,
+	tick_t startTick, tick_t endTick
+)
+{
+	int begin = list.lowerBound(startTick);
+	int end = list.lowerBound(endTick);
+	int lastDelay = 0;
+	if (0 < begin && (begin == list.size() || list.keyTickAt(begin) != startTick)) {
+		lastDelay = generateNRPNByBP(result, tempoList, preSendMilliseconds, startTick, list.get(begin - 1).value, provider, lastDelay);
+	}
+	generateNRPNByBPList(result, tempoList, preSendMilliseconds, list, provider, begin, end, lastDelay);
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateExpressionNRPN(Track const& track, TempoList const& tempoList, int preSendMilliseconds)
 {
-	std::vector<NrpnEvent> ret;
+	NrpnEventBuffer buffer;
+	generateExpressionNRPN(buffer, track, tempoList, preSendMilliseconds);
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generateExpressionNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int preSendMilliseconds)
+{
 	BPList const* dyn = track.curve("DYN");
-	std::unique_ptr<NrpnEventProvider> provider(new NrpnEventProvider(MidiParameterType::CC_E_DELAY, MidiParameterType::CC_E_EXPRESSION));
-	generateNRPNByBPList(ret, tempoList, preSendMilliseconds, *dyn, *provider);
-	return ret;
+	NrpnEventProvider provider(MidiParameterType::CC_E_DELAY, MidiParameterType::CC_E_EXPRESSION);
+	generateNRPNByBPList(dest, tempoList, preSendMilliseconds, *dyn, provider, 0, dyn->size(), 0);
 }
 
 NrpnEvent VocaloidMidiEventListFactory::generateHeaderNRPN()
@@ -166,6 +245,13 @@ NrpnEvent VocaloidMidiEventListFactory::generateHeaderNRPN()
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateSingerNRPN(TempoList const& tempoList, Event const& singerEvent, int preSendMilliseconds)
+{
+	NrpnEventBuffer buffer;
+	generateSingerNRPN(buffer, tempoList, singerEvent, preSendMilliseconds);
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generateSingerNRPN(NrpnEventBuffer& dest, TempoList const& tempoList, Event const& singerEvent, int preSendMilliseconds)
 {
 	tick_t tick = singerEvent.tick;
 	Handle singer_handle;
@@ -184,20 +270,22 @@ std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateSingerNRPN(TempoLis
 	int delayMsb, delayLsb;
 	_getMsbAndLsb(delay, &delayMsb, &delayLsb);
 
-	NrpnEvent add(actualTick, MidiParameterType::CC_BS_VERSION_AND_DEVICE, 0x00, 0x00);
-	add.append(MidiParameterType::CC_BS_DELAY, delayMsb, delayLsb, true);
-	add.append(MidiParameterType::CC_BS_LANGUAGE_TYPE, singer_handle.language, true);
-	add.append(MidiParameterType::PC_VOICE_TYPE, singer_handle.program);
-
-	std::vector<NrpnEvent> ret;
-	ret.push_back(add);
-	return ret;
+	dest.add(actualTick, MidiParameterType::CC_BS_VERSION_AND_DEVICE, 0x00, 0x00);
+	dest.append(MidiParameterType::CC_BS_DELAY, delayMsb, delayLsb, true);
+	dest.append(MidiParameterType::CC_BS_LANGUAGE_TYPE, singer_handle.language, true);
+	dest.append(MidiParameterType::PC_VOICE_TYPE, singer_handle.program);
 }
 
 NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, TempoList const& tempoList, Event const& noteEvent, int msPreSend, int noteLocation, int* lastDelay, int* delay)
+{
+	NrpnEventBuffer buffer;
+	generateNoteNRPN(buffer, track, tempoList, noteEvent, msPreSend, noteLocation, lastDelay, delay);
+	return buffer.toList()[0];
+}
+
+void VocaloidMidiEventListFactory::generateNoteNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, Event const& noteEvent, int msPreSend, int noteLocation, int* lastDelay, int* delay)
 {
 	tick_t tick = noteEvent.tick;
-	NrpnEvent add(0, MidiParameterType::CC_BS_DELAY, 0, 0);
 
 	tick_t actualTick;
 	_getActualTickAndDelay(tempoList, tick, msPreSend, &actualTick, delay);
@@ -206,11 +294,7 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 	bool addInitialized = false;
 	int lastDelayValue;
 	if (0 == lastDelay) {
-		add = NrpnEvent(
-				  actualTick,
-				  MidiParameterType::CVM_NM_VERSION_AND_DEVICE,
-				  0x00, 0x00
-			  );
+		dest.add(actualTick, MidiParameterType::CVM_NM_VERSION_AND_DEVICE, 0x00, 0x00);
 		lastDelayValue = 0;
 		addInitialized = true;
 	} else {
@@ -222,21 +306,21 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 		_getMsbAndLsb(*delay, &delayMsb, &delayLsb);
 		if (false == addInitialized) {
 			//TODO: In this case, CVM_NM_VERSION_AND_DEVICE is omitted. Farther verification is required.
-			add = NrpnEvent(actualTick, MidiParameterType::CVM_NM_DELAY, delayMsb, delayLsb);
+			dest.add(actualTick, MidiParameterType::CVM_NM_DELAY, delayMsb, delayLsb);
 			addInitialized = true;
 		} else {
-			add.append(MidiParameterType::CVM_NM_DELAY, delayMsb, delayLsb, true);
+			dest.append(MidiParameterType::CVM_NM_DELAY, delayMsb, delayLsb, true);
 		}
 	}
 
 	if (false == addInitialized) {
-		add = NrpnEvent(actualTick, MidiParameterType::CVM_NM_NOTE_NUMBER, noteEvent.note);
+		dest.add(actualTick, MidiParameterType::CVM_NM_NOTE_NUMBER, noteEvent.note);
 	} else {
-		add.append(MidiParameterType::CVM_NM_NOTE_NUMBER, noteEvent.note, true);
+		dest.append(MidiParameterType::CVM_NM_NOTE_NUMBER, noteEvent.note, true);
 	}
 
 	// Velocity
-	add.append(MidiParameterType::CVM_NM_VELOCITY, noteEvent.dynamics, true);
+	dest.append(MidiParameterType::CVM_NM_VELOCITY, noteEvent.dynamics, true);
 
 	// Note Duration
 	double msEnd = tempoList.timeFromTick(tick + noteEvent.length()) * 1000.0;
@@ -244,13 +328,13 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 	int duration = (int)::floor(msEnd - tick_msec);
 	int duration0, duration1;
 	_getMsbAndLsb(duration, &duration0, &duration1);
-	add.append(MidiParameterType::CVM_NM_NOTE_DURATION, duration0, duration1, true);
+	dest.append(MidiParameterType::CVM_NM_NOTE_DURATION, duration0, duration1, true);
 
 	// Note Location
-	add.append(MidiParameterType::CVM_NM_NOTE_LOCATION, noteLocation, true);
+	dest.append(MidiParameterType::CVM_NM_NOTE_LOCATION, noteLocation, true);
 
 	if (noteEvent.vibratoHandle.type() != HandleType::UNKNOWN) {
-		add.append(MidiParameterType::CVM_NM_INDEX_OF_VIBRATO_DB, 0x00, 0x00, true);
+		dest.append(MidiParameterType::CVM_NM_INDEX_OF_VIBRATO_DB, 0x00, 0x00, true);
 		std::string icon_id = noteEvent.vibratoHandle.iconId;
 		std::string num = icon_id.substr(icon_id.length() - 3);
 		int vibrato_type = StringUtil::parseInt<int>(num, 16);
@@ -258,8 +342,8 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 		int vibrato_delay = noteEvent.vibratoDelay;
 		int bVibratoDuration = (int)::floor((note_length - vibrato_delay) / (double)note_length * 127.0);
 		int bVibratoDelay = 0x7f - bVibratoDuration;
-		add.append(MidiParameterType::CVM_NM_VIBRATO_CONFIG, vibrato_type, bVibratoDuration, true);
-		add.append(MidiParameterType::CVM_NM_VIBRATO_DELAY, bVibratoDelay, true);
+		dest.append(MidiParameterType::CVM_NM_VIBRATO_CONFIG, vibrato_type, bVibratoDuration, true);
+		dest.append(MidiParameterType::CVM_NM_VIBRATO_DELAY, bVibratoDelay, true);
 	}
 
 	std::vector<std::string> spl = noteEvent.lyricHandle.get(0).phoneticSymbolList();
@@ -275,10 +359,10 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 
 	std::string renderer = track.common().version;
 	if (renderer.substr(0, 4) == std::string("DSB2")) {
-		add.append((MidiParameterType)0x5011, 0x01, true);  //TODO: Meaning of (byte)0x5011 is unknown.
+		dest.append((MidiParameterType)0x5011, 0x01, true);  //TODO: Meaning of (byte)0x5011 is unknown.
 	}
 
-	add.append(MidiParameterType::CVM_NM_PHONETIC_SYMBOL_BYTES, symbols.size(), true);  // (byte)0x12(Number of phonetic symbols in bytes)
+	dest.append(MidiParameterType::CVM_NM_PHONETIC_SYMBOL_BYTES, symbols.size(), true);  // (byte)0x12(Number of phonetic symbols in bytes)
 	int count = -1;
 	std::vector<int> consonantAdjustment = noteEvent.lyricHandle.get(0).consonantAdjustmentList();
 	for (int j = 0; j < spl.size(); j++) {
@@ -286,14 +370,14 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 		for (int k = 0; k < chars.length(); k++) {
 			count = count + 1;
 			if (k == 0) {
-				add.append((MidiParameterType)((0x50 << 8) | (0x13 + count)), chars[k], consonantAdjustment[j], true);   // Phonetic symbol j
+				dest.append((MidiParameterType)((0x50 << 8) | (0x13 + count)), chars[k], consonantAdjustment[j], true);   // Phonetic symbol j
 			} else {
-				add.append((MidiParameterType)((0x50 << 8) | (0x13 + count)), chars[k], true);   // Phonetic symbol j
+				dest.append((MidiParameterType)((0x50 << 8) | (0x13 + count)), chars[k], true);   // Phonetic symbol j
 			}
 		}
 	}
 	if (renderer.substr(0, 4) != std::string("DSB2")) {
-		add.append(MidiParameterType::CVM_NM_PHONETIC_SYMBOL_CONTINUATION, 0x7f, true);   // End of phonetic symbols
+		dest.append(MidiParameterType::CVM_NM_PHONETIC_SYMBOL_CONTINUATION, 0x7f, true);   // End of phonetic symbols
 	}
 	if (renderer.substr(0, 4) == std::string("DSB3")) {
 		int v1mean = (int)::floor(noteEvent.pmBendDepth * 60 / 100);
@@ -305,45 +389,61 @@ NrpnEvent VocaloidMidiEventListFactory::generateNoteNRPN(Track const& track, Tem
 		}
 		int d1mean = (int)::floor(0.3196 * noteEvent.pmBendLength + 8.0);
 		int d2mean = (int)::floor(0.92 * noteEvent.pmBendLength + 28.0);
-		add.append(MidiParameterType::CVM_NM_V1MEAN, v1mean, true);  // (byte)0x50(v1mean)
-		add.append(MidiParameterType::CVM_NM_D1MEAN, d1mean, true);  // (byte)0x51(d1mean)
-		add.append(MidiParameterType::CVM_NM_D1MEAN_FIRST_NOTE, 0x14, true);  // (byte)0x52(d1meanFirstNote)
-		add.append(MidiParameterType::CVM_NM_D2MEAN, d2mean, true);  // (byte)0x53(d2mean)
-		add.append(MidiParameterType::CVM_NM_D4MEAN, noteEvent.d4mean, true);  // (byte)0x54(d4mean)
-		add.append(MidiParameterType::CVM_NM_PMEAN_ONSET_FIRST_NOTE, noteEvent.pMeanOnsetFirstNote, true);   // 055(pMeanOnsetFirstNote)
-		add.append(MidiParameterType::CVM_NM_VMEAN_NOTE_TRNSITION, noteEvent.vMeanNoteTransition, true);   // (byte)0x56(vMeanNoteTransition)
-		add.append(MidiParameterType::CVM_NM_PMEAN_ENDING_NOTE, noteEvent.pMeanEndingNote, true);  // (byte)0x57(pMeanEndingNote)
-		add.append(MidiParameterType::CVM_NM_ADD_PORTAMENTO, noteEvent.pmbPortamentoUse, true);  // (byte)0x58(AddScoopToUpInternals&AddPortamentoToDownIntervals)
+		dest.append(MidiParameterType::CVM_NM_V1MEAN, v1mean, true);  // (byte)0x50(v1mean)
+		dest.append(MidiParameterType::CVM_NM_D1MEAN, d1mean, true);  // (byte)0x51(d1mean)
+		dest.append(MidiParameterType::CVM_NM_D1MEAN_FIRST_NOTE, 0x14, true);  // (byte)0x52(d1meanFirstNote)
+		dest.append(MidiParameterType::CVM_NM_D2MEAN, d2mean, true);  // (byte)0x53(d2mean)
+		dest.append(MidiParameterType::CVM_NM_D4MEAN, noteEvent.d4mean, true);  // (byte)0x54(d4mean)
+		dest.append(MidiParameterType::CVM_NM_PMEAN_ONSET_FIRST_NOTE, noteEvent.pMeanOnsetFirstNote, true);   // 055(pMeanOnsetFirstNote)
+		dest.append(MidiParameterType::CVM_NM_VMEAN_NOTE_TRNSITION, noteEvent.vMeanNoteTransition, true);   // (byte)0x56(vMeanNoteTransition)
+		dest.append(MidiParameterType::CVM_NM_PMEAN_ENDING_NOTE, noteEvent.pMeanEndingNote, true);  // (byte)0x57(pMeanEndingNote)
+		dest.append(MidiParameterType::CVM_NM_ADD_PORTAMENTO, noteEvent.pmbPortamentoUse, true);  // (byte)0x58(AddScoopToUpInternals&AddPortamentoToDownIntervals)
 		int decay = (int)::floor(noteEvent.demDecGainRate / 100.0 * 0x64);
-		add.append(MidiParameterType::CVM_NM_CHANGE_AFTER_PEAK, decay, true);  // (byte)0x59(changeAfterPeak)
+		dest.append(MidiParameterType::CVM_NM_CHANGE_AFTER_PEAK, decay, true);  // (byte)0x59(changeAfterPeak)
 		int accent = (int)::floor(0x64 * noteEvent.demAccent / 100.0);
-		add.append(MidiParameterType::CVM_NM_ACCENT, accent, true);  // (byte)0x5a(Accent)
+		dest.append(MidiParameterType::CVM_NM_ACCENT, accent, true);  // (byte)0x5a(Accent)
 	}
-	add.append(MidiParameterType::CVM_NM_NOTE_MESSAGE_CONTINUATION, 0x7f, true);  // (byte)0x7f(Note message continuation)
-	return add;
+	dest.append(MidiParameterType::CVM_NM_NOTE_MESSAGE_CONTINUATION, 0x7f, true);  // (byte)0x7f(Note message continuation)
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generatePitchBendNRPN(Track const& track, TempoList const& tempoList, int msPreSend)
 {
-	std::vector<NrpnEvent> ret;
+	NrpnEventBuffer buffer;
+	generatePitchBendNRPN(buffer, track, tempoList, msPreSend);
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generatePitchBendNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int msPreSend)
+{
 	BPList const* pit = track.curve("PIT");
-	std::unique_ptr<PitchBendNrpnEventProvider> provider(new PitchBendNrpnEventProvider());
-	generateNRPNByBPList(ret, tempoList, msPreSend, *pit, *provider);
-	return ret;
+	PitchBendNrpnEventProvider provider;
+	generateNRPNByBPList(dest, tempoList, msPreSend, *pit, provider, 0, pit->size(), 0);
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generatePitchBendSensitivityNRPN(Track const& track, TempoList const& tempoList, int msPreSend)
 {
-	std::vector<NrpnEvent> ret;
+	NrpnEventBuffer buffer;
+	generatePitchBendSensitivityNRPN(buffer, track, tempoList, msPreSend);
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generatePitchBendSensitivityNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int msPreSend)
+{
 	BPList const* pbs = track.curve("PBS");
-	std::unique_ptr<PitchBendSensitivityNrpnEventProvider> provider(new PitchBendSensitivityNrpnEventProvider());
-	generateNRPNByBPList(ret, tempoList, msPreSend, *pbs, *provider);
-	return ret;
+	PitchBendSensitivityNrpnEventProvider provider;
+	generateNRPNByBPList(dest, tempoList, msPreSend, *pbs, provider, 0, pbs->size(), 0);
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateVibratoNRPN(TempoList const& tempoList, Event const& noteEvent, int msPreSend)
 {
-	std::vector<NrpnEvent> ret;
+	NrpnEventBuffer buffer;
+	generateVibratoNRPN(buffer, tempoList, noteEvent, msPreSend);
+	buffer.sort();
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generateVibratoNRPN(NrpnEventBuffer& ret, TempoList const& tempoList, Event const& noteEvent, int msPreSend)
+{
 	if (noteEvent.vibratoHandle.type() != HandleType::UNKNOWN) {
 		tick_t vtick = noteEvent.tick + noteEvent.vibratoDelay;
 		tick_t actualTick;
@@ -351,14 +451,13 @@ std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateVibratoNRPN(TempoLi
 		_getActualTickAndDelay(tempoList, vtick, msPreSend, &actualTick, &delay);
 		int delayMsb, delayLsb;
 		_getMsbAndLsb(delay, &delayMsb, &delayLsb);
-		NrpnEvent add2(actualTick, MidiParameterType::CC_VD_VERSION_AND_DEVICE, 0x00, 0x00);
-		add2.append(MidiParameterType::CC_VR_VERSION_AND_DEVICE, 0x00, 0x00);
-		add2.append(MidiParameterType::CC_VD_DELAY, delayMsb, delayLsb);
-		add2.append(MidiParameterType::CC_VR_DELAY, delayMsb, delayLsb);
+		ret.add(actualTick, MidiParameterType::CC_VD_VERSION_AND_DEVICE, 0x00, 0x00);
+		ret.append(MidiParameterType::CC_VR_VERSION_AND_DEVICE, 0x00, 0x00);
+		ret.append(MidiParameterType::CC_VD_DELAY, delayMsb, delayLsb);
+		ret.append(MidiParameterType::CC_VR_DELAY, delayMsb, delayLsb);
 		// CC_VD_VIBRATO_DEPTH, CC_VR_VIBRATO_RATE では, NRPN の MSB を省略してはいけない
-		add2.append(MidiParameterType::CC_VD_VIBRATO_DEPTH, noteEvent.vibratoHandle.startDepth);
-		add2.append(MidiParameterType::CC_VR_VIBRATO_RATE, noteEvent.vibratoHandle.startRate);
-		ret.push_back(add2);
+		ret.append(MidiParameterType::CC_VD_VIBRATO_DEPTH, noteEvent.vibratoHandle.startDepth);
+		ret.append(MidiParameterType::CC_VR_VIBRATO_RATE, noteEvent.vibratoHandle.startRate);
 		tick_t vlength = noteEvent.length() - noteEvent.vibratoDelay;
 
 		VibratoBPList depthBP = noteEvent.vibratoHandle.depthBP;
@@ -370,16 +469,14 @@ std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateVibratoNRPN(TempoLi
 				double percent = itemi.x;
 				tick_t cl = vtick + (tick_t) ::floor(percent * vlength);
 				_getActualTickAndDelay(tempoList, cl, msPreSend, &actualTick, &delay);
-				NrpnEvent nrpnEvent(0, MidiParameterType::CC_BS_DELAY, 0);
 				if (lastDelay != delay) {
 					_getMsbAndLsb(delay, &delayMsb, &delayLsb);
-					nrpnEvent = NrpnEvent(actualTick, MidiParameterType::CC_VD_DELAY, delayMsb, delayLsb);
-					nrpnEvent.append(MidiParameterType::CC_VD_VIBRATO_DEPTH, itemi.y);
+					ret.add(actualTick, MidiParameterType::CC_VD_DELAY, delayMsb, delayLsb);
+					ret.append(MidiParameterType::CC_VD_VIBRATO_DEPTH, itemi.y);
 				} else {
-					nrpnEvent = NrpnEvent(actualTick, MidiParameterType::CC_VD_VIBRATO_DEPTH, itemi.y);
+					ret.add(actualTick, MidiParameterType::CC_VD_VIBRATO_DEPTH, itemi.y);
 				}
 				lastDelay = delay;
-				ret.push_back(nrpnEvent);
 			}
 		}
 
@@ -392,28 +489,151 @@ std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateVibratoNRPN(TempoLi
 				double percent = itemi.x;
 				tick_t cl = vtick + (tick_t)::floor(percent * vlength);
 				_getActualTickAndDelay(tempoList, cl, msPreSend, &actualTick, &delay);
-				NrpnEvent nrpnEvent(0, MidiParameterType::CC_BS_DELAY, 0);
 				if (lastDelay != delay) {
 					_getMsbAndLsb(delay, &delayMsb, &delayLsb);
-					nrpnEvent = NrpnEvent(actualTick, MidiParameterType::CC_VR_DELAY, delayMsb, delayLsb);
-					nrpnEvent.append(MidiParameterType::CC_VR_VIBRATO_RATE, itemi.y);
+					ret.add(actualTick, MidiParameterType::CC_VR_DELAY, delayMsb, delayLsb);
+					ret.append(MidiParameterType::CC_VR_VIBRATO_RATE, itemi.y);
 				} else {
-					nrpnEvent = NrpnEvent(actualTick, MidiParameterType::CC_VR_VIBRATO_RATE, itemi.y);
+					ret.add(actualTick, MidiParameterType::CC_VR_VIBRATO_RATE, itemi.y);
 				}
 				lastDelay = delay;
-				ret.push_back(nrpnEvent);
 			}
 		}
 	}
-	std::stable_sort(ret.begin(), ret.end(), NrpnEvent::compare);
-	return ret;
 }
 
 std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateVoiceChangeParameterNRPN(Track const& track, TempoList const& tempoList, int msPreSend, tick_t premeasure_tick)
 {
-	std::string renderer = track.common().version;
-	std::vector<NrpnEvent> res;
+	NrpnEventBuffer buffer;
+	generateVoiceChangeParameterNRPN(buffer, track, tempoList, msPreSend, premeasure_tick);
+	buffer.sort();
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generateVoiceChangeParameterNRPN(NrpnEventBuffer& res, Track const& track, TempoList const& tempoList, int msPreSend, tick_t premeasure_tick)
+{
+	std::vector<std::string> curves = getVoiceChangeParameterCurveNames(track.common().version);
+
+	int lastDelay = 0;
+	for (int i = 0; i < curves.size(); i++) {
+		BPList const* list = track.curve(curves[i]);
+		if (list->size() > 0) {
+			lastDelay = addVoiceChangeParameters(res, *list, tempoList, msPreSend, lastDelay, 0, list->size());
+		}
+	}
+}
+
+std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateFx2DepthNRPN(Track const& track, TempoList const& tempoList, int preSendMilliseconds)
+{
+	NrpnEventBuffer buffer;
+	generateFx2DepthNRPN(buffer, track, tempoList, preSendMilliseconds);
+	return buffer.toList();
+}
+
+void VocaloidMidiEventListFactory::generateFx2DepthNRPN(NrpnEventBuffer& dest, Track const& track, TempoList const& tempoList, int preSendMilliseconds)
+{
+	BPList const* fx2depth = track.curve("fx2depth");
+	NrpnEventProvider provider(MidiParameterType::CC_FX2_DELAY, MidiParameterType::CC_FX2_EFFECT2_DEPTH);
+	generateNRPNByBPList(dest, tempoList, preSendMilliseconds, *fx2depth, provider, 0, fx2depth->size(), 0);
+}
+
+int VocaloidMidiEventListFactory::addVoiceChangeParameters(std::vector<NrpnEvent>& dest, BPList const& list, TempoList const& tempoList, int msPreSend, int lastDelay)
+{
+	NrpnEventBuffer buffer;
+	int result = addVoiceChangeParameters(buffer, list, tempoList, msPreSend, lastDelay, 0, list.size());
+	std::vector<NrpnEvent> added = buffer.toList();
+	dest.insert(dest.end(), added.begin(), added.end());
+	return result;
+}
+
+int VocaloidMidiEventListFactory::addVoiceChangeParameters(NrpnEventBuffer& dest, BPList const& list, TempoList const& tempoList, int msPreSend, int lastDelay, int begin, int end)
+{
+	int id = MidiParameterTypeUtil::getVoiceChangeParameterId(list.name());
+	for (int j = begin; j < end; j++) {
+		lastDelay = addVoiceChangeParameter(dest, id, list.keyTickAt(j), list.get(j).value, tempoList, msPreSend, lastDelay);
+	}
+	return lastDelay;
+}
+
+int VocaloidMidiEventListFactory::addVoiceChangeParameter(NrpnEventBuffer& dest, int id, tick_t tick, int value, TempoList const& tempoList, int msPreSend, int lastDelay)
+{
+	tick_t actualTick;
+	int delay;
+	_getActualTickAndDelay(tempoList, tick, msPreSend, &actualTick, &delay);
 
+	if (actualTick >= 0) {
+		if (lastDelay != delay) {
+			int delayMsb, delayLsb;
+			_getMsbAndLsb(delay, &delayMsb, &delayLsb);
+			dest.add(actualTick, MidiParameterType::VCP_DELAY, delayMsb, delayLsb);
+			lastDelay = delay;
+		}
+
+		dest.add(actualTick, MidiParameterType::VCP_VOICE_CHANGE_PARAMETER_ID, id);
+		dest.append(MidiParameterType::VCP_VOICE_CHANGE_PARAMETER, value, true);
+	}
+	return lastDelay;
+}
+
+void VocaloidMidiEventListFactory::getEventRange(Track const& track, tick_t totalTicks, int* start, int* end)
+{
+	Event::List const& events = track.events();
+	int count = events.size();
+	*start = 0;
+	*end = count - 1;
+	for (int i = 0; i < count; i++) {
+		if (0 <= events.get(i)->tick) {
+			*start = i;
+			break;
+		}
+		*start = i;
+	}
+	for (int i = count - 1; i >= 0; i--) {
+		if (events.get(i)->tick <= totalTicks) {
+			*end = i;
+			break;
+		}
+	}
+}
+
+int VocaloidMidiEventListFactory::findFirstSingerEvent(Track const& track, int noteStart)
+{
+	Event::List const& events = track.events();
+	for (int i = noteStart; i >= 0; i--) {
+		if (events.get(i)->type() == EventType::SINGER) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+int VocaloidMidiEventListFactory::getNoteLocation(Track const& track, int index, tick_t lastNoteEnd)
+{
+	Event::List const& events = track.events();
+	Event const* item = events.get(index);
+	int note_loc = 0x03;
+	if (item->tick == lastNoteEnd) {
+		note_loc = note_loc - 0x02;
+	}
+
+	// find next note event
+	tick_t nexttick = item->tick + item->length() + 1;
+	int event_count = events.size();
+	for (int j = index + 1; j < event_count; j++) {
+		Event const* itemj = events.get(j);
+		if (itemj->type() == EventType::NOTE) {
+			nexttick = itemj->tick;
+			break;
+		}
+	}
+	if (item->tick + item->length() == nexttick) {
+		note_loc = note_loc - 0x01;
+	}
+	return note_loc;
+}
+
+std::vector<std::string> VocaloidMidiEventListFactory::getVoiceChangeParameterCurveNames(std::string const& renderer)
+{
 	std::vector<std::string> curves;
 	if (renderer.substr(0, 4) == "DSB3") {
 		curves.push_back("BRE");
@@ -448,51 +668,7 @@ std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateVoiceChangeParamete
 		curves.push_back("POR");
 		curves.push_back("GEN");
 	}
-
-	int lastDelay = 0;
-	for (int i = 0; i < curves.size(); i++) {
-		BPList const* list = track.curve(curves[i]);
-		if (list->size() > 0) {
-			lastDelay = addVoiceChangeParameters(res, *list, tempoList, msPreSend, lastDelay);
-		}
-	}
-	std::stable_sort(res.begin(), res.end(), NrpnEvent::compare);
-	return res;
-}
-
-std::vector<NrpnEvent> VocaloidMidiEventListFactory::generateFx2DepthNRPN(Track const& track, TempoList const& tempoList, int preSendMilliseconds)
-{
-	std::vector<NrpnEvent> ret;
-	BPList const* fx2depth = track.curve("fx2depth");
-	std::unique_ptr<NrpnEventProvider> provider(new NrpnEventProvider(MidiParameterType::CC_FX2_DELAY, MidiParameterType::CC_FX2_EFFECT2_DEPTH));
-	generateNRPNByBPList(ret, tempoList, preSendMilliseconds, *fx2depth, *provider);
-	return ret;
-}
-
-int VocaloidMidiEventListFactory::addVoiceChangeParameters(std::vector<NrpnEvent>& dest, BPList const& list, TempoList const& tempoList, int msPreSend, int lastDelay)
-{
-	int id = MidiParameterTypeUtil::getVoiceChangeParameterId(list.name());
-	for (int j = 0; j < list.size(); j++) {
-		tick_t tick = list.keyTickAt(j);
-		int value = list.get(j).value;
-		tick_t actualTick;
-		int delay;
-		_getActualTickAndDelay(tempoList, tick, msPreSend, &actualTick, &delay);
-
-		if (actualTick >= 0) {
-			if (lastDelay != delay) {
-				int delayMsb, delayLsb;
-				_getMsbAndLsb(delay, &delayMsb, &delayLsb);
-				dest.emplace_back(actualTick, MidiParameterType::VCP_DELAY, delayMsb, delayLsb);
-				lastDelay = delay;
-			}
-
-			NrpnEvent add(actualTick, MidiParameterType::VCP_VOICE_CHANGE_PARAMETER_ID, id);
-			add.append(MidiParameterType::VCP_VOICE_CHANGE_PARAMETER, value, true);
-			dest.push_back(add);
-		}
-	}
-	return lastDelay;
+	return curves;
 }
 
 void VocaloidMidiEventListFactory::_getActualTickAndDelay(TempoList const& tempoList, tick_t tick, int msPreSend, tick_t* actualTick, int* delay)
@@ -519,35 +695,46 @@ void VocaloidMidiEventListFactory::_getMsbAndLsb(int value, int* msb, int* lsb)
 	}
 }
 
-void VocaloidMidiEventListFactory::generateNRPNByBPList(
-	std::vector<NrpnEvent>& result,
+int VocaloidMidiEventListFactory::generateNRPNByBPList(
+	NrpnEventBuffer& result,
 	TempoList const& tempoList, int preSendMilliseconds,
-	BPList const& list, NrpnEventProvider const& provider
+	BPList const& list, NrpnEventProvider const& provider,
+	int begin, int end, int lastDelay
 )
 {
-	size_t count = list.size();
-	int lastDelay = 0;
-	for (int i = 0; i < count; i++) {
-		tick_t tick = list.keyTickAt(i);
-		tick_t actualTick;
-		int delay;
-		_getActualTickAndDelay(tempoList, tick, preSendMilliseconds, &actualTick, &delay);
-		if (actualTick >= 0) {
-			NrpnEvent add = provider.getNrpnEvent(actualTick, list.get(i).value);
-			if (lastDelay != delay) {
-				NrpnEvent delayNrpn = provider.getDelayNrpnEvent(actualTick, delay);
-				if (add.hasLSB) {
-					delayNrpn.append(add.nrpn, add.dataLSB, add.dataLSB, add.isMSBOmittingRequired);
-				} else {
-					delayNrpn.append(add.nrpn, add.dataMSB, add.isMSBOmittingRequired);
-				}
-				result.push_back(delayNrpn);
+	for (int i = begin; i < end; i++) {
+		lastDelay = generateNRPNByBP(result, tempoList, preSendMilliseconds, list.keyTickAt(i), list.get(i).value, provider, lastDelay);
+	}
+	return lastDelay;
+}
+
+int VocaloidMidiEventListFactory::generateNRPNByBP(
+	NrpnEventBuffer& result,
+	TempoList const& tempoList, int preSendMilliseconds,
+	tick_t tick, int value, NrpnEventProvider const& provider, int lastDelay
+)
+{
+	tick_t actualTick;
+	int delay;
+	_getActualTickAndDelay(tempoList, tick, preSendMilliseconds, &actualTick, &delay);
+	if (actualTick >= 0) {
+		NrpnEvent add = provider.getNrpnEvent(actualTick, value);
+		if (lastDelay != delay) {
+			NrpnEvent delayNrpn = provider.getDelayNrpnEvent(actualTick, delay);
+			result.add(delayNrpn.tick, delayNrpn.nrpn, delayNrpn.dataMSB, delayNrpn.dataLSB);
+			if (add.hasLSB) {
+				result.append(add.nrpn, add.dataLSB, add.dataLSB, add.isMSBOmittingRequired);
 			} else {
-				result.push_back(add);
+				result.append(add.nrpn, add.dataMSB, add.isMSBOmittingRequired);
 			}
-			lastDelay = delay;
+		} else if (add.hasLSB) {
+			result.add(add.tick, add.nrpn, add.dataMSB, add.dataLSB);
+		} else {
+			result.add(add.tick, add.nrpn, add.dataMSB);
 		}
+		lastDelay = delay;
 	}
+	return lastDelay;
 }
 
 LIBVSQ_END_NAMESPACE
@@ -0,0 +1,83 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/BufferedInputStream.hpp"
+#include "../include/libvsq/FileInputStream.hpp"
+#include <random>
+#include <cstring>
+
+using namespace std;
+using namespace vsq;
+
+TEST(BufferedInputStreamTest, test)
+{
+	FileInputStream file("FileInputStreamTest/fixture/data.bin");
+	BufferedInputStream stream(file, 8);
+	EXPECT_TRUE(stream.data() == nullptr);
+	EXPECT_EQ((int64_t)0, stream.getPointer());
+	EXPECT_EQ(0x00, stream.read());
+	EXPECT_EQ((int64_t)1, stream.getPointer());
+	stream.seek(0x05);
+	EXPECT_EQ(0x05, stream.read());
+	EXPECT_EQ((int64_t)0x06, stream.getPointer());
+
+	stream.seek(0x10);
+	char buffer[20] = { 0 };
+	EXPECT_EQ(5, stream.read(buffer, 5, 5));
+	EXPECT_EQ((char)0, buffer[4]);
+	EXPECT_EQ((char)0x10, buffer[5]);
+	EXPECT_EQ((char)0x14, buffer[9]);
+
+	// バッファーの長さ以上の読み込み
+	EXPECT_EQ(12, stream.read(buffer, 0, 12));
+	EXPECT_EQ((char)0x15, buffer[0]);
+	EXPECT_EQ((char)0x20, buffer[11]);
+	EXPECT_EQ((int64_t)0x21, stream.getPointer());
+
+	stream.seek(0x2F);
+	EXPECT_EQ(1, stream.read(buffer, 0, 2));
+	EXPECT_EQ((char)0x2F, buffer[0]);
+
+	stream.seek(0x2F);
+	EXPECT_EQ(0x2F, stream.read());
+	EXPECT_TRUE(stream.read() < 0);
+}
+
+TEST(BufferedInputStreamTest, testRestorePointerOnDestruct)
+{
+	FileInputStream file("FileInputStreamTest/fixture/data.bin");
+	{
+		BufferedInputStream stream(file);
+		EXPECT_EQ(0x00, stream.read());
+		EXPECT_EQ(0x01, stream.read());
+	}
+	EXPECT_EQ((int64_t)2, file.getPointer());
+	EXPECT_EQ(0x02, file.read());
+}
+
+TEST(BufferedInputStreamTest, testSameAsUnbuffered)
+{
+	mt19937 random(1);
+	for (int bufferLength = 1; bufferLength < 20; bufferLength++) {
+		FileInputStream expected("FileInputStreamTest/fixture/data.bin");
+		FileInputStream file("FileInputStreamTest/fixture/data.bin");
+		BufferedInputStream actual(file, bufferLength);
+		for (int i = 0; i < 300; i++) {
+			int operation = random() % 3;
+			if (operation == 0) {
+				ASSERT_EQ(expected.read(), actual.read());
+			} else if (operation == 1) {
+				char expectedBuffer[32] = { 0 };
+				char actualBuffer[32] = { 0 };
+				int count = random() % 32;
+				ASSERT_EQ(expected.read(expectedBuffer, 0, count), actual.read(actualBuffer, 0, count));
+				ASSERT_EQ(0, memcmp(expectedBuffer, actualBuffer, sizeof(expectedBuffer)));
+			} else {
+				int64_t position = random() % 0x30;
+				expected.seek(position);
+				actual.seek(position);
+			}
+			if (0 <= expected.getPointer()) {
+				ASSERT_EQ(expected.getPointer(), actual.getPointer());
+			}
+		}
+	}
+}
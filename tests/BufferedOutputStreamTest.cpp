@@ -0,0 +1,98 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/BufferedOutputStream.hpp"
+#include "../include/libvsq/ByteArrayOutputStream.hpp"
+#include <random>
+
+using namespace std;
+using namespace vsq;
+
+TEST(BufferedOutputStreamTest, testWrite)
+{
+	ByteArrayOutputStream output;
+	{
+		BufferedOutputStream stream(output, 4);
+		stream.write(0x01);
+		stream.write(0x02);
+		EXPECT_EQ((int64_t)2, stream.getPointer());
+		// flush するまで書き込まれない
+		EXPECT_EQ(string(""), output.toString());
+
+		char const data[] = { 0x03, 0x04, 0x05 };
+		stream.write(data, 0, 3);
+		EXPECT_EQ((int64_t)5, stream.getPointer());
+		EXPECT_EQ(string("\x01\x02"), output.toString());
+
+		// バッファーの長さ以上のデータは直接書き込まれる
+		char const large[] = { 0x06, 0x07, 0x08, 0x09, 0x0A };
+		stream.write(large, 0, 5);
+		EXPECT_EQ((int64_t)10, stream.getPointer());
+		EXPECT_EQ(string("\x01\x02\x03\x04\x05\x06\x07\x08\x09\x0A"), output.toString());
+	}
+}
+
+TEST(BufferedOutputStreamTest, testSeekInsideBuffer)
+{
+	ByteArrayOutputStream output;
+	BufferedOutputStream stream(output);
+	char const empty[] = { 0x00, 0x00, 0x00, 0x00 };
+	stream.write(empty, 0, 4);
+	stream.write(0x41);
+	stream.write(0x42);
+	stream.seek(1);
+	stream.write(0x7F);
+	EXPECT_EQ((int64_t)2, stream.getPointer());
+	stream.seek(6);
+	stream.write(0x43);
+	EXPECT_EQ(string(""), output.toString());
+	stream.flush();
+	EXPECT_EQ(string("\x00\x7F\x00\x00\x41\x42\x43", 7), output.toString());
+	EXPECT_EQ((int64_t)7, output.getPointer());
+}
+
+TEST(BufferedOutputStreamTest, testSameAsUnbuffered)
+{
+	mt19937 random(1);
+	for (int bufferLength = 1; bufferLength < 20; bufferLength++) {
+		ByteArrayOutputStream expected;
+		ByteArrayOutputStream actualOutput;
+		{
+			BufferedOutputStream actual(actualOutput, bufferLength);
+			int64_t length = 0;
+			for (int i = 0; i < 500; i++) {
+				int operation = random() % 3;
+				if (operation == 0) {
+					int value = random() % 256;
+					expected.write(value);
+					actual.write(value);
+				} else if (operation == 1) {
+					char data[32];
+					int count = random() % 32;
+					for (int j = 0; j < count; j++) {
+						data[j] = random() % 256;
+					}
+					expected.write(data, 0, count);
+					actual.write(data, 0, count);
+				} else {
+					int64_t position = length == 0 ? 0 : random() % (length + 1);
+					expected.seek(position);
+					actual.seek(position);
+				}
+				length = std::max(length, expected.getPointer());
+				ASSERT_EQ(expected.getPointer(), actual.getPointer());
+			}
+			actual.flush();
+		}
+		EXPECT_EQ(expected.toString(), actualOutput.toString());
+	}
+}
+
+TEST(BufferedOutputStreamTest, testDestructWithoutFlush)
+{
+	ByteArrayOutputStream output;
+	{
+		BufferedOutputStream stream(output);
+		stream.write(0x01);
+	}
+	// flush しないまま破棄した場合は, 出力先に書き込まれない
+	EXPECT_EQ(string(""), output.toString());
+}
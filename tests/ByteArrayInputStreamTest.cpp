@@ -0,0 +1,53 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/ByteArrayInputStream.hpp"
+
+using namespace std;
+using namespace vsq;
+
+TEST(ByteArrayInputStreamTest, test)
+{
+	uint8_t data[0x30];
+	for (int i = 0; i < 0x30; i++) {
+		data[i] = i;
+	}
+	ByteArrayInputStream stream(data, sizeof(data));
+	EXPECT_TRUE(stream.data() == data);
+	EXPECT_EQ((int64_t)0x30, stream.length());
+	EXPECT_EQ((int64_t)0, stream.getPointer());
+	EXPECT_EQ(0x00, stream.read());
+	EXPECT_EQ((int64_t)1, stream.getPointer());
+	stream.seek(0x05);
+	EXPECT_EQ(0x05, stream.read());
+	EXPECT_EQ((int64_t)0x06, stream.getPointer());
+
+	stream.seek(0x10);
+	char buffer[10] = { 0 };
+	EXPECT_EQ(5, stream.read(buffer, 5, 5));
+	EXPECT_EQ((char)0, buffer[4]);
+	EXPECT_EQ((char)0x10, buffer[5]);
+	EXPECT_EQ((char)0x14, buffer[9]);
+	EXPECT_EQ((int64_t)0x15, stream.getPointer());
+
+	stream.seek(0x2F);
+	EXPECT_EQ(1, stream.read(buffer, 0, 2));
+	EXPECT_EQ((char)0x2F, buffer[0]);
+
+	stream.seek(0x2F);
+	EXPECT_EQ(0x2F, stream.read());
+	EXPECT_TRUE(stream.read() < 0);
+	EXPECT_EQ(0, stream.read(buffer, 0, 2));
+
+	stream.close();
+	EXPECT_TRUE(stream.data() == nullptr);
+	EXPECT_EQ((int64_t)0, stream.length());
+	EXPECT_TRUE(stream.read() < 0);
+}
+
+TEST(ByteArrayInputStreamTest, testConstructWithCharArray)
+{
+	char const data[] = { 'a', (char)0xff };
+	ByteArrayInputStream stream(data, 2);
+	EXPECT_EQ('a', stream.read());
+	EXPECT_EQ(0xff, stream.read());
+	EXPECT_TRUE(stream.read() < 0);
+}
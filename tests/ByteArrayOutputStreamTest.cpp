@@ -64,3 +64,60 @@ TEST(ByteArrayOutputStreamTest, testSeek)
 	expected.insert(expected.end(), 'a');
 	EXPECT_TRUE(expected == actual);
 }
+
+TEST(ByteArrayOutputStreamTest, testWriteMany)
+{
+	ByteArrayOutputStream stream;
+	string expected;
+	for (int i = 0; i < 100000; i++) {
+		char c = (char)(i % 251);
+		if (i % 2 == 0) {
+			stream.write(c);
+		} else {
+			stream.write(&c, 0, 1);
+		}
+		expected += c;
+	}
+	EXPECT_EQ((int64_t)100000, stream.getPointer());
+	EXPECT_EQ(expected, stream.toString());
+}
+
+TEST(ByteArrayOutputStreamTest, testReserve)
+{
+	ByteArrayOutputStream stream;
+	stream.write('a');
+	stream.reserve(10000);
+	// reserve しても, 書き込み済みの内容と位置は変わらない
+	EXPECT_EQ((int64_t)1, stream.getPointer());
+	EXPECT_EQ(string("a"), stream.toString());
+	stream.write('b');
+	EXPECT_EQ(string("ab"), stream.toString());
+
+	// 現在より小さい値を指定しても何も起きない
+	stream.reserve(1);
+	EXPECT_EQ(string("ab"), stream.toString());
+
+	// 確保した領域は, 書き込み済みの長さとは別に保持される
+	vector<char> released = stream.release();
+	EXPECT_EQ((size_t)2, released.size());
+	EXPECT_LE((size_t)10000, released.capacity());
+}
+
+TEST(ByteArrayOutputStreamTest, testRelease)
+{
+	ByteArrayOutputStream stream;
+	char const data[] = { 'f', 'o', 'o', 'b', 'a', 'r' };
+	stream.write(data, 0, 6);
+	stream.seek(1);
+	stream.write('x');
+
+	vector<char> actual = stream.release();
+	vector<char> expected = { 'f', 'x', 'o', 'b', 'a', 'r' };
+	EXPECT_TRUE(expected == actual);
+
+	// 取り出した後は空になる
+	EXPECT_EQ((int64_t)0, stream.getPointer());
+	EXPECT_EQ(string(""), stream.toString());
+	stream.write('z');
+	EXPECT_EQ(string("z"), stream.toString());
+}
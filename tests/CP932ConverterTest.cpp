@@ -34,6 +34,42 @@ TEST(CP932ConverterTest, testConvertToUTF8)
 	}
 }
 
+TEST(CP932ConverterTest, testConvertLinesToUTF8)
+{
+	vector<string> lines;
+	{
+		ostringstream line;
+		line << "[EventList]";
+		lines.push_back(line.str());
+	}
+	lines.push_back("");
+	{
+		ostringstream line;
+		line << "L0=" << (char)0x82 << (char)0xA0 << (char)0x82 << (char)0xA2 << ",a,0.000000,64,0,0";
+		lines.push_back(line.str());
+	}
+	{
+		ostringstream line;
+		line << (char)0x82 << (char)0xA0;
+		lines.push_back(line.str());
+	}
+
+	string fixture;
+	string expected;
+	for (size_t i = 0; i < lines.size(); ++i) {
+		fixture += lines[i] + "\n";
+		expected += CP932Converter::convertToUTF8(lines[i]) + "\n";
+	}
+	EXPECT_EQ(expected, CP932Converter::convertLinesToUTF8(fixture));
+
+	// 末尾が改行で終わっていない場合
+	fixture.pop_back();
+	expected.pop_back();
+	EXPECT_EQ(expected, CP932Converter::convertLinesToUTF8(fixture));
+
+	EXPECT_EQ(string(), CP932Converter::convertLinesToUTF8(string()));
+}
+
 TEST(CP932ConverterTest, test_getUnicodeBytesFromUTF8Bytes)
 {
 	vector<int> a;
@@ -133,6 +133,26 @@ TEST(EventListTest, testAddWithInternalId)
 	EXPECT_EQ(2, list.get(1)->id);
 }
 
+TEST(EventListTest, testAddWithoutSort)
+{
+	Event::List list;
+	Event a(480, EventType::NOTE);
+	a.lyricHandle = Handle(HandleType::LYRIC);
+	a.lyricHandle.set(0, Lyric("a", "a"));
+	Event b(0, EventType::NOTE);
+	list.addWithoutSort(std::move(a), 3);
+	list.addWithoutSort(std::move(b), 1);
+
+	// 並べ替えは行われない
+	ASSERT_EQ(2, list.size());
+	EXPECT_EQ(480, list.get(0)->tick);
+	EXPECT_EQ(3, list.get(0)->id);
+	EXPECT_EQ(string("a"), list.get(0)->lyricHandle.get(0).phrase);
+	EXPECT_EQ(0, list.get(1)->tick);
+	EXPECT_EQ(1, list.get(1)->id);
+	EXPECT_EQ(4, list.add(Event(960, EventType::NOTE)));
+}
+
 TEST(EventListTest, testRemoveAt)
 {
 	Event::List list;
@@ -0,0 +1,167 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/IncrementalNrpnGenerator.hpp"
+#include "../include/libvsq/VocaloidMidiEventListFactory.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
+#include "../include/libvsq/Sequence.hpp"
+#include <random>
+
+using namespace std;
+using namespace vsq;
+
+static Event createNote(tick_t tick, tick_t length, int note, bool vibrato)
+{
+	Event noteEvent(tick, EventType::NOTE);
+	noteEvent.note = note;
+	noteEvent.length(length);
+	noteEvent.lyricHandle = Handle(HandleType::LYRIC);
+	noteEvent.lyricHandle.set(0, Lyric("あ", "a"));
+	if (vibrato) {
+		noteEvent.vibratoDelay = length / 2;
+		noteEvent.vibratoHandle = Handle(HandleType::VIBRATO);
+		noteEvent.vibratoHandle.length(length - noteEvent.vibratoDelay);
+		noteEvent.vibratoHandle.iconId = "$04040005";
+		noteEvent.vibratoHandle.startDepth = 64;
+		noteEvent.vibratoHandle.startRate = 50;
+	}
+	return noteEvent;
+}
+
+static void expectSameBuffer(NrpnEventBuffer const& expected, NrpnEventBuffer const& actual)
+{
+	ASSERT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++) {
+		NrpnEventBuffer::Record const& e = expected.get(i);
+		NrpnEventBuffer::Record const& a = actual.get(i);
+		ASSERT_EQ(e.tick, a.tick);
+		ASSERT_EQ(e.nrpn, a.nrpn);
+		ASSERT_EQ(e.dataMSB, a.dataMSB);
+		ASSERT_EQ(e.dataLSB, a.dataLSB);
+		ASSERT_EQ(e.flags, a.flags);
+	}
+}
+
+static void testRandomEdit(string const& version)
+{
+	Sequence sequence("Miku", 1, 4, 4, 500000);
+	sequence.tempoList.push(Tempo(7680, 400000));
+	sequence.tempoList.updateTempoInfo();
+	Track& track = sequence.track(0);
+	track.common().version = version;
+
+	vector<string> curveNames;
+	curveNames.push_back("DYN");
+	curveNames.push_back("PIT");
+	curveNames.push_back("PBS");
+	curveNames.push_back("BRE");
+	curveNames.push_back("BRI");
+	curveNames.push_back("CLE");
+	curveNames.push_back("GEN");
+	if (version.substr(0, 4) == "DSB2") {
+		curveNames.push_back("fx2depth");
+		curveNames.push_back("harmonics");
+	}
+
+	mt19937 random(1);
+	for (int i = 0; i < 40; i++) {
+		track.events().add(createNote(1920 + i * 240, 240, 60 + i % 12, i % 5 == 0));
+	}
+	for (string const& name : curveNames) {
+		for (int i = 0; i < 10; i++) {
+			track.curve(name)->add(1920 + random() % 9600, random() % 64);
+		}
+	}
+	Event singer(3840, EventType::SINGER);
+	singer.singerHandle = Handle(HandleType::SINGER);
+	track.events().add(singer);
+
+	// 編集で追加する音符の一部がシーケンスの範囲外になるよう, シーケンスの長さを固定する
+	tick_t const totalTicks = 11000;
+	IncrementalNrpnGenerator generator;
+	NrpnEventBuffer expected;
+	VocaloidMidiEventListFactory::generateNRPN(expected, track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 500);
+	expectSameBuffer(expected, generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 500));
+
+	for (int i = 0; i < 200; i++) {
+		tick_t const tick = 1920 + (random() % 80) * 120;
+		switch (random() % 4) {
+			case 0: {
+				track.events().add(createNote(tick, 120 * (1 + random() % 4), 48 + random() % 24, random() % 3 == 0));
+				generator.invalidate(tick, tick + 1);
+				break;
+			}
+			case 1: {
+				Event::List& events = track.events();
+				int const index = random() % events.size();
+				if (events.get(index)->type() == EventType::NOTE) {
+					generator.invalidate(events.get(index)->tick, events.get(index)->tick + 1);
+					events.removeAt(index);
+				}
+				break;
+			}
+			case 2: {
+				BPList* list = track.curve(curveNames[random() % curveNames.size()]);
+				list->add(tick, random() % 64);
+				generator.invalidate(tick, tick + 1);
+				break;
+			}
+			default: {
+				BPList* list = track.curve(curveNames[random() % curveNames.size()]);
+				if (0 < list->size()) {
+					int const index = random() % list->size();
+					tick_t const from = list->keyTickAt(index);
+					list->remove(from);
+					generator.invalidate(from, from + 1);
+				}
+				break;
+			}
+		}
+		VocaloidMidiEventListFactory::generateNRPN(expected, track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 500);
+		expectSameBuffer(expected, generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 500));
+	}
+}
+
+TEST(IncrementalNrpnGeneratorTest, testGenerate)
+{
+	testRandomEdit("DSB301");
+}
+
+TEST(IncrementalNrpnGeneratorTest, testGenerateDSB2)
+{
+	testRandomEdit("DSB202");
+}
+
+TEST(IncrementalNrpnGeneratorTest, testGenerateWithParameterChange)
+{
+	Sequence sequence("Miku", 1, 4, 4, 500000);
+	Track& track = sequence.track(0);
+	for (int i = 0; i < 10; i++) {
+		track.events().add(createNote(1920 + i * 480, 480, 60 + i, false));
+	}
+	track.curve("DYN")->add(1920, 64);
+
+	sequence.updateTotalTicks();
+	IncrementalNrpnGenerator generator;
+	tick_t const totalTicks = sequence.totalTicks();
+	int const count = generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 500).size();
+
+	// 変更を通知しなければ, 前回の結果がそのまま返る
+	track.curve("DYN")->add(2400, 32);
+	EXPECT_EQ(count, generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 500).size());
+
+	// プリセンドタイムが変わった場合は全体を生成し直す
+	NrpnEventBuffer expected;
+	VocaloidMidiEventListFactory::generateNRPN(expected, track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 300);
+	expectSameBuffer(expected, generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 300));
+
+	// テンポが変わった場合も全体を生成し直す
+	sequence.tempoList.push(Tempo(3840, 300000));
+	sequence.tempoList.updateTempoInfo();
+	VocaloidMidiEventListFactory::generateNRPN(expected, track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 300);
+	expectSameBuffer(expected, generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 300));
+
+	// invalidate() を呼んだ場合も全体を生成し直す
+	track.curve("DYN")->add(2880, 16);
+	generator.invalidate();
+	VocaloidMidiEventListFactory::generateNRPN(expected, track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 300);
+	expectSameBuffer(expected, generator.generate(track, sequence.tempoList, totalTicks, sequence.preMeasureTicks(), 300));
+}
@@ -39,6 +39,17 @@ TEST(LyricTest, testSetPhoneticSymbol)
 	EXPECT_EQ(string("a"), actual[1]);
 }
 
+TEST(LyricTest, testSetPhoneticSymbolWithRange)
+{
+	Lyric lyric = Lyric("あ", "a");
+	string value = "\"k'  a\"";
+	lyric.phoneticSymbol(value.data() + 1, value.data() + value.size() - 1);
+	vector<string> actual = lyric.phoneticSymbolList();
+	EXPECT_EQ(2, (int)actual.size());
+	EXPECT_EQ(string("k'"), actual[0]);
+	EXPECT_EQ(string("a"), actual[1]);
+}
+
 TEST(LyricTest, testGetConsonantAdjustmentList)
 {
 	Lyric lyric = Lyric("は", "h a");
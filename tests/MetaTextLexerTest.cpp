@@ -0,0 +1,49 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/MetaTextLexer.hpp"
+#include "../include/libvsq/TextStream.hpp"
+
+using namespace std;
+using namespace vsq;
+
+TEST(MetaTextLexerTest, testNext)
+{
+	TextStream stream;
+	stream.writeLine("[h#0000]");
+	stream.writeLine("Length=480");
+	stream.writeLine("IDS=a=b");
+	stream.write("Caption=");
+	stream.setPointer(-1);
+
+	MetaTextLexer lexer(stream);
+	EXPECT_TRUE(lexer.ready());
+	lexer.next();
+	EXPECT_EQ(string("[h#0000]"), lexer.line().toString());
+	EXPECT_EQ(string("[h#0000]"), lexer.key().toString());
+	EXPECT_TRUE(lexer.value().empty());
+	EXPECT_TRUE(lexer.line().startsWith('['));
+
+	lexer.next();
+	EXPECT_TRUE(lexer.key() == "Length");
+	EXPECT_EQ(480, lexer.value().toInt<int>());
+
+	lexer.next();
+	EXPECT_EQ(string("IDS"), lexer.key().toString());
+	EXPECT_EQ(string("a"), lexer.value().toString());
+	EXPECT_EQ(string("a=b"), lexer.rest().toString());
+
+	EXPECT_TRUE(lexer.ready());
+	lexer.next();
+	EXPECT_EQ(string("Caption"), lexer.key().toString());
+	EXPECT_TRUE(lexer.value().empty());
+	EXPECT_TRUE(lexer.rest().empty());
+	EXPECT_FALSE(lexer.ready());
+}
+
+TEST(MetaTextLexerTest, testHash)
+{
+	static_assert(MetaTextLexer::hash("Length") != MetaTextLexer::hash("Language"), "");
+	string const key = "DEMdecGainRate";
+	MetaTextLexer::Range range(key.data(), key.data() + key.size());
+	EXPECT_EQ(MetaTextLexer::hash("DEMdecGainRate"), range.hash());
+	EXPECT_EQ(MetaTextLexer::hash(""), MetaTextLexer::Range().hash());
+}
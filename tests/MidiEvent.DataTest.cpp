@@ -0,0 +1,101 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/MidiEvent.hpp"
+#include <utility>
+
+using namespace std;
+using namespace vsq;
+
+TEST(MidiEventDataTest, testPushBack)
+{
+	MidiEvent::Data data;
+	EXPECT_TRUE(data.empty());
+	EXPECT_EQ((size_t)0, data.size());
+	EXPECT_EQ(MidiEvent::Data::INLINE_CAPACITY, data.capacity());
+
+	data.push_back(0x63);
+	data.push_back(0x1ff);
+	data.push_back(-1);
+	EXPECT_FALSE(data.empty());
+	EXPECT_EQ((size_t)3, data.size());
+	EXPECT_EQ(0x63, data[0]);
+	EXPECT_EQ(0xff, data[1]);
+	EXPECT_EQ(0xff, data[2]);
+	EXPECT_EQ(MidiEvent::Data::INLINE_CAPACITY, data.capacity());
+
+	data.clear();
+	EXPECT_TRUE(data.empty());
+}
+
+TEST(MidiEventDataTest, testSpillToHeap)
+{
+	MidiEvent::Data data;
+	for (int i = 0; i < 200; i++) {
+		data.push_back(i);
+	}
+	EXPECT_EQ((size_t)200, data.size());
+	EXPECT_TRUE(MidiEvent::Data::INLINE_CAPACITY < data.capacity());
+	for (int i = 0; i < 200; i++) {
+		EXPECT_EQ(i, data[i]);
+	}
+
+	int sum = 0;
+	for (uint8_t value : data) {
+		sum += value;
+	}
+	EXPECT_EQ(199 * 200 / 2, sum);
+}
+
+TEST(MidiEventDataTest, testResize)
+{
+	MidiEvent::Data data;
+	data.push_back(1);
+	data.resize(4);
+	EXPECT_EQ((size_t)4, data.size());
+	EXPECT_EQ(1, data[0]);
+	EXPECT_EQ(0, data[1]);
+	EXPECT_EQ(0, data[3]);
+
+	data.resize(40);
+	EXPECT_EQ((size_t)40, data.size());
+	EXPECT_EQ(1, data[0]);
+	EXPECT_EQ(0, data[39]);
+
+	data.resize(2);
+	EXPECT_EQ((size_t)2, data.size());
+}
+
+TEST(MidiEventDataTest, testCopyAndMove)
+{
+	MidiEvent::Data small;
+	small.push_back(0x51);
+	small.push_back(0x07);
+	MidiEvent::Data large;
+	for (int i = 0; i < 100; i++) {
+		large.push_back(i);
+	}
+
+	MidiEvent::Data copiedSmall(small);
+	MidiEvent::Data copiedLarge(large);
+	EXPECT_TRUE(small == copiedSmall);
+	EXPECT_TRUE(large == copiedLarge);
+	EXPECT_TRUE(small != large);
+
+	copiedLarge[0] = 0x7f;
+	EXPECT_EQ(0, large[0]);
+
+	MidiEvent::Data moved(std::move(copiedLarge));
+	EXPECT_EQ((size_t)100, moved.size());
+	EXPECT_EQ(0x7f, moved[0]);
+	EXPECT_TRUE(copiedLarge.empty());
+
+	MidiEvent::Data assigned;
+	assigned = large;
+	EXPECT_TRUE(assigned == large);
+	assigned = small;
+	EXPECT_TRUE(assigned == small);
+	assigned = std::move(moved);
+	EXPECT_EQ((size_t)100, assigned.size());
+	EXPECT_EQ(0x7f, assigned[0]);
+	assigned = std::move(copiedSmall);
+	EXPECT_TRUE(assigned == small);
+}
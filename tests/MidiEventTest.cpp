@@ -2,6 +2,7 @@
 #include "../include/libvsq/MidiEvent.hpp"
 #include "../include/libvsq/ByteArrayOutputStream.hpp"
 #include "../include/libvsq/InputStream.hpp"
+#include <stdexcept>
 
 using namespace std;
 using namespace vsq;
@@ -222,6 +223,68 @@ TEST(MidiEventTest, testReadDeltaTick)
 	EXPECT_EQ((tick_t)0x1, MidiEvent::readDeltaTick(stream2));
 }
 
+TEST(MidiEventTest, testEncodeDeltaTick)
+{
+	uint8_t buffer[MidiEvent::MAX_DELTA_TICK_BYTES];
+	EXPECT_EQ(1, MidiEvent::encodeDeltaTick(0, buffer));
+	EXPECT_EQ(0x00, buffer[0]);
+
+	EXPECT_EQ(4, MidiEvent::encodeDeltaTick(12345678, buffer));
+	EXPECT_EQ(0x85, buffer[0]);
+	EXPECT_EQ(0xf1, buffer[1]);
+	EXPECT_EQ(0xc2, buffer[2]);
+	EXPECT_EQ(0x4e, buffer[3]);
+
+	EXPECT_EQ(5, MidiEvent::encodeDeltaTick(0x10000000, buffer));
+	EXPECT_EQ(0x81, buffer[0]);
+	EXPECT_EQ(0x80, buffer[1]);
+	EXPECT_EQ(0x80, buffer[2]);
+	EXPECT_EQ(0x80, buffer[3]);
+	EXPECT_EQ(0x00, buffer[4]);
+
+	// writeDeltaTick と同じバイト列になる
+	ByteArrayOutputStream stream;
+	MidiEvent::writeDeltaTick(stream, 0x3fff);
+	EXPECT_EQ(2, MidiEvent::encodeDeltaTick(0x3fff, buffer));
+	EXPECT_EQ(string(reinterpret_cast<char const*>(buffer), 2), stream.toString());
+}
+
+TEST(MidiEventTest, testEncodeAndDecodeDeltaTick)
+{
+	// 28 ビットの範囲の全ての値について, 書き込んだ値が読み込めることを確認する
+	uint8_t buffer[MidiEvent::MAX_DELTA_TICK_BYTES];
+	int expectedLength = 1;
+	for (tick_t value = 0; value < 0x10000000; value++) {
+		if (value == ((tick_t)1 << (7 * expectedLength))) {
+			expectedLength++;
+		}
+		int length = MidiEvent::encodeDeltaTick(value, buffer);
+		tick_t actual = -1;
+		int read = MidiEvent::decodeDeltaTick(buffer, sizeof(buffer), actual);
+		if (length != expectedLength || read != length || actual != value) {
+			EXPECT_EQ(expectedLength, length);
+			EXPECT_EQ(length, read);
+			EXPECT_EQ(value, actual);
+			FAIL() << "value=" << value;
+		}
+	}
+}
+
+TEST(MidiEventTest, testDecodeDeltaTick)
+{
+	tick_t actual = -1;
+	EXPECT_EQ(0, MidiEvent::decodeDeltaTick(nullptr, 0, actual));
+	EXPECT_EQ((tick_t)0, actual);
+
+	uint8_t data[] = { 0x81, 0x00, 0x7f };
+	EXPECT_EQ(2, MidiEvent::decodeDeltaTick(data, sizeof(data), actual));
+	EXPECT_EQ((tick_t)128, actual);
+
+	// 読み込みの途中で終端となる場合
+	EXPECT_EQ(1, MidiEvent::decodeDeltaTick(data, 1, actual));
+	EXPECT_EQ((tick_t)0x1, actual);
+}
+
 TEST(MidiEventTest, testRead)
 {
 	{
@@ -354,3 +417,68 @@ TEST(MidiEventTest, testRead)
 		}
 	}
 }
+
+TEST(MidiEventTest, testReadFromBuffer)
+{
+	// note off, ランニングステータス, 2byte, 1byte, メタイベント, f0 SysEx, f7 SysEx, 末尾で途切れたメタイベント
+	uint8_t data[] = {
+		0x00, 0x81, 0x01, 0x02,
+		0x00, 0x03, 0x04,
+		0x81, 0x00, 0xF3, 0x05,
+		0x02, 0xF6,
+		0x03, 0xFF, 0x06, 0x05, 0x01, 0x02, 0x03, 0x04, 0x05,
+		0x04, 0xF0, 0x03, 0xF0, 0x06, 0x07, 0xF7,
+		0x05, 0xF7, 0x03, 0x08, 0x09, 0x0A,
+		0x06, 0xFF, 0x01, 0x04, 0x41, 0x42,
+	};
+	size_t const length = sizeof(data);
+	MemoryInputStream stream(reinterpret_cast<char*>(data), (int)length);
+	tick_t expectedTick = 0;
+	uint8_t expectedStatus = 0;
+	tick_t actualTick = 0;
+	uint8_t actualStatus = 0;
+	size_t position = 0;
+	int count = 0;
+	while (position < length) {
+		MidiEvent expected = MidiEvent::read(stream, expectedTick, expectedStatus);
+		MidiEvent actual = MidiEvent::read(data, length, position, actualTick, actualStatus);
+		EXPECT_EQ(expectedTick, actualTick);
+		EXPECT_EQ(expectedStatus, actualStatus);
+		EXPECT_EQ(expected.tick, actual.tick);
+		EXPECT_EQ(expected.firstByte, actual.firstByte);
+		EXPECT_TRUE(expected.data == actual.data);
+		EXPECT_EQ(stream.getPointer(), (int64_t)position);
+		++count;
+	}
+	EXPECT_EQ(8, count);
+	EXPECT_EQ(length, position);
+
+	{
+		// 処理できないMIDIイベント
+		uint8_t const invalid[] = { 0x01, 0xF4 };
+		size_t position = 0;
+		tick_t lastTick = 0;
+		uint8_t lastStatus = 0;
+		try {
+			MidiEvent::read(invalid, sizeof(invalid), position, lastTick, lastStatus);
+			GTEST_FAIL(); // 期待した例外がスローされない.
+		} catch (MidiEvent::ParseException& e) {
+			EXPECT_EQ(string("don't know how to process first_byte: 0xF4"), e.message());
+		}
+	}
+}
+
+TEST(MidiEventTest, testDataReserveTooLarge)
+{
+	MidiEvent::Data data;
+	data.push_back(0x01);
+	if (sizeof(size_t) > sizeof(uint32_t)) {
+		// 32 ビットで表せないバイト数は, 切り詰めずに例外とする
+		size_t const size = static_cast<size_t>(UINT32_MAX) + 1;
+		EXPECT_THROW(data.reserve(size), std::length_error);
+		EXPECT_THROW(data.resize(size), std::length_error);
+	}
+	EXPECT_EQ((size_t)1, data.size());
+	EXPECT_EQ(MidiEvent::Data::INLINE_CAPACITY, data.capacity());
+	EXPECT_EQ(0x01, data.data()[0]);
+}
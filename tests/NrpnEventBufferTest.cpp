@@ -0,0 +1,186 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
+#include "../include/libvsq/NrpnEvent.hpp"
+#include "../include/libvsq/ByteArrayOutputStream.hpp"
+
+using namespace std;
+using namespace vsq;
+
+TEST(NrpnEventBufferTest, testAddAndAppend)
+{
+	NrpnEventBuffer buffer;
+	EXPECT_TRUE(buffer.empty());
+
+	buffer.add(1920, MidiParameterType::CVM_NM_DELAY, 0x01, 0x23);
+	buffer.append(MidiParameterType::CVM_NM_NOTE_NUMBER, 60, true);
+	buffer.append(MidiParameterType::CVM_NM_NOTE_DURATION, 0x02, 0x03, true);
+	buffer.add(480, MidiParameterType::CC_E_EXPRESSION, 64);
+	buffer.append(MidiParameterType::CC_E_DELAY, 0x04);
+	EXPECT_EQ(5, buffer.size());
+
+	NrpnEventBuffer::Record const& a = buffer.get(0);
+	EXPECT_EQ((tick_t)1920, a.tick);
+	EXPECT_EQ(MidiParameterType::CVM_NM_DELAY, a.nrpn);
+	EXPECT_EQ(0x01, a.dataMSB);
+	EXPECT_EQ(0x23, a.dataLSB);
+	EXPECT_TRUE(a.hasLSB());
+	EXPECT_FALSE(a.isMSBOmittingRequired());
+	EXPECT_TRUE(a.isGroupHead());
+
+	NrpnEventBuffer::Record const& b = buffer.get(1);
+	EXPECT_EQ((tick_t)1920, b.tick);
+	EXPECT_EQ(MidiParameterType::CVM_NM_NOTE_NUMBER, b.nrpn);
+	EXPECT_EQ(60, b.dataMSB);
+	EXPECT_EQ(0, b.dataLSB);
+	EXPECT_FALSE(b.hasLSB());
+	EXPECT_TRUE(b.isMSBOmittingRequired());
+	EXPECT_FALSE(b.isGroupHead());
+
+	NrpnEventBuffer::Record const& c = buffer.get(2);
+	EXPECT_EQ((tick_t)1920, c.tick);
+	EXPECT_TRUE(c.hasLSB());
+	EXPECT_TRUE(c.isMSBOmittingRequired());
+	EXPECT_FALSE(c.isGroupHead());
+
+	NrpnEventBuffer::Record const& d = buffer.get(3);
+	EXPECT_EQ((tick_t)480, d.tick);
+	EXPECT_TRUE(d.isGroupHead());
+	EXPECT_FALSE(d.hasLSB());
+
+	NrpnEventBuffer::Record const& e = buffer.get(4);
+	EXPECT_EQ((tick_t)480, e.tick);
+	EXPECT_EQ(MidiParameterType::CC_E_DELAY, e.nrpn);
+	EXPECT_FALSE(e.isGroupHead());
+	EXPECT_FALSE(e.isMSBOmittingRequired());
+
+	buffer.clear();
+	EXPECT_TRUE(buffer.empty());
+}
+
+TEST(NrpnEventBufferTest, testSort)
+{
+	// CVM_NM_VELOCITY:          0x5003
+	// CC_CV_VERSION_AND_DEVICE: 0x6100
+	NrpnEventBuffer buffer;
+	buffer.add(1920, MidiParameterType::CVM_NM_DELAY, 0x01, 0x23);
+	buffer.append(MidiParameterType::CVM_NM_VELOCITY, 64, true);
+	buffer.add(480, MidiParameterType::CVM_NM_VELOCITY, 1);
+	buffer.add(480, MidiParameterType::CC_CV_VERSION_AND_DEVICE, 0x00, 0x00);
+	buffer.append(MidiParameterType::CVM_NM_VELOCITY, 2);
+	buffer.add(480, MidiParameterType::CVM_NM_VELOCITY, 3);
+
+	buffer.sort();
+
+	EXPECT_EQ(6, buffer.size());
+	EXPECT_EQ(MidiParameterType::CC_CV_VERSION_AND_DEVICE, buffer.get(0).nrpn);
+	EXPECT_TRUE(buffer.get(0).isGroupHead());
+	EXPECT_EQ(MidiParameterType::CVM_NM_VELOCITY, buffer.get(1).nrpn);
+	EXPECT_EQ(2, buffer.get(1).dataMSB);
+	EXPECT_FALSE(buffer.get(1).isGroupHead());
+	// 同じ順位のグループは元の順序を保つ
+	EXPECT_EQ(1, buffer.get(2).dataMSB);
+	EXPECT_EQ(3, buffer.get(3).dataMSB);
+	EXPECT_EQ((tick_t)1920, buffer.get(4).tick);
+	EXPECT_EQ(MidiParameterType::CVM_NM_DELAY, buffer.get(4).nrpn);
+	EXPECT_EQ(MidiParameterType::CVM_NM_VELOCITY, buffer.get(5).nrpn);
+	EXPECT_FALSE(buffer.get(5).isGroupHead());
+}
+
+TEST(NrpnEventBufferTest, testToList)
+{
+	NrpnEventBuffer buffer;
+	buffer.add(1920, MidiParameterType::CVM_NM_DELAY, 0x01, 0x23);
+	buffer.append(MidiParameterType::CVM_NM_VELOCITY, 0x01, 0x02, true);
+	buffer.append(MidiParameterType::CVM_NM_NOTE_NUMBER, 60);
+	buffer.add(3840, MidiParameterType::CC_E_EXPRESSION, 64);
+
+	vector<NrpnEvent> list = buffer.toList();
+	EXPECT_EQ((size_t)2, list.size());
+	vector<NrpnEvent> expanded = list[0].expand();
+	EXPECT_EQ((size_t)3, expanded.size());
+	EXPECT_EQ(MidiParameterType::CVM_NM_DELAY, expanded[0].nrpn);
+	EXPECT_TRUE(expanded[0].hasLSB);
+	EXPECT_EQ(MidiParameterType::CVM_NM_VELOCITY, expanded[1].nrpn);
+	EXPECT_EQ(0x02, expanded[1].dataLSB);
+	EXPECT_TRUE(expanded[1].isMSBOmittingRequired);
+	EXPECT_EQ(MidiParameterType::CVM_NM_NOTE_NUMBER, expanded[2].nrpn);
+	EXPECT_FALSE(expanded[2].hasLSB);
+	EXPECT_FALSE(expanded[2].isMSBOmittingRequired);
+	EXPECT_EQ((tick_t)3840, list[1].tick);
+	EXPECT_EQ((size_t)1, list[1].expand().size());
+
+	vector<NrpnEvent> flat = buffer.expand();
+	EXPECT_EQ((size_t)4, flat.size());
+	EXPECT_EQ((size_t)1, flat[1].expand().size());
+	EXPECT_EQ((tick_t)1920, flat[2].tick);
+}
+
+TEST(NrpnEventBufferTest, testConvert)
+{
+	NrpnEvent source = NrpnEvent(1920, MidiParameterType::CVM_NM_DELAY, 0x01, 0x23);
+	source.append(MidiParameterType::CVM_NM_VELOCITY, 0x01, 0x02, true);
+	source.append(MidiParameterType::CVM_NM_NOTE_NUMBER, 60);
+
+	NrpnEventBuffer buffer;
+	buffer.add(source);
+	EXPECT_EQ(3, buffer.size());
+
+	vector<MidiEvent> expected = NrpnEvent::convert(source.expand());
+	vector<MidiEvent> actual = NrpnEvent::convert(buffer);
+	EXPECT_EQ((size_t)10, actual.size());
+	EXPECT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++) {
+		EXPECT_EQ(expected[i].tick, actual[i].tick);
+		EXPECT_EQ(expected[i].firstByte, actual[i].firstByte);
+		EXPECT_TRUE(expected[i].data == actual[i].data);
+	}
+
+	EXPECT_TRUE(NrpnEvent::convert(NrpnEventBuffer()).empty());
+}
+
+TEST(NrpnEventBufferTest, testWrite)
+{
+	NrpnEventBuffer buffer;
+	for (int i = 0; i < 1000; i++) {
+		tick_t tick = 480 * (i / 3) + 20000 * (i / 500);
+		buffer.add(tick, MidiParameterType::CVM_NM_VERSION_AND_DEVICE, 0x00, 0x00);
+		buffer.append(MidiParameterType::CVM_NM_DELAY, 0x03, 0x74, true);
+		buffer.append(MidiParameterType::CVM_NM_NOTE_NUMBER, i % 128, true);
+		buffer.append(MidiParameterType::CC_E_EXPRESSION, 64);
+	}
+
+	ByteArrayOutputStream expected;
+	tick_t expectedLastTick = 0;
+	for (MidiEvent const& item : NrpnEvent::convert(buffer)) {
+		MidiEvent::writeDeltaTick(expected, item.tick - expectedLastTick);
+		item.writeData(expected);
+		expectedLastTick = item.tick;
+	}
+
+	ByteArrayOutputStream actual;
+	tick_t actualLastTick = 0;
+	buffer.write(actual, actualLastTick);
+
+	EXPECT_EQ(expectedLastTick, actualLastTick);
+	EXPECT_TRUE(4096 < actual.toString().size());
+	EXPECT_TRUE(expected.toString() == actual.toString());
+}
+
+TEST(NrpnEventBufferTest, testWriteWithRunningStatus)
+{
+	NrpnEventBuffer buffer;
+	buffer.add(0, MidiParameterType::CVM_NM_VERSION_AND_DEVICE, 0x00, 0x00);
+	buffer.append(MidiParameterType::CVM_NM_DELAY, 0x03, 0x74, true);
+	buffer.add(480, MidiParameterType::CC_E_EXPRESSION, 64);
+
+	ByteArrayOutputStream stream;
+	tick_t lastTick = 0;
+	buffer.write(stream, lastTick, true);
+
+	std::string const expected = std::string(
+		"\x00\xB0\x63\x50\x00\x62\x00\x00\x06\x00\x00\x26\x00"
+		"\x00\x62\x01\x00\x06\x03\x00\x26\x74"
+		"\x83\x60\x63\x63\x00\x62\x02\x00\x06\x40", 32);
+	EXPECT_EQ(480, lastTick);
+	EXPECT_TRUE(expected == stream.toString());
+}
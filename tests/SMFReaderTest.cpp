@@ -1,6 +1,8 @@
 ﻿#include "Util.hpp"
 #include "../include/libvsq/SMFReader.hpp"
 #include "../include/libvsq/FileInputStream.hpp"
+#include "../include/libvsq/BitConverter.hpp"
+#include "../include/libvsq/MappedFileInputStream.hpp"
 
 using namespace std;
 using namespace vsq;
@@ -25,3 +27,123 @@ TEST(SMFReaderTest, testRead)
 	EXPECT_EQ(1, format);
 	EXPECT_EQ(480, timeFormat);
 }
+
+TEST(SMFReaderTest, testReadSameAsMidiEventRead)
+{
+	vector<vector<MidiEvent> > actual;
+	int format, timeFormat;
+	{
+		FileInputStream stream("VSQFileWriterTest/expected/expected.vsq");
+		SMFReader reader;
+		reader.read(stream, actual, format, timeFormat);
+		stream.close();
+	}
+
+	// InputStream から 1 イベントずつ読み込んだ結果と比較する
+	FileInputStream stream("VSQFileWriterTest/expected/expected.vsq");
+	stream.seek(14);
+	for (size_t track = 0; track < actual.size(); ++track) {
+		char byte4[4] = { 0 };
+		stream.read(byte4, 0, 4);
+		stream.read(byte4, 0, 4);
+		int64_t size = (int64_t)BitConverter::makeUInt32BE(byte4);
+		int64_t startpos = stream.getPointer();
+		tick_t tick = 0;
+		uint8_t last_status_byte = 0x00;
+		vector<MidiEvent> expected;
+		while (stream.getPointer() < startpos + size) {
+			expected.push_back(MidiEvent::read(stream, tick, last_status_byte));
+		}
+		ASSERT_EQ(expected.size(), actual[track].size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			EXPECT_EQ(expected[i].tick, actual[track][i].tick);
+			EXPECT_EQ(expected[i].firstByte, actual[track][i].firstByte);
+			EXPECT_TRUE(expected[i].data == actual[track][i].data);
+		}
+	}
+	stream.close();
+}
+
+TEST(SMFReaderTest, testReadConcurrently)
+{
+	char const* files[] = {
+		"VSQFileWriterTest/expected/expected.vsq",
+		"VSQFileReaderTest/fixture/fixture.vsq",
+	};
+	for (auto file : files) {
+		vector<vector<MidiEvent> > expected;
+		int expectedFormat, expectedTimeFormat;
+		{
+			FileInputStream stream(file);
+			SMFReader reader;
+			reader.read(stream, expected, expectedFormat, expectedTimeFormat);
+			stream.close();
+		}
+
+		vector<vector<MidiEvent> > actual;
+		int actualFormat, actualTimeFormat;
+		{
+			FileInputStream stream(file);
+			SMFReader reader;
+			EXPECT_FALSE(reader.parallel());
+			reader.parallel(true);
+			EXPECT_TRUE(reader.parallel());
+			reader.read(stream, actual, actualFormat, actualTimeFormat);
+			stream.close();
+		}
+
+		EXPECT_EQ(expectedFormat, actualFormat);
+		EXPECT_EQ(expectedTimeFormat, actualTimeFormat);
+		ASSERT_EQ(expected.size(), actual.size());
+		for (size_t track = 0; track < expected.size(); ++track) {
+			ASSERT_EQ(expected[track].size(), actual[track].size());
+			for (size_t i = 0; i < expected[track].size(); ++i) {
+				EXPECT_EQ(expected[track][i].tick, actual[track][i].tick);
+				EXPECT_EQ(expected[track][i].firstByte, actual[track][i].firstByte);
+				EXPECT_TRUE(expected[track][i].data == actual[track][i].data);
+			}
+		}
+	}
+}
+
+TEST(SMFReaderTest, testReadMappedFile)
+{
+	char const* files[] = {
+		"VSQFileWriterTest/expected/expected.vsq",
+		"VSQFileReaderTest/fixture/fixture.vsq",
+	};
+	for (auto file : files) {
+		vector<vector<MidiEvent> > expected;
+		int expectedFormat, expectedTimeFormat;
+		{
+			FileInputStream stream(file);
+			SMFReader reader;
+			reader.read(stream, expected, expectedFormat, expectedTimeFormat);
+			stream.close();
+		}
+
+		for (int parallel = 0; parallel < 2; parallel++) {
+			vector<vector<MidiEvent> > actual;
+			int actualFormat, actualTimeFormat;
+			MappedFileInputStream stream(file);
+			ASSERT_TRUE(stream.data() != nullptr);
+			SMFReader reader;
+			reader.parallel(parallel == 1);
+			reader.read(stream, actual, actualFormat, actualTimeFormat);
+			EXPECT_EQ(stream.length(), stream.getPointer());
+			stream.close();
+
+			EXPECT_EQ(expectedFormat, actualFormat);
+			EXPECT_EQ(expectedTimeFormat, actualTimeFormat);
+			ASSERT_EQ(expected.size(), actual.size());
+			for (size_t track = 0; track < expected.size(); ++track) {
+				ASSERT_EQ(expected[track].size(), actual[track].size());
+				for (size_t i = 0; i < expected[track].size(); ++i) {
+					EXPECT_EQ(expected[track][i].tick, actual[track][i].tick);
+					EXPECT_EQ(expected[track][i].firstByte, actual[track][i].firstByte);
+					EXPECT_TRUE(expected[track][i].data == actual[track][i].data);
+				}
+			}
+		}
+	}
+}
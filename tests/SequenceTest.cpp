@@ -125,6 +125,16 @@ TEST(SequenceTest, testUpdateTotalTicks)
 	EXPECT_EQ((tick_t)2400, sequence.totalTicks());
 }
 
+TEST(SequenceTest, testCalculateTotalTicks)
+{
+	Sequence sequence("Miku", 1, 4, 4, 500000);
+	sequence.track(0).curve("pit")->add(3840, 100);
+
+	// 計算結果を返すだけで, totalTicks の値は更新しない
+	EXPECT_EQ((tick_t)3840, sequence.calculateTotalTicks());
+	EXPECT_EQ((tick_t)1920, sequence.totalTicks());
+}
+
 TEST(SequenceTest, testGetMaximumNoteLengthAt)
 {
 	//    fail();
@@ -145,3 +155,37 @@ TEST(SequenceTest, testGenerateNRPNPartial)
 {
 	//    fail();
 }
+
+TEST(SequenceTest, testSetTrackLoaders)
+{
+	Sequence sequence("Miku", 1, 4, 4, 500000);
+	int calls = 0;
+	vector<Track> placeholders;
+	placeholders.push_back(Track("Track1", "Foo"));
+	placeholders.push_back(Track("Track2", "Bar"));
+	vector<function<Track()>> loaders;
+	loaders.push_back([&calls]() {
+		calls++;
+		Track track("Track1", "Foo");
+		track.events().add(Event(1920, EventType::NOTE));
+		return track;
+	});
+	loaders.push_back(function<Track()>());
+	sequence.setTrackLoaders(placeholders, loaders, 7680);
+
+	// 仮のトラックの内容は, 読み込まずに取得できる
+	EXPECT_EQ(2, sequence.trackCount());
+	EXPECT_EQ(string("Track1"), sequence.trackName(0));
+	EXPECT_EQ(string("Foo"), sequence.trackSinger(0));
+	EXPECT_EQ(string("Bar"), sequence.trackSinger(1));
+	EXPECT_EQ((tick_t)7680, sequence.totalTicks());
+	EXPECT_FALSE(sequence.isTrackLoaded(0));
+	EXPECT_TRUE(sequence.isTrackLoaded(1));
+	EXPECT_EQ(0, calls);
+
+	// 参照した時に一度だけ読み込まれる
+	EXPECT_EQ(2, sequence.track(0).events().size());
+	EXPECT_EQ(2, sequence.track(0).events().size());
+	EXPECT_TRUE(sequence.isTrackLoaded(0));
+	EXPECT_EQ(1, calls);
+}
@@ -67,6 +67,21 @@ TEST(StringUtilTest, testParseInt)
 	}
 }
 
+TEST(StringUtilTest, testParseIntRange)
+{
+	string const text = " -12=34";
+	EXPECT_EQ(-12, StringUtil::parseInt<int>(text.data(), text.data() + text.size()));
+	EXPECT_EQ(34, StringUtil::parseInt<int>(text.data() + 5, text.data() + text.size()));
+	EXPECT_EQ(3, StringUtil::parseInt<int>(text.data() + 5, text.data() + 6));
+	EXPECT_EQ(0x34, StringUtil::parseInt<int>(text.data() + 5, text.data() + 7, 16));
+	try {
+		StringUtil::parseInt<int>(text.data() + 4, text.data() + 5);
+		GTEST_FAIL(); // 期待した例外がスローされない.
+	} catch (StringUtil::IntegerParseException& e) {
+		// 成功
+	}
+}
+
 TEST(StringUtilTest, testParseFloat)
 {
 	EXPECT_EQ(1.0, StringUtil::parseFloat<double>("1.0"));
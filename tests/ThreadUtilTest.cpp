@@ -0,0 +1,46 @@
+﻿#include "Util.hpp"
+#include "../include/libvsq/ThreadUtil.hpp"
+#include <atomic>
+#include <stdexcept>
+
+using namespace std;
+using namespace vsq;
+
+TEST(ThreadUtilTest, testRunConcurrently)
+{
+	int const count = 100;
+	vector<atomic<int>> calls(count);
+	for (auto& item : calls) {
+		item = 0;
+	}
+	ThreadUtil::runConcurrently(count, [&](int index) {
+		calls[index]++;
+	});
+	for (int i = 0; i < count; ++i) {
+		EXPECT_EQ(1, calls[i].load());
+	}
+
+	// count が 0 の場合は何もしない
+	ThreadUtil::runConcurrently(0, [&](int) {
+		FAIL();
+	});
+}
+
+TEST(ThreadUtilTest, testRunConcurrentlyRethrowsFirstError)
+{
+	int const count = 10;
+	atomic<int> finished(0);
+	try {
+		ThreadUtil::runConcurrently(count, [&](int index) {
+			if (index % 3 == 2) {
+				throw runtime_error(to_string(index));
+			}
+			finished++;
+		});
+		FAIL();
+	} catch (runtime_error const& e) {
+		// 例外を投げなかった task は全て実行され, 番号が最も小さいものの例外が再送出される
+		EXPECT_EQ(string("2"), string(e.what()));
+		EXPECT_EQ(7, finished.load());
+	}
+}
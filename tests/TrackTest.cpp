@@ -390,6 +390,30 @@ TEST(TrackTest, testClone)
 	EXPECT_EQ(string("DummyTrackName"), copy.name());
 }
 
+TEST(TrackTest, testMove)
+{
+	Track track("DummyTrackName", "DummySingerName");
+	Event event(480, EventType::NOTE);
+	track.events().add(event);
+	track.curve("pit")->add(480, 100);
+	Event const* note = track.events().get(1);
+	BPList const* pit = track.curve("pit");
+
+	// ムーブではイベントとカーブが複製されず, そのまま引き継がれる
+	Track moved(std::move(track));
+	EXPECT_EQ(2, moved.events().size());
+	EXPECT_EQ(note, moved.events().get(1));
+	EXPECT_EQ(pit, moved.curve("pit"));
+	EXPECT_EQ(string("DummyTrackName"), moved.name());
+
+	Track assigned;
+	assigned = std::move(moved);
+	EXPECT_EQ(2, assigned.events().size());
+	EXPECT_EQ(note, assigned.events().get(1));
+	EXPECT_EQ(pit, assigned.curve("pit"));
+	EXPECT_EQ(string("DummyTrackName"), assigned.name());
+}
+
 /**
 	* @todo
 	*/
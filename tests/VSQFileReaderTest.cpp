@@ -1,8 +1,15 @@
 ﻿#include "Util.hpp"
 #include "../include/libvsq/VSQFileReader.hpp"
+#include "../include/libvsq/VSQContentHandler.hpp"
 #include "../include/libvsq/FileInputStream.hpp"
 #include "../include/libvsq/TextStream.hpp"
 #include "../include/libvsq/Sequence.hpp"
+#include "../include/libvsq/VSQFileWriter.hpp"
+#include "../include/libvsq/FileOutputStream.hpp"
+#include "../include/libvsq/ByteArrayOutputStream.hpp"
+#include "../include/libvsq/ByteArrayInputStream.hpp"
+#include <cstdio>
+#include <map>
 
 using namespace std;
 using namespace vsq;
@@ -266,6 +273,391 @@ TEST(VSQFileReaderTest, testRead)
 	* 歌詞ハンドルの読み込みテスト
 	* EOFで読み込みが終了する場合
 	*/
+static string writeToString(Sequence const& sequence)
+{
+	VSQFileWriter writer;
+	ByteArrayOutputStream stream;
+	writer.write(sequence, stream, 500, "Shift_JIS", false);
+	return stream.toString();
+}
+
+TEST(VSQFileReaderTest, testReadLazily)
+{
+	// 3 トラックのファイルを用意する
+	{
+		Sequence source;
+		VSQFileReader reader;
+		FileInputStream stream("VSQFileReaderTest/fixture/fixture.vsq");
+		reader.read(source, stream, "Shift_JIS");
+		stream.close();
+		for (int i = 0; i < 2; i++) {
+			Track track = source.track(0).clone();
+			track.name(i == 0 ? "Track2" : "Track3");
+			track.events().add(Event(1920 * (i + 2), EventType::NOTE));
+			source.tracks().push_back(track);
+		}
+		source.updateTotalTicks();
+		FileOutputStream output("VSQFileReaderTest_testReadLazily.vsq");
+		VSQFileWriter writer;
+		writer.write(source, output, 500, "Shift_JIS", false);
+	}
+
+	Sequence expected;
+	{
+		VSQFileReader reader;
+		FileInputStream stream("VSQFileReaderTest_testReadLazily.vsq");
+		reader.read(expected, stream, "Shift_JIS");
+	}
+
+	Sequence actual;
+	{
+		VSQFileReader reader;
+		EXPECT_FALSE(reader.lazy());
+		reader.lazy(true);
+		EXPECT_TRUE(reader.lazy());
+		FileInputStream stream("VSQFileReaderTest_testReadLazily.vsq");
+		reader.read(actual, stream, "Shift_JIS");
+	}
+	Sequence parallel;
+	{
+		VSQFileReader reader;
+		reader.lazy(true);
+		reader.parallel(true);
+		FileInputStream stream("VSQFileReaderTest_testReadLazily.vsq");
+		reader.read(parallel, stream, "Shift_JIS");
+	}
+	remove("VSQFileReaderTest_testReadLazily.vsq");
+
+	// read の時点では, トラックは読み込まれていない
+	ASSERT_EQ(3, actual.trackCount());
+	for (int i = 0; i < 3; i++) {
+		EXPECT_FALSE(actual.isTrackLoaded(i));
+		EXPECT_EQ(expected.track(i).name(), actual.trackName(i));
+	}
+	EXPECT_EQ(expected.master.preMeasure, actual.master.preMeasure);
+	EXPECT_EQ(expected.mixer.masterFeder, actual.mixer.masterFeder);
+	EXPECT_EQ(expected.mixer.masterPanpot, actual.mixer.masterPanpot);
+	EXPECT_EQ(expected.mixer.masterMute, actual.mixer.masterMute);
+	EXPECT_EQ(expected.mixer.outputMode, actual.mixer.outputMode);
+	EXPECT_EQ(expected.mixer.slave.size(), actual.mixer.slave.size());
+	EXPECT_EQ(expected.tempoList.size(), actual.tempoList.size());
+	EXPECT_EQ(expected.timesigList.size(), actual.timesigList.size());
+
+	// 曲の長さと歌手名は, トラックを読み込まずに取得できる
+	EXPECT_EQ(expected.totalTicks(), actual.totalTicks());
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(expected.trackSinger(i), actual.trackSinger(i));
+		EXPECT_FALSE(actual.isTrackLoaded(i));
+	}
+	EXPECT_EQ(string("Foo"), actual.trackSinger(0));
+	EXPECT_EQ(expected.totalTicks(), parallel.totalTicks());
+	EXPECT_EQ(writeToString(expected), writeToString(parallel));
+
+	// 参照したトラックだけが読み込まれる
+	Sequence copy = actual.clone();
+	EXPECT_EQ(expected.track(1).events().size(), actual.track(1).events().size());
+	EXPECT_FALSE(actual.isTrackLoaded(0));
+	EXPECT_TRUE(actual.isTrackLoaded(1));
+	EXPECT_FALSE(actual.isTrackLoaded(2));
+	EXPECT_FALSE(copy.isTrackLoaded(1));
+
+	// 全てのトラックを読み込んだ結果は, 遅延読み込みしない場合と同じになる
+	EXPECT_EQ((size_t)3, actual.tracks().size());
+	for (int i = 0; i < 3; i++) {
+		EXPECT_TRUE(actual.isTrackLoaded(i));
+	}
+	EXPECT_EQ(expected.totalTicks(), actual.totalTicks());
+	EXPECT_EQ(writeToString(expected), writeToString(actual));
+	EXPECT_EQ(expected.totalTicks(), copy.totalTicks());
+	EXPECT_EQ(writeToString(expected), writeToString(copy));
+}
+
+TEST(VSQFileReaderTest, testReadFromByteArrayInputStream)
+{
+	Sequence expected;
+	{
+		VSQFileReader reader;
+		FileInputStream stream("VSQFileReaderTest/fixture/fixture.vsq");
+		reader.read(expected, stream, "Shift_JIS");
+	}
+
+	string content = writeToString(expected);
+	Sequence actual;
+	{
+		VSQFileReader reader;
+		ByteArrayInputStream stream(content.data(), content.size());
+		reader.read(actual, stream, "Shift_JIS");
+		EXPECT_EQ((int64_t)content.size(), stream.getPointer());
+	}
+	EXPECT_EQ(content, writeToString(actual));
+}
+
+TEST(VSQFileReaderTest, testReadConcurrently)
+{
+	// 4 トラックのファイルを用意する
+	string content;
+	{
+		Sequence source;
+		VSQFileReader reader;
+		FileInputStream stream("VSQFileReaderTest/fixture/fixture.vsq");
+		reader.read(source, stream, "Shift_JIS");
+		for (int i = 0; i < 3; i++) {
+			Track track = source.track(0).clone();
+			track.name(i == 0 ? "Track2" : (i == 1 ? "Track3" : "Track4"));
+			track.events().add(Event(1920 * (i + 2), EventType::NOTE));
+			source.tracks().push_back(track);
+		}
+		source.updateTotalTicks();
+		content = writeToString(source);
+	}
+
+	Sequence expected;
+	{
+		VSQFileReader reader;
+		ByteArrayInputStream stream(content.data(), content.size());
+		reader.read(expected, stream, "Shift_JIS");
+	}
+
+	Sequence actual;
+	{
+		VSQFileReader reader;
+		EXPECT_FALSE(reader.parallel());
+		reader.parallel(true);
+		EXPECT_TRUE(reader.parallel());
+		ByteArrayInputStream stream(content.data(), content.size());
+		reader.read(actual, stream, "Shift_JIS");
+	}
+
+	ASSERT_EQ(4, actual.trackCount());
+	EXPECT_EQ(string("Track4"), actual.track(3).name());
+	EXPECT_EQ(expected.master.preMeasure, actual.master.preMeasure);
+	EXPECT_EQ(expected.mixer.slave.size(), actual.mixer.slave.size());
+	EXPECT_EQ(expected.totalTicks(), actual.totalTicks());
+	EXPECT_EQ(content, writeToString(actual));
+}
+
+TEST(VSQFileReaderTest, testReadWithOptions)
+{
+	string content;
+	{
+		Sequence source("Foo", 1, 4, 4, 500000);
+		Event note(480, EventType::NOTE);
+		note.note = 60;
+		note.length(480);
+		note.lyricHandle = Handle(HandleType::LYRIC);
+		note.lyricHandle.set(0, Lyric("あ", "a"));
+		note.vibratoHandle = Handle(HandleType::VIBRATO);
+		note.vibratoHandle.iconId = "$04040004";
+		note.vibratoHandle.ids = "vibrato";
+		note.vibratoHandle.length(407);
+		note.vibratoHandle.startDepth = 13;
+		note.vibratoHandle.startRate = 14;
+		note.noteHeadHandle = Handle(HandleType::NOTE_HEAD);
+		note.noteHeadHandle.iconId = "$05030000";
+		note.noteHeadHandle.ids = "attack";
+		note.noteHeadHandle.duration = 62;
+		source.track(0).events().add(note);
+		source.track(0).curve("PIT")->add(1920, 100);
+		source.track(0).curve("DYN")->add(1920, 32);
+		Track track = source.track(0).clone();
+		track.name("Track2");
+		source.tracks().push_back(track);
+		source.updateTotalTicks();
+		content = writeToString(source);
+	}
+
+	VSQFileReader::Options options;
+	EXPECT_FALSE(options.skipVibratoHandles);
+	EXPECT_FALSE(options.skipNoteHeadHandles);
+	options.skipCurves.insert("pit");
+	options.skipVibratoHandles = true;
+	options.skipNoteHeadHandles = true;
+	options.tracks.insert(0);
+
+	for (int lazy = 0; lazy < 2; lazy++) {
+		Sequence actual;
+		VSQFileReader reader;
+		reader.lazy(lazy == 1);
+		reader.options(options);
+		EXPECT_EQ(options.tracks, reader.options().tracks);
+		ByteArrayInputStream stream(content.data(), content.size());
+		reader.read(actual, stream, "Shift_JIS");
+
+		ASSERT_EQ(2, actual.trackCount());
+		Track const& first = actual.track(0);
+		ASSERT_EQ(2, first.events().size());
+		Event const* item = first.events().get(1);
+		EXPECT_EQ(EventType::NOTE, item->type());
+		EXPECT_EQ(string("あ"), item->lyricHandle.get(0).phrase);
+		EXPECT_EQ(HandleType::UNKNOWN, item->vibratoHandle.type());
+		EXPECT_EQ(HandleType::UNKNOWN, item->noteHeadHandle.type());
+		EXPECT_EQ(0, first.curve("PIT")->size());
+		EXPECT_EQ(1, first.curve("DYN")->size());
+
+		// 読み込み対象外のトラックは, 名前だけが読み込まれる
+		Track const& second = actual.track(1);
+		EXPECT_EQ(string("Track2"), second.name());
+		EXPECT_EQ(Track().events().size(), second.events().size());
+		EXPECT_EQ(0, second.curve("DYN")->size());
+	}
+}
+
+class CountingContentHandler : public VSQContentHandler
+{
+public:
+	vector<Tempo> tempos;
+	vector<Timesig> timesigs;
+	vector<string> trackNames;
+	vector<int> endedTracks;
+	int masterCount;
+	int mixerCount;
+	map<int, vector<Event>> events;
+	map<int, int> handles;
+	map<int, map<string, int>> curvePoints;
+
+	CountingContentHandler()
+		: masterCount(0)
+		, mixerCount(0)
+	{}
+
+	void tempo(Tempo const& tempo) override
+	{
+		tempos.push_back(tempo);
+	}
+
+	void timesig(Timesig const& timesig) override
+	{
+		timesigs.push_back(timesig);
+	}
+
+	void startTrack(int track, string const& name) override
+	{
+		EXPECT_EQ((int)trackNames.size(), track);
+		trackNames.push_back(name);
+	}
+
+	void endTrack(int track) override
+	{
+		endedTracks.push_back(track);
+	}
+
+	void master(Master const& master) override
+	{
+		masterCount++;
+	}
+
+	void mixer(Mixer const& mixer) override
+	{
+		mixerCount++;
+	}
+
+	void event(int track, int id, Event& item, int singerHandleIndex, int lyricHandleIndex, int vibratoHandleIndex, int noteHeadHandleIndex) override
+	{
+		events[track].push_back(item);
+	}
+
+	void handle(int track, int index, Handle& item) override
+	{
+		handles[track]++;
+	}
+
+	void curvePoint(int track, string const& curveName, tick_t tick, int value) override
+	{
+		curvePoints[track][curveName]++;
+	}
+};
+
+TEST(VSQFileReaderTest, testReadWithContentHandler)
+{
+	string content;
+	Sequence expected;
+	{
+		VSQFileReader reader;
+		FileInputStream stream("VSQFileReaderTest/fixture/fixture.vsq");
+		reader.read(expected, stream, "Shift_JIS");
+		Track track = expected.track(0).clone();
+		track.name("Track2");
+		expected.tracks().push_back(track);
+		content = writeToString(expected);
+	}
+
+	CountingContentHandler handler;
+	{
+		VSQFileReader reader;
+		ByteArrayInputStream stream(content.data(), content.size());
+		reader.read(stream, handler, "Shift_JIS");
+	}
+
+	ASSERT_EQ(expected.tempoList.size(), (int)handler.tempos.size());
+	for (int i = 0; i < expected.tempoList.size(); i++) {
+		EXPECT_EQ(expected.tempoList.get(i).tick, handler.tempos[i].tick);
+		EXPECT_EQ(expected.tempoList.get(i).tempo, handler.tempos[i].tempo);
+	}
+	ASSERT_EQ(expected.timesigList.size(), (int)handler.timesigs.size());
+	for (int i = 0; i < expected.timesigList.size(); i++) {
+		EXPECT_EQ(expected.timesigList.get(i).barCount, handler.timesigs[i].barCount);
+		EXPECT_EQ(expected.timesigList.get(i).numerator, handler.timesigs[i].numerator);
+	}
+
+	ASSERT_EQ(2, (int)handler.trackNames.size());
+	EXPECT_EQ(string("Track2"), handler.trackNames[1]);
+	EXPECT_EQ(vector<int>({0, 1}), handler.endedTracks);
+	EXPECT_EQ(1, handler.masterCount);
+	EXPECT_EQ(1, handler.mixerCount);
+
+	for (int i = 0; i < 2; i++) {
+		Track const& track = expected.track(i);
+		vector<Event> const& actualEvents = handler.events[i];
+		ASSERT_EQ(track.events().size(), (int)actualEvents.size());
+		for (int j = 0; j < track.events().size(); j++) {
+			Event const* item = track.events().get(j);
+			EXPECT_EQ(item->tick, actualEvents[j].tick);
+			EXPECT_EQ(item->type(), actualEvents[j].type());
+			EXPECT_EQ(item->note, actualEvents[j].note);
+		}
+		EXPECT_LT(0, handler.handles[i]);
+		EXPECT_EQ(track.curve("pit")->size(), handler.curvePoints[i]["pit"]);
+		EXPECT_EQ(track.curve("dyn")->size(), handler.curvePoints[i]["dyn"]);
+	}
+}
+
+TEST(VSQFileReaderTest, testReadLargeTrack)
+{
+	// メタテキストが多数のテキストイベントに分割されるトラック. 全角文字が分割位置をまたぐ場合も含む
+	char const* lyrics[] = { "あ", "は", "ら", "わ", "a" };
+	char const* symbols[] = { "a", "h a", "4 a", "w a", "a" };
+	Sequence expected("Foo", 1, 4, 4, 500000);
+	for (int i = 0; i < 1000; i++) {
+		Event note(1920 + i * 240, EventType::NOTE);
+		note.note = 60 + i % 12;
+		note.length(240);
+		note.lyricHandle = Handle(HandleType::LYRIC);
+		note.lyricHandle.set(0, Lyric(lyrics[i % 5], symbols[i % 5]));
+		expected.track(0).events().add(note);
+		expected.track(0).curve("DYN")->add(1920 + i * 240, i % 128);
+	}
+	expected.updateTotalTicks();
+	string content = writeToString(expected);
+
+	Sequence actual;
+	VSQFileReader reader;
+	ByteArrayInputStream stream(content.data(), content.size());
+	reader.read(actual, stream, "Shift_JIS");
+
+	ASSERT_EQ(expected.track(0).events().size(), actual.track(0).events().size());
+	for (int i = 0; i < expected.track(0).events().size(); i++) {
+		Event const* e = expected.track(0).events().get(i);
+		Event const* a = actual.track(0).events().get(i);
+		EXPECT_EQ(e->tick, a->tick);
+		EXPECT_EQ(e->type(), a->type());
+		if (e->type() == EventType::NOTE) {
+			EXPECT_EQ(e->lyricHandle.get(0).phrase, a->lyricHandle.get(0).phrase);
+			EXPECT_EQ(e->lyricHandle.get(0).phoneticSymbol(), a->lyricHandle.get(0).phoneticSymbol());
+		}
+	}
+	EXPECT_EQ(content, writeToString(actual));
+}
+
 TEST(VSQFileReaderTest, testConstructLyricFromTextStreamStopWithEOF)
 {
 	TextStream stream;
@@ -327,6 +719,46 @@ TEST(VSQFileReaderTest, testConstructLyricFromTextStreamStopWithNextHandle)
 	EXPECT_EQ(string("[h#0002]"), lastLine);
 }
 
+/**
+	* 歌詞ハンドルの読み込みテスト
+	* 引用符で囲まれた歌詞, 発音記号を含む場合
+	*/
+TEST(VSQFileReaderTest, testConstructLyricFromTextStreamWithQuotes)
+{
+	TextStream stream;
+	stream.writeLine("L0=\"a,b\",\"k  a\",0.5,64,0,1");
+	stream.writeLine("L1=\"\",\"\"\"\",1.0");
+	stream.writeLine("L2=\"x\"\"y\",\\\\\\\\n,0.25,1");
+	stream.setPointer(-1);
+	string lastLine = "";
+
+	VSQFileReader reader;
+	Handle handle = reader.parseHandle(stream, 0, lastLine);
+	EXPECT_EQ(HandleType::LYRIC, handle.type());
+	ASSERT_EQ(3, handle.size());
+
+	Lyric lyric0 = handle.get(0);
+	EXPECT_EQ(string("a,b"), lyric0.phrase);
+	EXPECT_EQ(string("k a"), lyric0.phoneticSymbol());
+	EXPECT_EQ(0.5, lyric0.lengthRatio);
+	EXPECT_EQ(string("64,0"), lyric0.consonantAdjustment());
+	EXPECT_TRUE(lyric0.isProtected);
+
+	Lyric lyric1 = handle.get(1);
+	EXPECT_EQ(string("a"), lyric1.phrase);
+	EXPECT_EQ(string("\"\""), lyric1.phoneticSymbol());
+	EXPECT_EQ(1.0, lyric1.lengthRatio);
+	EXPECT_EQ(string("0"), lyric1.consonantAdjustment());
+	EXPECT_FALSE(lyric1.isProtected);
+
+	Lyric lyric2 = handle.get(2);
+	EXPECT_EQ(string("x\"y"), lyric2.phrase);
+	EXPECT_EQ(string("\\n"), lyric2.phoneticSymbol());
+	EXPECT_EQ(0.25, lyric2.lengthRatio);
+	EXPECT_EQ(string("1"), lyric2.consonantAdjustment());
+	EXPECT_FALSE(lyric2.isProtected);
+}
+
 TEST(VSQFileReaderTest, testConstructVibratoFromTextStream)
 {
 	TextStream stream;
@@ -468,3 +900,44 @@ TEST(VSQFileReaderTest, testParseEvent)
 	EXPECT_EQ(3, vibratoHandleIndex);
 	EXPECT_EQ(4, noteHeadHandleIndex);
 }
+
+static int replaceAll(string& text, string const& search, string const& replace)
+{
+	int count = 0;
+	string::size_type position = text.find(search);
+	while (position != string::npos) {
+		text.replace(position, search.size(), replace);
+		count++;
+		position = text.find(search, position + replace.size());
+	}
+	return count;
+}
+
+TEST(VSQFileReaderTest, testReadWithSparseSectionNumbers)
+{
+	Sequence expected("Miku", 1, 4, 4, 500000);
+	{
+		Event note(480, EventType::NOTE);
+		note.note = 60;
+		note.length(480);
+		note.lyricHandle = Handle(HandleType::LYRIC);
+		note.lyricHandle.set(0, Lyric("あ", "a"));
+		// 置き換え対象の文字列が DM:nnnn: のチャンクの境目にかからない長さにしておく
+		expected.track(0).name("V");
+		expected.track(0).events().add(note);
+		expected.updateTotalTicks();
+	}
+
+	// 同じ桁数の, 飛び飛びの番号に置き換える
+	string content = writeToString(expected);
+	EXPECT_EQ(2, replaceAll(content, "ID#0001", "ID#9999"));
+	EXPECT_EQ(2, replaceAll(content, "h#0001", "h#9999"));
+
+	Sequence actual;
+	{
+		VSQFileReader reader;
+		ByteArrayInputStream stream(content.data(), content.size());
+		reader.read(actual, stream, "Shift_JIS");
+	}
+	EXPECT_EQ(writeToString(expected), writeToString(actual));
+}
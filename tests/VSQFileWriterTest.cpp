@@ -4,7 +4,11 @@
 #include "../include/libvsq/Sequence.hpp"
 #include "../include/libvsq/TextStream.hpp"
 #include "../include/libvsq/StringUtil.hpp"
+#include "../include/libvsq/SMFReader.hpp"
+#include "../include/libvsq/FileOutputStream.hpp"
+#include "../include/libvsq/FileInputStream.hpp"
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 using namespace vsq;
@@ -158,6 +162,104 @@ TEST(VSQFileWriterTest, testWriteWithoutPitch)
 	EXPECT_TRUE(expected == actual);
 }
 
+TEST(VSQFileWriterTest, testWriteParallel)
+{
+	Sequence sequence("Foo", 1, 4, 4, 500000);
+	for (int i = 0; i < 4; i++) {
+		std::ostringstream name;
+		name << "Track" << (i + 2);
+		sequence.tracks().push_back(Track(name.str(), "Miku"));
+	}
+	for (int i = 0; i < sequence.tracks().size(); i++) {
+		Track& track = sequence.track(i);
+		for (int j = 0; j < 8; j++) {
+			Event noteEvent(1920 + j * 480, EventType::NOTE);
+			noteEvent.note = 60 + i + j;
+			noteEvent.length(480);
+			noteEvent.lyricHandle = getLyricHandle();
+			track.events().add(noteEvent);
+			track.curve("DYN")->add(1920 + j * 480, 64 + i + j);
+			track.curve("PIT")->add(1920 + j * 480, 100 * j);
+		}
+	}
+
+	VSQFileWriter writer;
+	EXPECT_FALSE(writer.parallel());
+
+	ByteArrayOutputStream expected;
+	writer.write(sequence, expected, 500, "Shift_JIS", false);
+
+	writer.parallel(true);
+	EXPECT_TRUE(writer.parallel());
+	ByteArrayOutputStream actual;
+	writer.write(sequence, actual, 500, "Shift_JIS", false);
+
+	EXPECT_EQ(expected.toString(), actual.toString());
+}
+
+TEST(VSQFileWriterTest, testWriteWithRunningStatus)
+{
+	Sequence sequence("Foo", 1, 4, 4, 500000);
+	for (int i = 0; i < 8; i++) {
+		Event noteEvent(1920 + i * 480, EventType::NOTE);
+		noteEvent.note = 60 + i;
+		noteEvent.length(480);
+		noteEvent.lyricHandle = getLyricHandle();
+		sequence.track(0).events().add(noteEvent);
+		sequence.track(0).curve("DYN")->add(1920 + i * 480, 64 + i);
+	}
+
+	VSQFileWriter writer;
+	EXPECT_FALSE(writer.runningStatus());
+	{
+		FileOutputStream stream("VSQFileWriterTest_withoutRunningStatus.vsq");
+		writer.write(sequence, stream, 500, "Shift_JIS", false);
+	}
+	writer.runningStatus(true);
+	EXPECT_TRUE(writer.runningStatus());
+	{
+		FileOutputStream stream("VSQFileWriterTest_withRunningStatus.vsq");
+		writer.write(sequence, stream, 500, "Shift_JIS", false);
+	}
+
+	SMFReader reader;
+	vector<vector<MidiEvent>> expected;
+	vector<vector<MidiEvent>> actual;
+	int format, timeFormat;
+	{
+		FileInputStream stream("VSQFileWriterTest_withoutRunningStatus.vsq");
+		reader.read(stream, expected, format, timeFormat);
+	}
+	{
+		FileInputStream stream("VSQFileWriterTest_withRunningStatus.vsq");
+		reader.read(stream, actual, format, timeFormat);
+	}
+	EXPECT_EQ(1, format);
+	EXPECT_EQ(480, timeFormat);
+
+	ASSERT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++) {
+		ASSERT_EQ(expected[i].size(), actual[i].size());
+		for (int j = 0; j < expected[i].size(); j++) {
+			EXPECT_EQ(expected[i][j].tick, actual[i][j].tick);
+			EXPECT_EQ(expected[i][j].firstByte, actual[i][j].firstByte);
+			EXPECT_TRUE(expected[i][j].data == actual[i][j].data);
+		}
+	}
+
+	FILE* withoutRunningStatus = fopen("VSQFileWriterTest_withoutRunningStatus.vsq", "rb");
+	FILE* withRunningStatus = fopen("VSQFileWriterTest_withRunningStatus.vsq", "rb");
+	fseek(withoutRunningStatus, 0, SEEK_END);
+	fseek(withRunningStatus, 0, SEEK_END);
+	long expectedLength = ftell(withoutRunningStatus);
+	long actualLength = ftell(withRunningStatus);
+	fclose(withoutRunningStatus);
+	fclose(withRunningStatus);
+	EXPECT_TRUE(actualLength < expectedLength);
+	remove("VSQFileWriterTest_withoutRunningStatus.vsq");
+	remove("VSQFileWriterTest_withRunningStatus.vsq");
+}
+
 /**
  * @todo
  */
@@ -197,6 +299,31 @@ TEST(VSQFileWriterTest, test_getMidiEventsFromMetaText)
 	EXPECT_EQ(string("DM:0001:") + (char)0xA0 + StringUtil::repeat("b", 63), actual.str());
 }
 
+TEST(VSQFileWriterTest, test_getMidiEventsFromMetaTextWithManyLines)
+{
+	TextStream stream;
+	stream.writeLine("abc");
+	stream.writeLine("def");
+	VSQFileWriter writer;
+	vector<MidiEvent> events = writer._getMidiEventsFromMetaText(&stream, "Shift_JIS");
+	ASSERT_EQ((size_t)1, events.size());
+	string actual(events[0].data.begin() + 1, events[0].data.end());
+	EXPECT_EQ(string("DM:0000:abc\ndef"), actual);
+
+	// 10000 個目のイベントから, 番号が 8 桁になる
+	int const count = 10000;
+	TextStream large;
+	large.write(StringUtil::repeat("x", 119 * count + 10));
+	events = writer._getMidiEventsFromMetaText(&large, "Shift_JIS");
+	ASSERT_EQ((size_t)count + 1, events.size());
+	EXPECT_EQ((size_t)128, events[count - 1].data.size());
+	actual.assign(events[count - 1].data.begin() + 1, events[count - 1].data.begin() + 9);
+	EXPECT_EQ(string("DM:9999:"), actual);
+	EXPECT_EQ((size_t)1 + 12 + 10, events[count].data.size());
+	actual.assign(events[count].data.begin() + 1, events[count].data.end());
+	EXPECT_EQ(string("DM:00010000:") + StringUtil::repeat("x", 10), actual);
+}
+
 TEST(VSQFileWriterTest, test_getLinePrefixBytes)
 {
 	VSQFileWriter writer;
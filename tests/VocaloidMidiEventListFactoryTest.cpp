@@ -1,6 +1,8 @@
 ﻿#include "Util.hpp"
 #include "../include/libvsq/VocaloidMidiEventListFactory.hpp"
 #include "../include/libvsq/Sequence.hpp"
+#include "../include/libvsq/NrpnEventBuffer.hpp"
+#include <limits>
 
 #include <iostream> // debug
 
@@ -849,3 +851,109 @@ TEST(VocaloidMidiEventListFactoryTest, testGenerateNRPN)
 		EXPECT_EQ(spec.isMSBOmittingRequired, actual[i].isMSBOmittingRequired);
 	}
 }
+
+static void setupRangeTestTrack(Sequence& sequence)
+{
+	Track& track = sequence.track(0);
+	Event singerEvent(3840, EventType::SINGER);
+	singerEvent.singerHandle = Handle(HandleType::SINGER);
+	track.events().add(singerEvent);
+	for (int i = 1; i <= 8; i++) {
+		Event noteEvent(1920 * i, EventType::NOTE);
+		noteEvent.length(480);
+		noteEvent.note = 60 + i;
+		noteEvent.lyricHandle = Handle(HandleType::LYRIC);
+		noteEvent.lyricHandle.set(0, Lyric("あ", "a"));
+		track.events().add(noteEvent);
+	}
+	track.curve("dyn")->add(1920, 10);
+	track.curve("dyn")->add(5760, 20);
+	track.curve("dyn")->add(9600, 30);
+	track.curve("bre")->add(3840, 40);
+	track.curve("pit")->add(7680, 100);
+}
+
+TEST(VocaloidMidiEventListFactoryTest, testGenerateNRPNWithWholeRange)
+{
+	Sequence sequence("Miku", 1, 4, 4, 500000);
+	setupRangeTestTrack(sequence);
+	sequence.updateTotalTicks();
+	Track const& track = sequence.track(0);
+
+	NrpnEventBuffer expected;
+	VocaloidMidiEventListFactory::generateNRPN(expected, track, sequence.tempoList, sequence.totalTicks(), sequence.preMeasureTicks(), 500);
+	NrpnEventBuffer actual;
+	VocaloidMidiEventListFactory::generateNRPN(actual, track, sequence.tempoList, sequence.totalTicks(), sequence.preMeasureTicks(), 500,
+			0, std::numeric_limits<tick_t>::max());
+
+	ASSERT_EQ(expected.size(), actual.size());
+	for (int i = 0; i < expected.size(); i++) {
+		EXPECT_EQ(expected.get(i).tick, actual.get(i).tick);
+		EXPECT_EQ(expected.get(i).nrpn, actual.get(i).nrpn);
+		EXPECT_EQ(expected.get(i).dataMSB, actual.get(i).dataMSB);
+		EXPECT_EQ(expected.get(i).dataLSB, actual.get(i).dataLSB);
+		EXPECT_EQ(expected.get(i).flags, actual.get(i).flags);
+	}
+}
+
+TEST(VocaloidMidiEventListFactoryTest, testGenerateNRPNWithRange)
+{
+	Sequence sequence("Miku", 1, 4, 4, 500000);
+	setupRangeTestTrack(sequence);
+	sequence.updateTotalTicks();
+	Track const& track = sequence.track(0);
+
+	NrpnEventBuffer actual;
+	VocaloidMidiEventListFactory::generateNRPN(actual, track, sequence.tempoList, sequence.totalTicks(), sequence.preMeasureTicks(), 500,
+			7680, 11520);
+
+	tick_t startTick;
+	int delay;
+	VocaloidMidiEventListFactory::_getActualTickAndDelay(sequence.tempoList, 7680, 500, &startTick, &delay);
+
+	vector<int> notes;
+	vector<int> expressions;
+	bool singer = false;
+	bool breathiness = false;
+	bool pitchBend = false;
+	for (int i = 0; i < actual.size(); i++) {
+		NrpnEventBuffer::Record const& record = actual.get(i);
+		if (record.nrpn == MidiParameterType::CVM_NM_NOTE_NUMBER) {
+			notes.push_back(record.dataMSB);
+		} else if (record.nrpn == MidiParameterType::CC_E_EXPRESSION) {
+			expressions.push_back(record.dataMSB);
+			if (expressions.size() == 1) {
+				EXPECT_EQ(startTick, record.tick);
+			}
+		} else if (record.nrpn == MidiParameterType::CC_BS_VERSION_AND_DEVICE) {
+			// 開始時刻の時点で有効な歌手が, プリセンド無しで開始時刻に出力される
+			EXPECT_FALSE(singer);
+			EXPECT_EQ(7680, record.tick);
+			singer = true;
+		} else if (record.nrpn == MidiParameterType::VCP_VOICE_CHANGE_PARAMETER) {
+			EXPECT_EQ(40, record.dataMSB);
+			EXPECT_EQ(startTick, record.tick);
+			breathiness = true;
+		} else if (record.nrpn == MidiParameterType::PB_PITCH_BEND) {
+			pitchBend = true;
+		}
+	}
+
+	// 範囲内の音符だけが出力される
+	ASSERT_EQ(2, notes.size());
+	EXPECT_EQ(64, notes[0]);
+	EXPECT_EQ(65, notes[1]);
+
+	// 開始時刻の時点での値と, 範囲内のデータ点の値が出力される
+	ASSERT_EQ(2, expressions.size());
+	EXPECT_EQ(20, expressions[0]);
+	EXPECT_EQ(30, expressions[1]);
+
+	EXPECT_TRUE(singer);
+	EXPECT_TRUE(breathiness);
+	EXPECT_TRUE(pitchBend);
+
+	vector<MidiEvent> events = VocaloidMidiEventListFactory::generateMidiEventList(
+		track, sequence.tempoList, sequence.totalTicks(), sequence.preMeasureTicks(), 500, 7680, 11520);
+	EXPECT_EQ(NrpnEvent::convert(actual).size(), events.size());
+}